@@ -43,7 +43,21 @@ ext_modules = [
         name='sqsgenerator.core.base',
         sources=[join(BUILD_DIRECTORY, 'base.pyx'),
                  join(BUILD_DIRECTORY, 'src', 'utils.c'),
-                 join(BUILD_DIRECTORY, 'src', 'rank.c')],
+                 join(BUILD_DIRECTORY, 'src', 'philox.c'),
+                 join(BUILD_DIRECTORY, 'src', 'rank.c'),
+                 join(BUILD_DIRECTORY, 'src', 'rank_context.c'),
+                 join(BUILD_DIRECTORY, 'src', 'arena.c'),
+                 join(BUILD_DIRECTORY, 'src', 'neighbors.c'),
+                 join(BUILD_DIRECTORY, 'src', 'shells.c'),
+                 join(BUILD_DIRECTORY, 'src', 'morton.c')],
+        extra_compile_args=['-fopenmp'] + EXTRA_COMPILE_ARGS,
+        extra_link_args=['-fopenmp'] + EXTRA_LINK_ARGS,
+        include_dirs=INCLUDE_DIRS
+    ),
+    Extension(
+        name='sqsgenerator.core.reader',
+        sources=[join(BUILD_DIRECTORY, 'reader.pyx'),
+                 join(BUILD_DIRECTORY, 'src', 'reader.c')],
         extra_compile_args=EXTRA_COMPILE_ARGS,
         extra_link_args=EXTRA_LINK_ARGS,
         include_dirs=INCLUDE_DIRS
@@ -51,21 +65,33 @@ ext_modules = [
     Extension(
         name='sqsgenerator.core.collection',
         sources=[join(BUILD_DIRECTORY, 'collection.pyx'),
-                 join(BUILD_DIRECTORY, 'src', 'list.c'),
                  join(BUILD_DIRECTORY, 'src', 'conf_list.c'),
                  join(BUILD_DIRECTORY, 'src', 'conf_array.c'),
                  join(BUILD_DIRECTORY, 'src', 'conf_collection.c'),
+                 join(BUILD_DIRECTORY, 'src', 'conf_counter.c'),
+                 join(BUILD_DIRECTORY, 'src', 'conf_threads.c'),
+                 join(BUILD_DIRECTORY, 'src', 'conf_hash.c'),
+                 join(BUILD_DIRECTORY, 'src', 'conf_heap.c'),
+                 join(BUILD_DIRECTORY, 'src', 'conf_record.c'),
+                 join(BUILD_DIRECTORY, 'src', 'conf_store.c'),
+                 join(BUILD_DIRECTORY, 'src', 'conf_snapshot.c'),
                  join(BUILD_DIRECTORY, 'src', 'rank.c'),
-                 join(BUILD_DIRECTORY, 'src', 'utils.c')],
-        extra_compile_args=EXTRA_COMPILE_ARGS,
-        extra_link_args=EXTRA_LINK_ARGS,
+                 join(BUILD_DIRECTORY, 'src', 'rank_context.c'),
+                 join(BUILD_DIRECTORY, 'src', 'utils.c'),
+                 join(BUILD_DIRECTORY, 'src', 'philox.c')],
+        extra_compile_args=['-fopenmp'] + EXTRA_COMPILE_ARGS,
+        extra_link_args=['-fopenmp'] + EXTRA_LINK_ARGS,
         include_dirs=INCLUDE_DIRS
     ),
     Extension(
         name='sqsgenerator.core.sqs',
         sources=[join(BUILD_DIRECTORY, 'sqs.pyx'),
                  join(BUILD_DIRECTORY, 'src', 'utils.c'),
-                 join(BUILD_DIRECTORY, 'src', 'rank.c')
+                 join(BUILD_DIRECTORY, 'src', 'philox.c'),
+                 join(BUILD_DIRECTORY, 'src', 'rank.c'),
+                 join(BUILD_DIRECTORY, 'src', 'rank_context.c'),
+                 join(BUILD_DIRECTORY, 'src', 'binary.c'),
+                 join(BUILD_DIRECTORY, 'src', 'arena.c')
                  ],
         extra_compile_args=['-fopenmp'] + EXTRA_COMPILE_ARGS,
         extra_link_args=['-fopenmp'] + EXTRA_LINK_ARGS,
@@ -75,7 +101,10 @@ Extension(
         name='sqsgenerator.core.dosqs',
         sources=[join(BUILD_DIRECTORY, 'dosqs.pyx'),
                  join(BUILD_DIRECTORY, 'src', 'utils.c'),
-                 join(BUILD_DIRECTORY, 'src', 'rank.c')
+                 join(BUILD_DIRECTORY, 'src', 'philox.c'),
+                 join(BUILD_DIRECTORY, 'src', 'rank.c'),
+                 join(BUILD_DIRECTORY, 'src', 'rank_context.c'),
+                 join(BUILD_DIRECTORY, 'src', 'arena.c')
                  ],
         extra_compile_args=['-fopenmp'] + EXTRA_COMPILE_ARGS,
         extra_link_args=['-fopenmp'] + EXTRA_LINK_ARGS,
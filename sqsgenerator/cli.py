@@ -4,15 +4,15 @@ sqsgenerator
 
 Usage:
   sqsgenerator sqs <structure> <supercellx> <supercelly> <supercellz> [<composition>| --lattice=<SPECIES>...]
-  [--verbosity=<VERBOSITY> --weights=<WEIGHTS> --output=<FILE> --iterations=<ITERATIONS> --parallel --objective=<OBJECTIVE> --format=<FORMAT>]
+  [--verbosity=<VERBOSITY> --weights=<WEIGHTS> --output=<FILE> --iterations=<ITERATIONS> --parallel --objective=<OBJECTIVE> --format=<FORMAT> --degeneracy --ranked --memory=<MEMORY> --seed=<SEED> --cache=<DIR> --reorder --low-memory --plan --timing]
   sqsgenerator dosqs <structure> <supercellx> <supercelly> <supercellz> [<composition>| --lattice=<SPECIES>...]
-  [--verbosity=<VERBOSITY> --weights=<WEIGHTS> --output=<FILE> --iterations=<ITERATIONS> --parallel --anisotropy=<ANISOTROPY> --format=<FORMAT>]
-  sqsgenerator alpha sqs <structure> [--weights=<WEIGHTS> --verbosity=<VERBOSITY> --sublattice=<SUBLATTICE>...]
-  sqsgenerator alpha dosqs <structure> [--weights=<WEIGHTS> --verbosity=<VERBOSITY> --anisotropy=<ANISOTROPY> --sublattice=<SUBLATTICE>...]
+  [--verbosity=<VERBOSITY> --weights=<WEIGHTS> --output=<FILE> --iterations=<ITERATIONS> --parallel --anisotropy=<ANISOTROPY> --format=<FORMAT> --degeneracy --ranked --memory=<MEMORY> --seed=<SEED> --cache=<DIR> --reorder --low-memory --plan --timing]
+  sqsgenerator alpha sqs <structure> [--weights=<WEIGHTS> --verbosity=<VERBOSITY> --sublattice=<SUBLATTICE>... --timing]
+  sqsgenerator alpha dosqs <structure> [--weights=<WEIGHTS> --verbosity=<VERBOSITY> --anisotropy=<ANISOTROPY> --sublattice=<SUBLATTICE>... --timing]
   sqsgenerator --help
   sqsgenerator --version
 
-<structure>              The POSCAR, cif, cssr or Exciting input xml file which contains the structural information
+<structure>              The POSCAR, extended xyz, cif, cssr or Exciting input xml file which contains the structural information
 <supercellx>             The amount of unitcells to be stacked into x direction
 <supercelly>             The amount of unitcells to be stacked into y direction
 <supercellz>             The amount of unitcells to be stacked into z direction
@@ -35,6 +35,38 @@ Options:
 --parallel, -P                   Flag for either making the computation parallel or not. Since this project is currently
                                  under development use this flag preferably with "-I all" to get optimal performance.
 
+--degeneracy, -D                 Only count the structures which reach the best objective instead of storing all of them.
+                                 Memory stays bounded also for highly degenerate cells. Only the number of structures
+                                 given with "--output" is written (the lexicographically first ones, 10 for "all").
+                                 Can only be used with "-I all"
+
+--ranked, -R                     Write the best distinct structures found, ranked by their objective, instead of only
+                                 those which reach the best objective. The number of structures is given with
+                                 "--output" which must not be "all". Cannot be combined with "--degeneracy"
+
+--memory, -M=<MEMORY>            The memory in megabytes the structures found may occupy before they are moved to a
+                                 temporary file. Only matters if many structures are stored, e.g. with "-O all". The
+                                 archive is then written one structure after the other. [default: 4096]
+
+--seed=<SEED>                    Seed of the random number generator. A run is reproduced by the same seed and the same
+                                 input, on any number of threads. A random seed is chosen if omitted, it is printed
+                                 with the iteration input unless all configurations are enumerated
+
+--cache=<DIR>                    Directory of the geometry cache. The pairs and shells of a structure are stored there
+                                 and reused by later runs on the same structure and supercell, whatever the composition
+
+--reorder                        Number the sites along a space filling curve internally, neighbors in space are then
+                                 close in memory. Speeds up big cells, the structures are written in the input order
+
+--low-memory                     Keep only the shell id of every neighbor pair instead of the atoms x atoms matrices.
+                                 The kernels visit the neighbor pairs only, use it for cells which do not fit in memory
+
+--plan                           Print the projected peak memory of the run, with and without --low-memory, and exit
+                                 without iterating
+
+--timing                         Print the wall time of the imports, the option parsing, the setup of the iterators,
+                                 the iterations and the output at the end of the run
+
 --lattice, -L=<SPECIES>          Specify the sublattice/s on which the sqsgen should run. At first specify the
                                  sublattice species followed by the compositions. For example to place Tantalum carbide
                                  on the nitrogen sites of a boron nitride system use N=Ta:0.8,C:0.2. To replace a specie
@@ -81,34 +113,47 @@ Options:
 --version                        Displays the version of sqsgen
 
 """
-import numpy as np
+from time import perf_counter
+_IMPORT_START = perf_counter()
+from collections.abc import Mapping
 
-
-from pymatgen import Structure
-from pymatgen.io.vasp import Poscar
+# numpy, pymatgen and the iterators are imported where they are needed, --help and short runs must start fast
 from sqsgenerator.utils.docopt import docopt
-from sqsgenerator.utils import write_message, unicode_alpha, get_superscript, colored, DEBUG, unicode_capital_sigma
+from sqsgenerator.utils import write_message, unicode_alpha, get_superscript, colored, DEBUG, unicode_capital_sigma, TIMING
 from sqsgenerator.utils.optionparser import parse_options
+TIMING.record('import', perf_counter() - _IMPORT_START)
 
 
 def main():
-    options = docopt(__doc__, version=__VERSION__)
-    options = parse_options(options)
+    with TIMING.phase('options'):
+        options = docopt(__doc__, version=__VERSION__)
+        options = parse_options(options)
     if options['alpha']:
         if options['sublattice']:
             for s in options['sublattice']:
                 calculate_alpha(options, s)
     else:
-        structure = options['structure']
-        structure.make_supercell([options[k] for k in ['supercellx', 'supercelly', 'supercellz']])
+        with TIMING.phase('supercell'):
+            from sqsgenerator.core.base import make_supercell
+            options['supercell'] = tuple(options[k] for k in ['supercellx', 'supercelly', 'supercellz'])
+            options['structure'] = make_supercell(options['structure'], options['supercell'])
+
+        if options.get('plan'):
+            print_memory_plan(options)
+            if options.get('timing'):
+                print(TIMING.report())
+            return
 
         if options['lattice']:
             structures = sublattice_iterations(options)
         else:
             structures = default_iterations(options)
 
-        fname = '{x}x{y}x{z}'.format(x=options['supercellx'], y=options['supercelly'], z=options['supercellz'])
-        write_structures(structures, fname, options['format'])
+        with TIMING.phase('output'):
+            fname = '{x}x{y}x{z}'.format(x=options['supercellx'], y=options['supercelly'], z=options['supercellz'])
+            write_structures(structures, fname, options['format'])
+    if options.get('timing'):
+        print(TIMING.report())
 
 
 def calculate_alpha(options, structure):
@@ -125,19 +170,76 @@ def calculate_alpha(options, structure):
             )
         ) / atoms
     if options['sqs']:
-        from sqsgenerator.core.sqs import SqsIterator
-        iterator = SqsIterator(structure, mole_fractions, options['weights'], verbosity=options['verbosity'])
-        alpha = iterator.calculate_alpha()
+        with TIMING.phase('setup'):
+            from sqsgenerator.core.sqs import SqsIterator
+            iterator = SqsIterator(structure, mole_fractions, options['weights'], verbosity=options['verbosity'])
+        with TIMING.phase('alpha'):
+            alpha = iterator.calculate_alpha()
     elif options['dosqs']:
-        from sqsgenerator.core.dosqs import DosqsIterator
-        iterator = DosqsIterator(structure, mole_fractions, options['weights'], verbosity=options['verbosity'])
+        with TIMING.phase('setup'):
+            from sqsgenerator.core.dosqs import DosqsIterator
+            iterator = DosqsIterator(structure, mole_fractions, options['weights'], verbosity=options['verbosity'])
         main_sum_weight, anisotropy_weights = options['anisotropy']
-        alpha = iterator.calculate_alpha(main_sum_weight, anisotropy_weights)
+        with TIMING.phase('alpha'):
+            alpha = iterator.calculate_alpha(main_sum_weight, anisotropy_weights)
     else:
         write_message('An unexpected error occurred')
     print_result(options, alpha, options['verbosity'])
 
-def do_sqs_iterations(structure, mole_fractions, weights, iterations=10000, prefix='', verbosity=0, parallel=True, output_structures=10, objective=0.0):
+def print_memory_plan(options):
+    """
+    Prints the projected memory of the run on the structure, or on every sublattice. The geometries are built in the
+    low memory mode, the dense matrices are projected but never allocated
+    """
+    import multiprocessing
+    from sqsgenerator.core.base import Geometry, plan_memory, DEFAULT_MEMORY_BUDGET
+    from sqsgenerator.core.reader import as_cell
+    weights = options['weights']
+    shells = max([len(weights)] + list(weights.keys()))
+    mode = 'sqs' if options['sqs'] else 'dosqs'
+    threads = multiprocessing.cpu_count() if options['parallel'] else 1
+    memory_budget = options.get('memory') or DEFAULT_MEMORY_BUDGET
+    low_memory = options.get('low-memory', False)
+
+    cell = as_cell(options['structure'])
+    if options['lattice']:
+        symbols = cell.site_symbols
+        runs = [('{0} => '.format(sublattice), cell.select([i for i, symbol in enumerate(symbols) if symbol == sublattice]), None, mole_fractions)
+                for sublattice, mole_fractions in options['lattice'].items()]
+    else:
+        runs = [('', cell, options.get('supercell'), options['composition'])]
+
+    mib = 1024.0 ** 2
+    for prefix, run_cell, supercell, mole_fractions in runs:
+        with TIMING.phase('setup'):
+            geometry = Geometry(run_cell, shells, supercell=supercell, cache=options.get('cache'), low_memory=True)
+        shell_count = min(len(geometry.shell_neighbors), len(weights))
+        plans = {flag: plan_memory(geometry, len(mole_fractions), shell_count, mode=mode, low_memory=flag, threads=threads,
+                                   output_structures=options['output'], memory_budget=memory_budget) for flag in (False, True)}
+        plan = plans[low_memory]
+        print('{0}Projected memory of the {1} run on {2} atoms{3}:'.format(prefix, mode, len(run_cell), ' (low memory)' if low_memory else ''))
+        for name, size in plan.items():
+            if name != 'peak':
+                print('{0}  {1:<18}{2:12.1f} MiB'.format(prefix, name, size / mib))
+        print(colored('{0}  {1:<18}{2:12.1f} MiB'.format(prefix, 'peak', plan['peak'] / mib), color='magenta'))
+        print('{0}  The peak is {1:.1f} MiB {2}'.format(prefix, plans[not low_memory]['peak'] / mib, 'without --low-memory' if low_memory else 'with --low-memory'))
+
+
+def iterator_kwargs(options):
+    """
+    Collects the keyword arguments of the iterators from the command line options, an option which is not given is
+    left to the default of the iterator
+
+    Returns:
+        dict: The keyword arguments
+    """
+    kwargs = dict(memory_budget=options.get('memory'), seed=options.get('seed'), supercell=options.get('supercell'),
+                  geometry_cache=options.get('cache'), reorder=options.get('reorder', False),
+                  low_memory=options.get('low-memory', False))
+    return {key: value for key, value in kwargs.items() if value is not None}
+
+
+def do_sqs_iterations(structure, mole_fractions, weights, iterations=10000, prefix='', verbosity=0, parallel=True, output_structures=10, objective=0.0, degeneracy=False, ranked=False, iterator_options=None):
     """
     Performs a the iteration by generating random arrangements of the atoms.
 
@@ -155,6 +257,9 @@ def do_sqs_iterations(structure, mole_fractions, weights, iterations=10000, pref
         weights (dict): The weights for the individual shells as described in :func:`core.calculate_matrix`
         iterations (float): The number of iterations to be done (default: 10000)
         parallel (bool): A flag for indicating parallel computation
+        degeneracy (bool): Count the structures with the best objective instead of storing them
+        ranked (bool): Keep the best distinct structures ranked by objective instead of the ties of the best one
+        iterator_options (dict): Further keyword arguments of the iterator, as collected by :func:`iterator_kwargs`
         prefix (str): A string which is put before any output of this method. Intended usage is to mark sublattice
             generations
 
@@ -170,21 +275,29 @@ def do_sqs_iterations(structure, mole_fractions, weights, iterations=10000, pref
           "{3}Weighting: {2}\n"
           "{3}====================".format(iterations, mole_fractions, weights, prefix))
 
-    if not parallel:
-        from sqsgenerator.core.sqs import SqsIterator
-        iterator = SqsIterator(structure, mole_fractions, weights, verbosity=verbosity)
-    else:
-        from sqsgenerator.core.sqs import ParallelSqsIterator
-        iterator = ParallelSqsIterator(structure, mole_fractions, weights, verbosity=verbosity)
+    kwargs = iterator_options or {}
+    with TIMING.phase('setup'):
+        if not parallel:
+            from sqsgenerator.core.sqs import SqsIterator
+            iterator = SqsIterator(structure, mole_fractions, weights, verbosity=verbosity, **kwargs)
+        else:
+            from sqsgenerator.core.sqs import ParallelSqsIterator
+            iterator = ParallelSqsIterator(structure, mole_fractions, weights, verbosity=verbosity, **kwargs)
+    if iterations != 'all':
+        # An exhaustive enumeration draws no random numbers
+        print("{1}Seed: {0}".format(iterator.seed, prefix))
 
-    structures, decmp, iter_, cycle_time = iterator.iteration(iterations=iterations, output_structures=output_structures, objective=objective)
+    with TIMING.phase('iteration'):
+        structures, decmp, iter_, cycle_time = iterator.iteration(iterations=iterations, output_structures=output_structures, objective=objective, degeneracy=degeneracy, ranked=ranked)
 
     print("{1}Needed {0:.2f} microsec per permutation".format(cycle_time * 1e6, prefix))
+    if degeneracy:
+        print("{1}Degeneracy of the best objective: {0}".format(iterator.degeneracy, prefix))
     return structures, decmp, iter_
 
 
 def do_dosqs_iterations(structure, mole_fractions, weights, sum_weight, anisotropic_weights, iterations=10000,
-                        prefix='', verbosity=0, parallel=False, output_structures=10):
+                        prefix='', verbosity=0, parallel=False, output_structures=10, degeneracy=False, ranked=False, iterator_options=None):
     header = """
     {prefix}Direction optimized SQS Iteration input:
     {prefix}========================================
@@ -207,15 +320,23 @@ def do_dosqs_iterations(structure, mole_fractions, weights, sum_weight, anisotro
                unicode_alpha=unicode_alpha,
                unicode_capital_sigma=unicode_capital_sigma)
     print(header)
-    if not parallel:
-        from sqsgenerator.core.dosqs import DosqsIterator
-        iterator = DosqsIterator(structure, mole_fractions, weights, verbosity=verbosity)
-    else:
-        from sqsgenerator.core.dosqs import ParallelDosqsIterator
-        iterator = ParallelDosqsIterator(structure, mole_fractions, weights, verbosity=verbosity)
-
-    structures, decmp, iter_, cycle_time = iterator.iteration(sum_weight, anisotropic_weights, iterations=iterations, output_structures=output_structures)
+    kwargs = iterator_options or {}
+    with TIMING.phase('setup'):
+        if not parallel:
+            from sqsgenerator.core.dosqs import DosqsIterator
+            iterator = DosqsIterator(structure, mole_fractions, weights, verbosity=verbosity, **kwargs)
+        else:
+            from sqsgenerator.core.dosqs import ParallelDosqsIterator
+            iterator = ParallelDosqsIterator(structure, mole_fractions, weights, verbosity=verbosity, **kwargs)
+    if iterations != 'all':
+        # An exhaustive enumeration draws no random numbers
+        print("{1}Seed: {0}".format(iterator.seed, prefix))
+
+    with TIMING.phase('iteration'):
+        structures, decmp, iter_, cycle_time = iterator.iteration(sum_weight, anisotropic_weights, iterations=iterations, output_structures=output_structures, degeneracy=degeneracy, ranked=ranked)
     print("{1}Needed {0:.2f} microsec per permutation".format(cycle_time * 1e6, prefix))
+    if degeneracy:
+        print("{1}Degeneracy of the best objective: {0}".format(iterator.degeneracy, prefix))
     return structures, decmp, iter_
 
 
@@ -228,6 +349,7 @@ def print_result_internal(alpha, verbosity, options, prefix=''):
                                                            value=sum_alpha,
                                                            prefix=prefix,), color='magenta'))
         if 1 <= verbosity < 2:
+            import numpy as np
             shell_alphas = np.sum(np.array(list(alpha.values())),axis=0).tolist()
             for i, shell_alpha in enumerate(shell_alphas):
                 print(colored('{alpha}{prefix}{sub}={value:.14f}'.format(alpha=unicode_alpha,
@@ -275,6 +397,7 @@ def write_structures(structures, file_name, format):
     import zipfile
     from os.path import basename, join
     import os
+    from pymatgen import Structure
     format_name, Writer = format
     file_type = format_name
     if len(structures) > 1:
@@ -308,7 +431,10 @@ def default_iterations(options):
                                                                               verbosity=options['verbosity'],
                                                                               parallel=options['parallel'],
                                                                               output_structures=options['output'],
-                                                                              objective=options['objective'])
+                                                                              objective=options['objective'],
+                                                                              degeneracy=options['degeneracy'],
+                                                                              ranked=options['ranked'],
+                                                                              iterator_options=iterator_kwargs(options))
         print_result(options, decompositions[0], verbosity=options['verbosity'])
     elif options['dosqs']:
         main_sum_weight, anisotropy_weights = options['anisotropy']
@@ -320,31 +446,66 @@ def default_iterations(options):
                                                    iterations=options['iterations'],
                                                    verbosity=options['verbosity'],
                                                    parallel=options['parallel'],
-                                                   output_structures=options['output'])
+                                                   output_structures=options['output'],
+                                                   degeneracy=options['degeneracy'],
+                                                   ranked=options['ranked'],
+                                                   iterator_options=iterator_kwargs(options))
         print_result(options, decompositions[0], verbosity=options['verbosity'])
 
-    result = {}
-    for i, structure in enumerate(structures):
+    return NamedStructures(structures)
+
+
+class NamedStructures(Mapping):
+    """
+    Maps the file names to the structures of an iteration. The structures are not copied, if the iteration created
+    them lazily (e.g. with "-O all") they are written one after the other
+    """
+
+    def __init__(self, structures):
+        self.structures = structures
+
+    @staticmethod
+    def name(index, structure):
         spec_set = tuple(sorted(tuple(set([site.specie.symbol for site in structure.sites]))))
-        name = '{0}-{1}'.format(i, ''.join(spec_set))
-        result[name] = structure
-    return result
+        return '{0}-{1}'.format(index, ''.join(spec_set))
+
+    def __len__(self):
+        return len(self.structures)
+
+    def __iter__(self):
+        for i, structure in enumerate(self.structures):
+            yield self.name(i, structure)
+
+    def __getitem__(self, key):
+        try:
+            index = int(str(key).split('-')[0])
+        except ValueError:
+            raise KeyError(key)
+        if not 0 <= index < len(self.structures) or self.name(index, self.structures[index]) != key:
+            raise KeyError(key)
+        return self.structures[index]
+
+    def items(self):
+        # Every structure is created only once
+        for i, structure in enumerate(self.structures):
+            yield self.name(i, structure), structure
 
 
 def sublattice_iterations(options):
+    from pymatgen import Structure
+    from sqsgenerator.core.reader import as_cell
     sublattice_composition = options['lattice']
-    structure = options['structure']
+    # The sublattices are cut out of the flat arrays, only the remaining sites become pymatgen sites for the output
+    cell = as_cell(options['structure'])
+    symbols = cell.site_symbols
     sublattice_species = list(sublattice_composition.keys())
-    remaining_site_collection = list(filter(lambda site: site.specie.symbol not in sublattice_species, structure.sites))
+    remaining_indices = [i for i, symbol in enumerate(symbols) if symbol not in sublattice_species]
+    remaining_site_collection = list(cell.select(remaining_indices).to_structure().sites) if remaining_indices else []
 
     structures = {}
     sublattice_structure_mapping = {}
     for sublattice, mole_fractions in sublattice_composition.items():
-        sublattice_site_collection = list(filter(lambda site: site.specie.symbol == sublattice, structure.sites))
-        # initial_structure = structure
-        sublattice_structure = Structure(structure.lattice,
-                                         [site.specie for site in sublattice_site_collection],
-                                         [site.frac_coords for site in sublattice_site_collection])
+        sublattice_structure = cell.select([i for i, symbol in enumerate(symbols) if symbol == sublattice])
         if options['sqs']:
             sublattice_structures, decompositions, iterations = do_sqs_iterations(sublattice_structure,
                                                                                   mole_fractions,
@@ -354,7 +515,10 @@ def sublattice_iterations(options):
                                                                                   verbosity=options['verbosity'],
                                                                                   parallel=options['parallel'],
                                                                                   output_structures=options['output'],
-                                                                                  objective=options['objective'])
+                                                                                  objective=options['objective'],
+                                                                                  degeneracy=options['degeneracy'],
+                                                                                  ranked=options['ranked'],
+                                                                                  iterator_options=iterator_kwargs(options))
             print_result(options, decompositions[0], options['verbosity'])
         elif options['dosqs']:
             main_sum_weight, anisotropy_weights = options['anisotropy']
@@ -368,7 +532,10 @@ def sublattice_iterations(options):
                                                                     color='magenta'),
                                                        verbosity=options['verbosity'],
                                                        parallel=options['parallel'],
-                                                       output_structures=options['output'])
+                                                       output_structures=options['output'],
+                                                       degeneracy=options['degeneracy'],
+                                                       ranked=options['ranked'],
+                                                       iterator_options=iterator_kwargs(options))
             print_result(options, decompositions[0], options['verbosity'])
         #Merge both two sublattices
         #map sites to collections
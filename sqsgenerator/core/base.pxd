@@ -1,11 +1,66 @@
-from libc.stdint cimport uint8_t, uint32_t
+from libc.stdint cimport uint8_t, uint32_t, uint64_t
+from sqsgenerator.core.utils cimport rank_context_t, arena_t, neighbor_list_t, shell_table_t
+from sqsgenerator.core.collection cimport ConfigurationCollection
+
+# Chunks of a parallel iteration per thread, shared by the SQS and DOSQS iterators
+cdef Py_ssize_t CHUNKS_PER_THREAD
+# Chunks of a random iteration on any number of threads, chunk k draws from stream k of the seed
+cdef Py_ssize_t RANDOM_CHUNKS
+
+cdef class Geometry:
+    cdef readonly size_t atoms
+    cdef readonly size_t shells
+    cdef readonly bint complete
+    cdef readonly bint reordered
+    cdef readonly bint low_memory
+    cdef readonly tuple supercell
+    cdef readonly str key
+    cdef readonly str path
+
+    cdef double[:, ::1] lattice
+    cdef double[:, ::1] frac_coords
+    cdef uint8_t[:, ::1] shell_number_matrix
+    # Shell id of every pair of the neighbor list, only kept by a low memory geometry
+    cdef uint8_t[::1] pair_shells
+    cdef size_t[:, ::1] shell_site_counts
+    cdef double[:, ::1] directions
+    cdef size_t[::1] order
+    cdef size_t[::1] rank
+
+    cdef dict shell_distance_mapping
+    cdef dict shell_neighbor_mapping
+
+    cdef neighbor_list_t *neighbors
+    cdef shell_table_t *shell_table
+    # The mapping of a cached geometry and the views the neighbor list points into, None if it was built
+    cdef object mapped
+
+    cdef str make_key(self, size_t shells)
+    cdef list cache_sections(self, size_t pairs, size_t shell_count)
+    cdef store(self, str path)
+    cdef bint load(self, str path) except *
+    cdef dict make_neighbors(self, size_t shells)
+    cdef neighbor_list_t* search_neighbors(self, double[:, ::1] lattice, double[:, ::1] frac_coords, double cutoff) except NULL
+    cdef neighbor_list_t* map_neighbors(self, double[:, ::1] lattice, double[:, ::1] frac_coords, double cutoff) except NULL
+    cdef neighbor_list_t* fill_neighbors(self, neighbor_list_t *nl) except NULL
+    cdef make_order(self)
+    cdef dict calculate_shells(self)
+    cdef substitute_distance_matrix(self, uint8_t[:, ::1] dest)
+    cdef classify_pairs(self)
+    cdef dict calculate_shell_neighbors(self)
+    cdef double[:, ::1] make_directions(self)
+    cdef double[:, ::1] get_directions(self)
 
 cdef class BaseIterator:
     cdef readonly size_t atoms
     cdef readonly size_t shell_count
     cdef size_t species_count
     cdef int verbosity
-    cdef readonly int seed
+    cdef readonly uint64_t seed
+    cdef readonly object degeneracy
+    cdef readonly size_t memory_budget
+    cdef readonly bint low_memory
+    cdef readonly ConfigurationCollection collection
 
     cdef uint8_t[::1] configuration
     cdef size_t[::1] composition_hist
@@ -13,9 +68,7 @@ cdef class BaseIterator:
 
     cdef double[:] mole_fractions_view
     cdef double[:] weights_view
-    cdef double[:, :] distance_matrix
     cdef double[:, :] fractional_coordinates
-    cdef double[:, :, :] distance_vectors
 
     cdef dict mole_fractions
     cdef dict weights
@@ -24,16 +77,30 @@ cdef class BaseIterator:
     cdef dict species_index_map
 
     cdef readonly object structure
+    cdef readonly object cell
     cdef readonly object lattice
+    cdef readonly Geometry geometry
 
     cdef uint8_t *shell_number_matrix_ptr
+    # Shell id of every pair of the neighbor list, NULL unless the geometry is a low memory one
+    cdef uint8_t *pair_shells_ptr
     cdef uint8_t *configuration_ptr
     cdef double *weights_ptr
     cdef double *mole_fractions_ptr
     cdef size_t *composition_hist_ptr
+    cdef rank_context_t *rank_context
+    # Borrowed from the geometry
+    cdef neighbor_list_t *neighbors
+    cdef shell_table_t *shell_table
+    cdef arena_t **scratch
+    cdef size_t scratch_threads
 
     cdef make_configuration(self, dict mole_fractions)
+    cdef arena_t **make_scratch(self, size_t threads, size_t size) except NULL
+    cdef ConfigurationCollection make_collection(self, iterations, output_structures, bint degeneracy=*, size_t threads=*, size_t dimension=*, bint ranked=*)
+    cdef report_degeneracy(self, ConfigurationCollection collection)
+    cdef tuple make_results(self, ConfigurationCollection collection, output_structures)
+    cdef result_structure(self, ConfigurationCollection collection, size_t index)
+    cdef result_decomposition(self, ConfigurationCollection collection, size_t index)
     cdef uint8_t[:] configuration_from_structure(self)
-    cdef dict calculate_shell_neighbors(self, double[:, :] matrix)
-    cdef substitute_distance_matrix(self, double[:, :] src, uint8_t[:, :] dest)
-    cdef dict calculate_shells(self, double[:, :] matrix)
\ No newline at end of file
+    cdef double[::1] make_shell_factors(self)
\ No newline at end of file
@@ -2,16 +2,50 @@
 import numpy as np
 cimport numpy as np
 from random import randint
-from pymatgen import Structure
-from pymatgen.util.coord import pbc_shortest_vectors
 from collections import Counter
+from collections.abc import Sequence
+from math import factorial
+import os
+import mmap
+import hashlib
+import tempfile
 cimport sqsgenerator.core.utils as utils
+from sqsgenerator.core.reader import Cell, as_cell
+from sqsgenerator.core.utils cimport neighbor_list_t, neighbor_workspace_t, neighbor_table_t, shell_table_t
+from sqsgenerator.core.collection cimport ConfigurationCollection, ConfigurationCounter, ThreadLocalCollection, ConfigurationHeap
 from libc.math cimport fabs, fmax
+from libc.stdlib cimport calloc, malloc, free
+from libc.string cimport memcpy
 cimport cython
+cimport openmp
+from cython.parallel import parallel, prange
 
 cdef extern from "<stdlib.h>":
     cdef size_t RAND_MAX
 
+# Representatives kept in the counting mode if all output structures are requested
+cdef size_t DEGENERACY_SAMPLES = 10
+# Bytes the records of an unbounded collection may occupy in memory before they are moved to a temporary file
+DEFAULT_MEMORY_BUDGET = 4 * 1024 ** 3
+# Stream of the generator which completes the composition, the iterations use the streams from 0 on
+cdef uint64_t SETUP_STREAM = 0xFFFFFFFFFFFFFFFF
+# Blocks a thread may take from its scratch arena, each one is padded to ARENA_ALIGNMENT
+cdef size_t SCRATCH_BLOCKS = 4
+# Work is handed out dynamically in chunks, more chunks than threads keep the load balanced if a thread is slowed down
+CHUNKS_PER_THREAD = 64
+# A random iteration is always split into this many chunks, a seed draws the same configurations on any number of
+# threads. Enough chunks to balance the load of many threads, each one only sets up its stream once
+RANDOM_CHUNKS = 4096
+# The first neighbor search uses this multiple of the mean site spacing as cutoff, it grows by CUTOFF_GROWTH
+cdef double CUTOFF_START = 1.5
+cdef double CUTOFF_GROWTH = 1.5
+# Relative tolerance of two distances in the same shell
+cdef double SHELL_TOLERANCE = 1e-4
+# Layout of a cached geometry: magic, key digest, counts and cutoff, then the arrays each aligned to CACHE_ALIGNMENT
+CACHE_MAGIC = b'SQSGEO01'
+CACHE_HEADER = 128
+CACHE_ALIGNMENT = 64
+
 cdef bint isclose(double a, double b, double rel_tol=1e-9, double abs_tol=0.0) nogil:
     """
      Checks for floating point numbers for equality
@@ -29,28 +63,633 @@ cdef bint isclose(double a, double b, double rel_tol=1e-9, double abs_tol=0.0) n
     """
     return fabs(a - b) <= fmax(rel_tol * fmax(fabs(a), fabs(b)), abs_tol)
 
+def make_supercell(structure, multiples):
+    """
+    Stacks the unit cell ``multiples[0] x multiples[1] x multiples[2]`` times. Site ``s`` of the unit cell moved by the
+    translation ``(a, b, c)`` becomes site ``s * cells + (a * multiples[1] + b) * multiples[2] + c``, iterators which get
+    the ``supercell`` keyword rely on this order
+
+    Args:
+        structure (Cell or :class:`pymatgen.Structure`): The unit cell
+        multiples (tuple): The number of unit cells along each lattice vector
+
+    Returns:
+        Cell or :class:`pymatgen.Structure`: The supercell, of the same type as ``structure``
+    """
+    if isinstance(structure, Cell):
+        return structure.supercell(multiples)
+    from pymatgen import Structure
+    scale = np.asarray(multiples, dtype=np.float64)
+    translations = np.array(list(np.ndindex(*multiples)), dtype=np.float64)
+    frac_coords = (structure.frac_coords[:, None, :] + translations[None, :, :]) / scale
+    species = [site.specie for site in structure.sites for _ in range(len(translations))]
+    return Structure(structure.lattice.matrix * scale[:, None], species, frac_coords.reshape(-1, 3))
+
+cdef class Geometry:
+    """
+    The pairs, shells and shell ids of a structure. A geometry is built once and shared by reference between any number
+    of iterators, SQS and DOSQS ones, other compositions and repeated runs. Nothing changes it after construction
+
+    With ``reorder`` the sites are relabeled along a Morton curve, neighbors in space then mostly are neighbors in the
+    configuration array. Internal site ``i`` is site ``order[i]`` of the structure and ``rank`` is the inverse
+
+    With ``low_memory`` no ``(atoms, atoms)`` shell matrix is made, the shell id of every pair of the neighbor list is
+    kept instead and the iterators use their sparse kernels
+    """
+
+    def __cinit__(self, structure, size_t shells, supercell=None, cache=None, bint reorder=False, bint low_memory=False):
+        cell = as_cell(structure)
+        self.atoms = len(cell)
+        self.shells = shells
+        self.complete = False
+        self.lattice = np.ascontiguousarray(cell.lattice, dtype=np.float64)
+        self.frac_coords = np.ascontiguousarray(cell.frac_coords, dtype=np.float64)
+        # A supercell from make_supercell derives its pairs from the neighbor table of the unit cell
+        self.supercell = tuple(supercell) if supercell is not None else None
+        if self.supercell is not None and self.atoms % int(np.prod(self.supercell)) != 0:
+            raise ValueError('The structure is not a supercell of {0} unit cells'.format(self.supercell))
+
+        self.reordered = reorder
+        self.low_memory = low_memory
+        self.neighbors = NULL
+        self.shell_table = NULL
+        self.directions = None
+        self.mapped = None
+        self.key = self.make_key(shells)
+        self.path = os.path.join(cache, self.key + '.geometry') if cache is not None else None
+        if self.path is not None and self.load(self.path):
+            self.shell_distance_mapping = {i + 1: self.shell_table.radii[i] for i in range(self.shell_table.count)}
+            self.shell_neighbor_mapping = self.calculate_shell_neighbors()
+            return
+        self.shell_distance_mapping = self.make_neighbors(shells)
+        self.make_order()
+
+        self.shell_site_counts = np.ascontiguousarray(np.zeros((self.atoms, max(self.shell_table.count, 1)), dtype=np.uintp))
+        if self.low_memory:
+            self.pair_shells = np.ascontiguousarray(np.zeros((max(self.neighbors.pairs, 1),), dtype=np.uint8))
+            self.classify_pairs()
+        else:
+            self.shell_number_matrix = np.ascontiguousarray(np.zeros((self.atoms, self.atoms), dtype=np.uint8))
+            self.substitute_distance_matrix(self.shell_number_matrix)
+        self.shell_neighbor_mapping = self.calculate_shell_neighbors()
+        if self.path is not None:
+            self.store(self.path)
+
+    def __dealloc__(self):
+        # A mapped neighbor list points into the file, only the struct itself was allocated
+        if self.mapped is not None:
+            free(self.neighbors)
+        else:
+            utils.neighbor_list_destroy(self.neighbors)
+        utils.shell_table_destroy(self.shell_table)
+
+    cdef str make_key(self, size_t shells):
+        """
+        Hashes everything the geometry is derived from, the lattice, the site coordinates, the supercell multiples, the
+        number of shells and the shell tolerance. The species do not matter, a key is shared by all compositions
+
+        Args:
+            shells (int): The number of shells which are needed
+
+        Returns:
+            str: The hexadecimal SHA-256 digest
+        """
+        digest = hashlib.sha256(CACHE_MAGIC)
+        digest.update(np.asarray(self.lattice).tobytes())
+        digest.update(np.asarray(self.frac_coords).tobytes())
+        digest.update(repr((self.supercell, shells, SHELL_TOLERANCE, self.reordered, self.low_memory)).encode())
+        return digest.hexdigest()
+
+    cdef list cache_sections(self, size_t pairs, size_t shell_count):
+        """
+        The arrays of a cached geometry in the order they are stored
+
+        Returns:
+            list: Tuples of the data type and the number of elements of each array
+        """
+        return [(np.float64, shell_count),
+                (np.uintp, self.atoms + 1),
+                (np.uintp, pairs),
+                (np.float64, pairs),
+                (np.float64, 3 * pairs),
+                (np.float64, 3 * pairs),
+                (np.uint8, pairs if self.low_memory else self.atoms * self.atoms),
+                (np.uintp, self.atoms * max(shell_count, 1)),
+                (np.uintp, self.atoms)]
+
+    cdef store(self, str path):
+        """
+        Writes the geometry to ``path``. The file is written under a temporary name and renamed afterwards, concurrent
+        jobs never see a partial file. A cache which cannot be written is skipped
+
+        Args:
+            path (str): The file of the geometry in the cache directory
+        """
+        cdef size_t pairs = self.neighbors.pairs
+        cdef size_t count = self.shell_table.count
+        arrays = [np.asarray(<double[:max(count, 1)]>self.shell_table.radii)[:count],
+                  np.asarray(<size_t[:self.atoms + 1]>self.neighbors.offsets),
+                  np.asarray(<size_t[:max(pairs, 1)]>self.neighbors.indices)[:pairs],
+                  np.asarray(<double[:max(pairs, 1)]>self.neighbors.distances)[:pairs],
+                  np.asarray(<double[:max(3 * pairs, 1)]>self.neighbors.vectors)[:3 * pairs],
+                  np.asarray(self.get_directions()).ravel()[:3 * pairs],
+                  np.asarray(self.pair_shells)[:pairs] if self.low_memory else np.asarray(self.shell_number_matrix).ravel(),
+                  np.asarray(self.shell_site_counts).ravel(),
+                  np.asarray(self.order)]
+        header = np.array([self.atoms, pairs, count, self.shells, self.complete], dtype=np.uint64).tobytes()
+        header += np.array([self.neighbors.cutoff], dtype=np.float64).tobytes()
+        temporary = None
+        try:
+            handle, temporary = tempfile.mkstemp(dir=os.path.dirname(path), prefix='.geometry-')
+            with os.fdopen(handle, 'wb') as stream:
+                stream.write(CACHE_MAGIC + bytes.fromhex(self.key) + header)
+                stream.write(bytes(CACHE_HEADER - stream.tell()))
+                for array in arrays:
+                    stream.write(array.tobytes())
+                    stream.write(bytes(-stream.tell() % CACHE_ALIGNMENT))
+            os.replace(temporary, path)
+        except OSError:
+            if temporary is not None and os.path.exists(temporary):
+                os.remove(temporary)
+
+    cdef bint load(self, str path) except *:
+        """
+        Maps a cached geometry into memory. The mapping is private, its pages are shared with the file and with other
+        processes which map it until they are written to, which the geometry never does
+
+        Args:
+            path (str): The file of the geometry in the cache directory
+
+        Returns:
+            bool: False if there is no valid file, the geometry must be built then
+        """
+        cdef size_t[::1] offsets, indices
+        cdef double[::1] radii, distances, vectors
+        cdef size_t atoms, pairs, count, offset = CACHE_HEADER
+        try:
+            with open(path, 'rb') as stream:
+                mapped = mmap.mmap(stream.fileno(), 0, access=mmap.ACCESS_COPY)
+        except (OSError, ValueError):
+            return False
+        if len(mapped) < CACHE_HEADER or mapped[:8] != CACHE_MAGIC or mapped[8:40].hex() != self.key:
+            return False
+        atoms, pairs, count, shells, complete = np.frombuffer(mapped, dtype=np.uint64, count=5, offset=40).tolist()
+        if atoms != self.atoms:
+            return False
+        arrays = []
+        for dtype, length in self.cache_sections(pairs, count):
+            if offset + length * np.dtype(dtype).itemsize > len(mapped):
+                return False
+            arrays.append(np.frombuffer(mapped, dtype=dtype, count=length, offset=offset) if length > 0 else np.zeros(0, dtype=dtype))
+            offset += length * np.dtype(dtype).itemsize
+            offset += -offset % CACHE_ALIGNMENT
+
+        # Empty arrays are padded to one element, a view needs at least one
+        radii, offsets, indices, distances, vectors = [np.concatenate([array, np.zeros(1, dtype=array.dtype)]) if len(array) == 0 else array for array in arrays[:5]]
+        self.neighbors = <neighbor_list_t*>calloc(1, sizeof(neighbor_list_t))
+        self.shell_table = <shell_table_t*>calloc(1, sizeof(shell_table_t))
+        if self.shell_table:
+            self.shell_table.radii = <double*>malloc(sizeof(double) * max(count, 1))
+        if not self.neighbors or not self.shell_table or not self.shell_table.radii:
+            raise MemoryError
+        memcpy(self.shell_table.radii, &radii[0], sizeof(double) * count)
+        self.shell_table.count = count
+        self.shell_table.rel_tol = SHELL_TOLERANCE
+        self.neighbors.atoms = atoms
+        self.neighbors.pairs = pairs
+        self.neighbors.cutoff = np.frombuffer(mapped, dtype=np.float64, count=1, offset=80)[0]
+        self.neighbors.offsets = &offsets[0]
+        self.neighbors.indices = &indices[0]
+        self.neighbors.distances = &distances[0]
+        self.neighbors.vectors = &vectors[0]
+        self.mapped = (mapped, offsets, indices, distances, vectors)
+        self.shells = shells
+        self.complete = complete
+        self.directions = arrays[5].reshape((pairs, 3)) if pairs > 0 else np.zeros((1, 3))
+        if self.low_memory:
+            self.pair_shells = arrays[6] if pairs > 0 else np.zeros(1, dtype=np.uint8)
+        else:
+            self.shell_number_matrix = arrays[6].reshape((atoms, atoms))
+        self.shell_site_counts = arrays[7].reshape((atoms, max(count, 1)))
+        self.order = arrays[8]
+        self.rank = np.ascontiguousarray(np.argsort(arrays[8]).astype(np.uintp))
+        return True
+
+    cdef dict make_neighbors(self, size_t shells):
+        """
+        Finds the pairs of sites within a cutoff which encloses the first shells of the cell. The cutoff starts
+        at a multiple of the mean site spacing and grows until the shell after the last requested one is reached as
+        well, or until it covers every pair of the cell. Shells which might be incomplete are dropped
+
+        Args:
+            shells (int): The number of shells which are needed
+
+        Returns:
+            dict: The shell radii as returned by :func:`calculate_shells`
+        """
+        cdef double[:, ::1] lattice = self.lattice
+        cdef double[:, ::1] frac_coords = self.frac_coords
+        # No minimum image is longer than half the sum of the lattice vectors
+        cdef double bound = 0.5 * np.linalg.norm(lattice, axis=1).sum() * (1.0 + 1e-6)
+        cdef double cutoff = CUTOFF_START * (fabs(np.linalg.det(lattice)) / self.atoms) ** (1.0 / 3.0)
+        cdef dict shell_dict
+
+        while True:
+            cutoff = min(cutoff, bound)
+            utils.neighbor_list_destroy(self.neighbors)
+            self.neighbors = NULL
+            if self.supercell is None:
+                self.neighbors = self.search_neighbors(lattice, frac_coords, cutoff)
+            else:
+                self.neighbors = self.map_neighbors(lattice, frac_coords, cutoff)
+            shell_dict = self.calculate_shells()
+            if cutoff >= bound:
+                self.complete = True
+                return shell_dict
+            if len(shell_dict) > shells:
+                utils.shell_table_truncate(self.shell_table, shells)
+                return {shell: distance for shell, distance in shell_dict.items() if shell <= shells}
+            cutoff *= CUTOFF_GROWTH
+
+    cdef neighbor_list_t* search_neighbors(self, double[:, ::1] lattice, double[:, ::1] frac_coords, double cutoff) except NULL:
+        """
+        Builds the neighbor list of the cell with the native cell list
+
+        Args:
+            lattice (:class:`numpy.ndarray`): The lattice vectors as rows
+            frac_coords (:class:`numpy.ndarray`): The fractional coordinates of the sites
+            cutoff (float): The largest distance of a pair
+
+        Returns:
+            A pointer to the neighbor list, the geometry owns it
+        """
+        cdef neighbor_list_t *nl = utils.neighbor_list_init(&lattice[0, 0], &frac_coords[0, 0], self.atoms, cutoff)
+
+        if not nl:
+            raise MemoryError
+        return self.fill_neighbors(nl)
+
+    cdef neighbor_list_t* fill_neighbors(self, neighbor_list_t *nl) except NULL:
+        """
+        Runs both passes over the cells of a neighbor list in parallel, every thread has its own workspace. The list is
+        destroyed if it cannot be filled
+
+        Args:
+            nl: The neighbor list as returned by the native init functions
+
+        Returns:
+            A pointer to the neighbor list, the geometry owns it
+        """
+        cdef int thread_id
+        cdef int threads = openmp.omp_get_max_threads()
+        cdef Py_ssize_t cell
+        cdef Py_ssize_t cells
+        cdef size_t i = 0
+        cdef bint allocated = False
+        cdef neighbor_workspace_t **workspaces
+
+        cells = utils.neighbor_list_cells(nl)
+        workspaces = <neighbor_workspace_t**>calloc(threads, sizeof(neighbor_workspace_t*))
+        if workspaces:
+            for i in range(threads):
+                workspaces[i] = utils.neighbor_workspace_init(self.atoms)
+                if not workspaces[i]:
+                    break
+            else:
+                with nogil, parallel(num_threads=threads):
+                    thread_id = openmp.omp_get_thread_num()
+                    for cell in prange(cells, schedule='dynamic'):
+                        utils.neighbor_list_count(nl, cell, workspaces[thread_id])
+                allocated = utils.neighbor_list_allocate(nl)
+                if allocated:
+                    with nogil, parallel(num_threads=threads):
+                        thread_id = openmp.omp_get_thread_num()
+                        for cell in prange(cells, schedule='dynamic'):
+                            utils.neighbor_list_fill(nl, cell, workspaces[thread_id])
+            for i in range(threads):
+                utils.neighbor_workspace_destroy(workspaces[i])
+            free(workspaces)
+        if not allocated:
+            utils.neighbor_list_destroy(nl)
+            raise MemoryError
+        return nl
+
+    cdef neighbor_list_t* map_neighbors(self, double[:, ::1] lattice, double[:, ::1] frac_coords, double cutoff) except NULL:
+        """
+        Builds the neighbor list of a supercell created by :func:`make_supercell`. Only the unit cell is searched, every
+        pair of the supercell is a pair of the unit cell moved by a translation of the supercell
+
+        Args:
+            lattice (:class:`numpy.ndarray`): The lattice vectors of the supercell as rows
+            frac_coords (:class:`numpy.ndarray`): The fractional coordinates of the supercell sites
+            cutoff (float): The largest distance of a pair
+
+        Returns:
+            A pointer to the neighbor list, the geometry owns it
+        """
+        cdef size_t[::1] multiples = np.ascontiguousarray(self.supercell, dtype=np.uintp)
+        cdef size_t cells = multiples[0] * multiples[1] * multiples[2]
+        cdef double[:, ::1] unit_lattice = np.ascontiguousarray(np.asarray(lattice) / np.asarray(multiples, dtype=np.float64)[:, None])
+        cdef double[:, ::1] unit_frac_coords = np.ascontiguousarray(np.asarray(frac_coords)[::cells] * np.asarray(multiples, dtype=np.float64))
+        cdef neighbor_table_t *table = utils.neighbor_table_init(&unit_lattice[0, 0], &unit_frac_coords[0, 0], self.atoms // cells, cutoff)
+        cdef neighbor_list_t *nl
+
+        if not table:
+            raise MemoryError
+        nl = utils.neighbor_list_supercell(table, &multiples[0])
+        if not nl:
+            utils.neighbor_table_destroy(table)
+            raise MemoryError
+        return self.fill_neighbors(nl)
+
+    cdef make_order(self):
+        """
+        Computes the site order and relabels the neighbor list if the geometry is reordered, otherwise the order is the
+        identity. The shells are found before, they do not depend on the labels
+        """
+        cdef neighbor_list_t *nl
+        self.order = np.arange(self.atoms, dtype=np.uintp)
+        if self.reordered and self.atoms > 0:
+            utils.morton_order(&self.frac_coords[0, 0], self.atoms, &self.order[0])
+        self.rank = np.ascontiguousarray(np.argsort(self.order).astype(np.uintp))
+        if not self.reordered or self.atoms == 0:
+            return
+        nl = utils.neighbor_list_reorder(self.neighbors, &self.order[0], &self.rank[0])
+        if not nl:
+            raise MemoryError
+        utils.neighbor_list_destroy(self.neighbors)
+        self.neighbors = nl
+
+    cdef dict calculate_shells(self):
+        """
+        Determines the shells of the neighbor list with the native shell table. The distances of the symmetry distinct
+        sites are sorted and clustered, for a supercell these are the sites of the first unit cell, otherwise all sites
+
+        Note:
+            The shell index starts with 1 not with 0
+
+        Returns:
+            dict: A dictionary where the key indicates the shell number , and the value the corresponding shell radius.
+                The dictionary has the following form::
+
+                    shell_dict = {
+                        1: 2.943,
+                        2: 4.563,
+                        3: 6.873,
+                        4: 7.345
+                    }
+        """
+        cdef size_t cells = 1 if self.supercell is None else int(np.prod(self.supercell))
+        cdef size_t[::1] rows = np.ascontiguousarray(np.arange(0, self.atoms, cells, dtype=np.uintp))
+        cdef size_t i = 0
+
+        utils.shell_table_destroy(self.shell_table)
+        self.shell_table = utils.shell_table_init(self.neighbors, &rows[0], rows.shape[0], SHELL_TOLERANCE)
+        if not self.shell_table:
+            raise MemoryError
+        return {i + 1: self.shell_table.radii[i] for i in range(self.shell_table.count)}
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    cdef substitute_distance_matrix(self, uint8_t[:, ::1] dest):
+        """
+         Internal utility method for writing the shell number of every pair of the neighbor list into ``dest``. Pairs
+         which are not neighbors keep 0. The rows are classified in parallel, the shell neighbor counts of every site
+         are stored in ``shell_site_counts``
+
+         Args:
+             dest (:class:`numpy.ndarray`): The shell number matrix of shape ``(atoms,atoms)``
+         """
+        cdef Py_ssize_t i
+        cdef Py_ssize_t atoms = self.atoms
+        with nogil, parallel(num_threads=openmp.omp_get_max_threads()):
+            for i in prange(atoms, schedule='static'):
+                utils.shell_table_classify(self.shell_table, self.neighbors, i, &dest[i, 0], &self.shell_site_counts[i, 0])
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    cdef classify_pairs(self):
+        """
+        Writes the shell id of every pair of the neighbor list into ``pair_shells``, the sparse counterpart of
+        :func:`substitute_distance_matrix`. The shell neighbor counts are stored in ``shell_site_counts``
+        """
+        cdef Py_ssize_t i
+        cdef Py_ssize_t atoms = self.atoms
+        with nogil, parallel(num_threads=openmp.omp_get_max_threads()):
+            for i in prange(atoms, schedule='static'):
+                utils.shell_table_classify_pairs(self.shell_table, self.neighbors, i, &self.pair_shells[0], &self.shell_site_counts[i, 0])
+
+
+    cdef dict calculate_shell_neighbors(self):
+        """
+         Determines the amount of next neighbors (:math:`M_j`) in each shell from the shell neighbor counts of the first
+         site of the structure
+
+         Returns:
+             dict: A dictionary with shell numbers as keys and the corresponding number of atoms in this shell.
+                 The dictionary is structured in the following fashion::
+
+                     next_neighbors = {
+                         1 : 12
+                         2: 8
+                         3: 6
+                         4: 10
+                     }
+         """
+        cdef size_t shell = 0
+        cdef size_t first = self.rank[0] if self.atoms > 0 else 0
+        return {shell + 1: self.shell_site_counts[first, shell] for shell in range(self.shell_table.count) if self.shell_site_counts[first, shell] > 0}
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    @cython.cdivision(True)
+    cdef double[:, ::1] make_directions(self):
+        """
+        Computes the share :math:`3 r_k^2 / |r|^2` of every direction :math:`k` in the squared length of every pair
+        vector. The DOSQS iterators scale them by the constant factor of the shell
+
+        Returns:
+            :class:`numpy.ndarray`: The shares of shape ``(pairs, 3)``, in the order of the neighbor list
+        """
+        cdef double[:, ::1] directions = np.ascontiguousarray(np.zeros((max(self.neighbors.pairs, 1), 3)))
+        cdef Py_ssize_t p
+        cdef Py_ssize_t pairs = self.neighbors.pairs
+        cdef size_t k = 0
+        cdef double length
+        cdef double *vec
+
+        with nogil, parallel(num_threads=openmp.omp_get_max_threads()):
+            for p in prange(pairs, schedule='static'):
+                vec = &self.neighbors.vectors[3 * p]
+                length = vec[0] * vec[0] + vec[1] * vec[1] + vec[2] * vec[2]
+                for k in range(3):
+                    directions[p, k] = 3.0 * vec[k] * vec[k] / length
+        return directions
+
+    cdef double[:, ::1] get_directions(self):
+        if self.directions is None:
+            self.directions = self.make_directions()
+        return self.directions
+
+    def describes(self, structure, size_t shells):
+        """
+        Checks whether the geometry may be used for an iterator on ``structure`` which needs ``shells`` shells. A
+        geometry which was limited by the size of the cell covers every shell it can
+
+        Args:
+            structure (Cell or :class:`pymatgen.Structure`): The structure of the iterator
+            shells (int): The number of shells the iterator needs
+
+        Returns:
+            bool: True if the geometry can be shared
+        """
+        cell = as_cell(structure)
+        if len(cell) != self.atoms:
+            return False
+        if not np.allclose(cell.lattice, np.asarray(self.lattice)) or not np.allclose(cell.frac_coords, np.asarray(self.frac_coords)):
+            return False
+        return shells <= self.shells or self.complete
+
+    @property
+    def shell_distances(self):
+        """
+        The radius of every shell
+
+        Returns:
+            dict: The shell radii as returned by :func:`calculate_shells`
+        """
+        return dict(self.shell_distance_mapping)
+
+    @property
+    def shell_neighbors(self):
+        """
+        The number of neighbors of the first site in every shell
+
+        Returns:
+            dict: The counts as returned by :func:`calculate_shell_neighbors`
+        """
+        return dict(self.shell_neighbor_mapping)
+
+    @property
+    def shell_numbers(self):
+        """
+        The shell id of every pair, 0 if the sites are no neighbors. The sites are in the internal order. A low memory
+        geometry builds the matrix from its pairs on every access
+
+        Returns:
+            :class:`numpy.ndarray`: A read only view of shape ``(atoms, atoms)``
+        """
+        if self.low_memory:
+            offsets = np.asarray(<size_t[:self.atoms + 1]>self.neighbors.offsets)
+            view = np.zeros((self.atoms, self.atoms), dtype=np.uint8)
+            if self.neighbors.pairs > 0:
+                rows = np.repeat(np.arange(self.atoms), np.diff(offsets.astype(np.int64)))
+                view[rows, np.asarray(<size_t[:self.neighbors.pairs]>self.neighbors.indices)] = np.asarray(self.pair_shells)[:self.neighbors.pairs]
+        else:
+            view = np.asarray(self.shell_number_matrix)
+        view.setflags(write=False)
+        return view
+
+    @property
+    def site_shell_neighbors(self):
+        """
+        The number of neighbors of every site in every shell, row ``i`` holds the counts of site ``i`` of the structure
+        and column ``k`` those of shell ``k + 1``
+
+        Returns:
+            :class:`numpy.ndarray`: An array of shape ``(atoms, shells)``
+        """
+        return np.asarray(self.shell_site_counts)[np.asarray(self.rank), :self.shell_table.count]
+
+    @property
+    def site_order(self):
+        """
+        The site of the structure at every internal position, the identity unless the geometry is reordered
+
+        Returns:
+            :class:`numpy.ndarray`: An array of shape ``(atoms,)``
+        """
+        return np.asarray(self.order).copy()
+
+def plan_memory(Geometry geometry, size_t species_count, size_t shells, mode='sqs', bint low_memory=False, size_t threads=1,
+                output_structures=10, memory_budget=DEFAULT_MEMORY_BUDGET):
+    """
+    Projects the memory of a run on the cell of ``geometry`` without allocating any of it. The pair count is taken from
+    the geometry, which therefore is best built with ``low_memory`` set. The neighbor search comes before the shells are
+    classified and frees its workspaces, the peak is the larger of the two phases
+
+    Args:
+        geometry (Geometry): The geometry of the cell
+        species_count (int): The number of species of the composition, vacancies included
+        shells (int): The number of shells the iterator uses
+        mode (str): Either "sqs" or "dosqs"
+
+    Keyword Args:
+        low_memory (bool): Project the sparse kernels instead of the dense matrices
+        threads (int): The number of threads of the iteration
+        output_structures (int or str): The number of structures to keep or "all"
+        memory_budget (int): Bytes an unbounded collection keeps in memory before it moves to a temporary file
+
+    Returns:
+        dict: The bytes of every array of the run and of the neighbor search, and the "peak"
+    """
+    cdef size_t atoms = geometry.atoms
+    cdef size_t pairs = geometry.neighbors.pairs
+    cdef size_t dimension = 3 if mode == 'dosqs' else 1
+    cdef size_t decomposition = sizeof(double) * shells * species_count * species_count * dimension
+    cdef size_t double_size = sizeof(double), index_size = sizeof(size_t)
+
+    if output_structures == 'all':
+        records = memory_budget
+    else:
+        records = int(output_structures) * (atoms + decomposition + double_size) * max(threads, 1)
+    plan = {
+        'neighbor list': (2 * atoms + 1) * index_size + pairs * (index_size + 4 * double_size) + 3 * atoms * double_size,
+        'shell ids': pairs if low_memory else atoms * atoms,
+        'shell counts': atoms * max(geometry.shell_table.count, 1) * index_size,
+        'site order': 2 * atoms * index_size,
+        'directions': 3 * pairs * double_size if mode == 'dosqs' else 0,
+        'constant factors': (geometry.shell_table.count + 1) * double_size if low_memory else dimension * atoms * atoms * double_size,
+        'collection': records,
+        'scratch': max(threads, 1) * (atoms + decomposition),
+    }
+    # Every thread of the neighbor search has stamps, a touched list, squared distances and vectors for all sites
+    search = plan['neighbor list'] + threads * atoms * (2 * index_size + 4 * double_size)
+    plan['neighbor search'] = search
+    plan['peak'] = max(search, sum(v for k, v in plan.items() if k != 'neighbor search'))
+    return plan
+
 cdef class BaseIterator:
 
     def __cinit__(self, structure, dict mole_fractions, dict weights, verbosity=0, **kwargs):
+        # The iterator works on the flat arrays, a structure read by pymatgen is converted once
         self.structure = structure
-        self.fractional_coordinates = structure.frac_coords
-        self.lattice = structure.lattice
-        self.atoms = len(self.structure.sites)
-        vectors, d2 = pbc_shortest_vectors(self.lattice, self.fractional_coordinates, self.fractional_coordinates, return_d2=True)
-
-        self.distance_matrix = np.sqrt(d2)
-        self.distance_vectors = np.abs(vectors)
+        self.cell = as_cell(structure)
+        self.fractional_coordinates = self.cell.frac_coords
+        self.lattice = self.cell.lattice
+        self.atoms = len(self.cell)
         self.mole_fractions = mole_fractions
         self.weights = weights
 
-        self.shell_distance_mapping = self.calculate_shells(self.distance_matrix)
+        # Only the pairs up to the highest weighted shell are needed. A geometry passed in is shared, not copied
+        shells = max([len(weights)] + list(weights.keys()))
+        geometry = kwargs.get('geometry', None)
+        if geometry is None:
+            geometry = Geometry(self.cell, shells, supercell=kwargs.get('supercell', None), cache=kwargs.get('geometry_cache', None),
+                                reorder=kwargs.get('reorder', False), low_memory=kwargs.get('low_memory', False))
+        elif not geometry.describes(self.cell, shells):
+            raise ValueError('The geometry does not belong to the structure or covers less than {0} shells'.format(shells))
+        self.geometry = geometry
+        self.neighbors = self.geometry.neighbors
+        self.shell_table = self.geometry.shell_table
+        # A low memory geometry has no shell matrix, the kernels walk the pairs of the neighbor list instead
+        self.low_memory = self.geometry.low_memory
+        if not self.low_memory:
+            self.shell_number_matrix = self.geometry.shell_number_matrix
+        self.shell_distance_mapping = dict(self.geometry.shell_distance_mapping)
+        self.shell_neighbor_mapping = dict(self.geometry.shell_neighbor_mapping)
 
         self.configuration = np.ascontiguousarray(np.zeros((self.atoms,), dtype=np.uint8))
-        self.shell_number_matrix = np.ascontiguousarray(np.zeros((self.atoms, self.atoms), dtype=np.uint8))
-
-        self.substitute_distance_matrix(self.distance_matrix, self.shell_number_matrix)
-
-        self.shell_neighbor_mapping = self.calculate_shell_neighbors(self.distance_matrix)
 
         self.shell_count = min(len(self.shell_neighbor_mapping), len(weights))
 
@@ -58,6 +697,10 @@ cdef class BaseIterator:
 
         self.composition_hist = np.zeros((self.species_count), dtype=np.uintp)
 
+        # Every random draw derives from the seed, the same seed reproduces a run on any number of threads
+        seed = kwargs.get('seed', None)
+        self.seed = randint(1, RAND_MAX) if seed is None else seed & 0xFFFFFFFFFFFFFFFF
+
         #Initializes self.mole_fractions_view
         self.make_configuration(mole_fractions)
 
@@ -68,14 +711,144 @@ cdef class BaseIterator:
         #self.dosqs_constant_factor_matrix = self.dosqs_make_constant_factor_matrix()
 
         #self.print_verbose_information(verbosity=verbosity)
-        self.seed = randint(1, RAND_MAX)
+        self.degeneracy = None
+        self.memory_budget = kwargs.get('memory_budget', DEFAULT_MEMORY_BUDGET)
         self.verbosity = verbosity
 
         self.weights_ptr = <double*> &self.weights_view[0]
         self.mole_fractions_ptr = <double*> &self.mole_fractions_view[0]
-        self.shell_number_matrix_ptr = <uint8_t*> &self.shell_number_matrix[0, 0]
+        self.shell_number_matrix_ptr = NULL if self.low_memory else <uint8_t*> &self.shell_number_matrix[0, 0]
+        self.pair_shells_ptr = <uint8_t*> &self.geometry.pair_shells[0] if self.low_memory else NULL
         self.configuration_ptr = <uint8_t*> &self.configuration[0]
         self.composition_hist_ptr = <size_t*> &self.composition_hist[0]
+        # Multinomial tables for ranking/unranking are built once per composition
+        self.rank_context = utils.rank_context_init(self.atoms, self.composition_hist_ptr, self.species_count)
+        self.scratch = NULL
+        self.scratch_threads = 0
+
+    def __dealloc__(self):
+        cdef size_t i = 0
+        utils.rank_context_destroy(self.rank_context)
+        if self.scratch:
+            for i in range(self.scratch_threads):
+                utils.arena_destroy(self.scratch[i])
+            free(self.scratch)
+
+    cdef arena_t **make_scratch(self, size_t threads, size_t size) except NULL:
+        """
+        Provides one arena per thread for the buffers of a parallel region. The arenas are kept by the iterator and
+        reused by later runs, a thread resets its arena when it enters the region.
+
+        Args:
+            threads (int): The number of threads of the region
+            size (int): The bytes a single thread needs, at most SCRATCH_BLOCKS blocks
+
+        Returns:
+            A pointer to an array of at least "threads" arenas
+        """
+        cdef size_t i = 0
+        cdef size_t capacity = size + SCRATCH_BLOCKS * utils.ARENA_ALIGNMENT
+        if self.scratch and self.scratch_threads >= threads and self.scratch[0].capacity >= capacity:
+            return self.scratch
+        if self.scratch:
+            for i in range(self.scratch_threads):
+                utils.arena_destroy(self.scratch[i])
+            free(self.scratch)
+        self.scratch_threads = threads
+        self.scratch = <arena_t**>calloc(threads, sizeof(arena_t*))
+        if not self.scratch:
+            self.scratch_threads = 0
+            raise MemoryError
+        for i in range(threads):
+            self.scratch[i] = utils.arena_init(capacity)
+            if not self.scratch[i]:
+                for i in range(threads):
+                    utils.arena_destroy(self.scratch[i])
+                free(self.scratch)
+                self.scratch = NULL
+                raise MemoryError
+        return self.scratch
+
+    cdef ConfigurationCollection make_collection(self, iterations, output_structures, bint degeneracy=False, size_t threads=1, size_t dimension=1, bint ranked=False):
+        """
+        Creates the container for the results of an iteration
+
+        Args:
+            iterations (int or str): The number of iterations or "all"
+            output_structures (int or str): The number of structures to keep or "all"
+
+        Keyword Args:
+            degeneracy (bool): Count the configurations attaining the best objective instead of storing them. Only a
+                bounded sample of representatives is kept. Requires an exhaustive enumeration
+            threads (int): The number of threads which add to the container, each one gets its own buffer
+            dimension (int): The number of directions of the decomposition
+            ranked (bool): Keep the "output_structures" best distinct configurations, also those which do not reach
+                the best objective. Requires a finite number of output structures
+
+        Returns:
+            ConfigurationCollection: The result container, it is also kept as the "collection" of the iterator
+        """
+        if ranked:
+            if degeneracy:
+                raise ValueError('The degeneracy cannot be counted if the best configurations are ranked')
+            if output_structures == 'all':
+                raise ValueError('Only a finite number of configurations can be ranked')
+            self.collection = ConfigurationHeap(output_structures, self.atoms, self.shell_count, self.species_count,
+                                                dimension=dimension, threads=threads)
+        elif degeneracy:
+            if iterations != 'all':
+                raise ValueError('The degeneracy can only be counted for an exhaustive enumeration (iterations="all")')
+            self.collection = ConfigurationCounter(DEGENERACY_SAMPLES if output_structures == 'all' else output_structures,
+                                                   self.atoms, self.shell_count, self.species_count, dimension=dimension,
+                                                   threads=threads)
+        elif threads > 1:
+            self.collection = ThreadLocalCollection(output_structures if output_structures != 'all' else 0, self.atoms,
+                                                    self.shell_count, self.species_count, dimension=dimension,
+                                                    threads=threads, memory_budget=self.memory_budget)
+        else:
+            self.collection = ConfigurationCollection(output_structures if output_structures != 'all' else 0, self.atoms,
+                                                      self.shell_count, self.species_count, dimension=dimension,
+                                                      memory_budget=self.memory_budget)
+        return self.collection
+
+    def snapshot(self):
+        """
+        Takes a consistent copy of the results of the current (or the last) iteration. Intended to be polled by a
+        monitoring thread while a parallel iteration is running, the iteration is not interrupted.
+
+        Returns:
+            CollectionSnapshot: The copy or None if no iteration was started yet
+        """
+        if self.collection is None:
+            return None
+        return self.collection.snapshot()
+
+    cdef report_degeneracy(self, ConfigurationCollection collection):
+        if isinstance(collection, ConfigurationCounter):
+            self.degeneracy = collection.count()
+            print('Configurations with the best objective: {0}'.format(self.degeneracy))
+
+    cdef tuple make_results(self, ConfigurationCollection collection, output_structures):
+        """
+        Converts the collection into the structures and decompositions returned by an iteration. If all output
+        structures are requested they are created on access only, the results are streamed from the collection (and
+        its file) instead of being converted at once.
+
+        Returns:
+            tuple: The structures and the decompositions, either as lists or as ResultSequence objects
+        """
+        if collection.failed():
+            raise MemoryError('Not all results could be stored for lack of memory')
+        if output_structures == 'all':
+            return ResultSequence(self, collection, False), ResultSequence(self, collection, True)
+        return ([self.result_structure(collection, i) for i in range(collection.size())],
+                [self.result_decomposition(collection, i) for i in range(collection.size())])
+
+    cdef result_structure(self, ConfigurationCollection collection, size_t index):
+        return self.configuration_to_structure(<uint8_t[:self.atoms]>collection.get_configuration(index))
+
+    cdef result_decomposition(self, ConfigurationCollection collection, size_t index):
+        raise NotImplementedError
 
     cdef make_configuration(self, dict mole_fractions):
         """
@@ -96,6 +869,7 @@ cdef class BaseIterator:
         cdef size_t i = 0
         cdef size_t j = 0
         cdef size_t random_species = 0
+        cdef utils.philox_t rng
 
         cdef list conf_list = []
         cdef mole_fraction_view_list = [0.0]*self.species_count
@@ -112,9 +886,10 @@ cdef class BaseIterator:
             conf_list.extend([i]*atoms_per_species)
             corrected_mole_fractions[species] = float(atoms_per_species)
             self.species_index_map[species] = i
+        utils.philox_init(&rng, self.seed, SETUP_STREAM)
         while len(conf_list) < self.atoms:
             #Fill up with random atoms
-            new_atom = utils.rand_int(self.species_count)
+            new_atom = utils.philox_bounded(&rng, self.species_count)
             species, mole_fraction = mole_fraction_item_list[new_atom]
             corrected_mole_fractions[species] = corrected_mole_fractions[species]+1.0
             conf_list.append(new_atom)
@@ -137,109 +912,88 @@ cdef class BaseIterator:
         self.configuration = np.ascontiguousarray(conf_list, dtype=np.uint8)
 
 
-    cdef dict calculate_shells(self, double[:, :] matrix):
+    cdef double[::1] make_shell_factors(self):
         """
-        Determines how many shells are available are available, by counting distinct distance values
-
-        Args:
-            matrix (:class:`numpy.ndarray`): The distance matrix of shape ``(atoms,atoms)``, where the value :math:`a_{ij}`
-                represents the distance between the i-th and the j-th atom.
-
-        Note:
-            The shell index starts with 1 not with 0
+        Computes the constant factor :math:`w_i / (2 M_i N)` of every shell id, the factor of shells without weight and
+        of shell 0 is 0. The tables of the iterators are filled from it without touching the dictionaries again
 
         Returns:
-            dict: A dictionary where the key indicates the shell number , and the value the corresponding shell radius.
-                The dictionary has the following form::
-
-                    shell_dict = {
-                        1: 2.943,
-                        2: 4.563,
-                        3: 6.873,
-                        4: 7.345
-                    }
+            :class:`numpy.ndarray`: The factors indexed by shell id
         """
-        cdef double[:] atoms = matrix[0]
-        cdef double current_number, shell
-        cdef size_t i = 0
-        shells = []
-
-        for i in range(1, self.atoms):
-            current_number = atoms[i]
-            is_class = False
-            for shell in shells:
-                if isclose(shell, current_number, rel_tol=1e-4):
-                    is_class = True
-                    break
-            if not is_class:
-                shells.append(current_number)
-        shells = sorted(shells)
-        shell_dict = {}
-        for i, shell_distance in enumerate(shells):
-            shell_dict[i + 1] = shell_distance
-        return shell_dict
-
-    @cython.boundscheck(False)
-    @cython.wraparound(False)
-    cdef substitute_distance_matrix(self, double[:, :] src, uint8_t[:, :] dest):
+        cdef double[::1] shell_factors = np.zeros((self.shell_table.count + 1,))
+        cdef size_t shell = 0
+        for shell in range(1, self.shell_table.count + 1):
+            if shell in self.weights and shell in self.shell_neighbor_mapping:
+                shell_factors[shell] = self.weights[shell] / (2 * self.shell_neighbor_mapping[shell] * self.atoms)
+        return shell_factors
+
+    def permutation_count(self):
         """
-         Internal utility method for replacing the distance entries in ``matrix`` by the shell number the entry can be mapped
-         to.
+        Computes the exact number of distinct configurations for the current composition
 
-         Args:
-             shell_dict (dict): A dictionary containing the shell radius. For the form of the dictionary see
-                 :func:`core.calculate_shells`
-             matrix (:class:`numpy.ndarray`): The distance matrix, which corresponds to ``shell_dict``
-         """
-        cdef Py_ssize_t i = 0, j = 0
-        cdef int shell
-        cdef double distance
-        for shell, distance in self.shell_distance_mapping.items():
-            for i in range(self.atoms):
-                for j in range(i, self.atoms):
-                    if isclose(src[i,j], distance, rel_tol=1e-4):
-                        dest[i, j] = shell
-                        dest[j, i] = shell
-
-
-    cdef dict calculate_shell_neighbors(self, double[:, :] matrix):
+        Returns:
+            int: The multinomial coefficient ``atoms!/(n_1! n_2! ... n_k!)`` as an arbitrary precision integer
         """
-         Determines the amount of next neighbors (:math:`M_j`) in each shell. By counting distinct values in the distance matrix
-
-         Args:
-             shell_dict (dict): A dictionary containing the shell radius. For the form of the dictionary see
-                 :func:`core.calculate_shells`
-             matrix (:class:`numpy.ndarray`): The distance matrix, which corresponds to ``shell_dict``
-
-         Returns:
-             dict: A dictionary with shell numbers as keys and the corresponding number of atoms in this shell.
-                 The dictionary is structured in the following fashion::
-
-                     next_neighbors = {
-                         1 : 12
-                         2: 8
-                         3: 6
-                         4: 10
-                     }
-         """
-        neighbor_dict = {}
-        neighbor_dict.update(Counter(np.asarray(self.shell_number_matrix[0])))
-        del neighbor_dict[0.0]
-        return neighbor_dict
+        cdef size_t i = 0
+        count = factorial(self.atoms)
+        for i in range(self.species_count):
+            count //= factorial(self.composition_hist[i])
+        return count
 
     cdef uint8_t[:] configuration_from_structure(self):
         cdef size_t species_count = 0
         cdef uint8_t[:] configuration = np.ascontiguousarray(np.zeros((self.atoms), dtype=np.uint8))
         cdef Py_ssize_t i = 0
 
-        for i, site in enumerate(self.structure.sites):
-            configuration[i] = self.species_index_map[site.specie.name]
+        for i, symbol in enumerate(self.cell.site_symbols):
+            configuration[self.geometry.rank[i]] = self.species_index_map[symbol]
 
         return configuration
 
     def configuration_to_structure(self, uint8_t[:] configuration):
+        # The sites are written in the order of the structure, not in the internal one
+        configuration = np.ascontiguousarray(np.asarray(configuration)[np.asarray(self.geometry.rank)])
         index_species_map = {v: k for k, v in self.species_index_map.items()}
         species_list = [index_species_map[configuration[i]] for i in range(self.atoms) if index_species_map[configuration[i]] != '0']
         coord_list = [self.fractional_coordinates[i] for i in range(self.atoms) if index_species_map[configuration[i]] != '0']
-        structure = Structure(self.structure.lattice, species_list, coord_list)
-        return structure
\ No newline at end of file
+        from pymatgen import Structure
+        structure = Structure(self.lattice, species_list, coord_list)
+        return structure
+
+
+cdef class ResultSequence:
+    """
+    Read-only sequence over the results of an iteration. The structure (or the decomposition) of an entry is created
+    when it is accessed, the collection is kept alive as long as the sequence exists.
+    """
+
+    cdef BaseIterator iterator
+    cdef ConfigurationCollection collection
+    cdef bint decomposition
+
+    def __cinit__(self, BaseIterator iterator, ConfigurationCollection collection, bint decomposition):
+        self.iterator = iterator
+        self.collection = collection
+        self.decomposition = decomposition
+
+    def __len__(self):
+        return self.collection.size()
+
+    def __getitem__(self, index):
+        if isinstance(index, slice):
+            return [self[i] for i in range(*index.indices(len(self)))]
+        if index < 0:
+            index += len(self)
+        if not 0 <= index < len(self):
+            raise IndexError('result index out of range')
+        if self.decomposition:
+            return self.iterator.result_decomposition(self.collection, index)
+        return self.iterator.result_structure(self.collection, index)
+
+    def __iter__(self):
+        cdef size_t i = 0
+        for i in range(len(self)):
+            yield self[i]
+
+
+Sequence.register(ResultSequence)
@@ -1,19 +1,74 @@
 
+cimport openmp
 from libc.stdint cimport uint8_t, uint32_t, uint64_t
 
 
+cdef extern from "include/conf_snapshot.h" nogil:
+    ctypedef struct conf_snapshot_t:
+        uint64_t version
+        size_t size
+        size_t atoms
+        size_t alpha_decomp_size
+        double best_objective
+
+    cdef uint8_t* conf_snapshot_get_conf(conf_snapshot_t* s, size_t index) nogil
+    cdef double* conf_snapshot_get_decomp(conf_snapshot_t* s, size_t index) nogil
+    cdef double conf_snapshot_get_objective(conf_snapshot_t* s, size_t index) nogil
+    cdef void conf_snapshot_release(conf_snapshot_t* s) nogil
+
 cdef extern from "include/conf_collection.h" nogil:
     ctypedef struct conf_collection_t:
         size_t size
         double best_objective
 
-    cdef conf_collection_t* conf_collection_init(size_t max_size, size_t atoms, size_t decomp_size) nogil
+    cdef conf_collection_t* conf_collection_init(size_t max_size, size_t atoms, size_t species, size_t decomp_size, size_t budget) nogil
     cdef uint8_t* conf_collection_get_conf(conf_collection_t* c, size_t index) nogil
     cdef double* conf_collection_get_decomp(conf_collection_t* c, size_t index) nogil
     cdef double conf_collection_get_objective(conf_collection_t* c, size_t index) nogil
     cdef bint conf_collection_add(conf_collection_t* c, double objective, uint8_t *conf, double* decomp) nogil
+    cdef bint conf_collection_failed(conf_collection_t* c) nogil
+    cdef conf_snapshot_t* conf_collection_snapshot(conf_collection_t* c) nogil
     cdef void conf_collection_destroy(conf_collection_t* c) nogil
 
+cdef extern from "include/conf_counter.h" nogil:
+    ctypedef struct conf_counter_t:
+        size_t samples
+        double best_objective
+
+    cdef conf_counter_t* conf_counter_init(size_t max_samples, size_t atoms, size_t decomp_size) nogil
+    cdef bint conf_counter_add(conf_counter_t* c, double objective, uint8_t* configuration, double* decomp) nogil
+    cdef void conf_counter_merge(conf_counter_t* c, conf_counter_t* other) nogil
+    cdef char* conf_counter_get_count_str(conf_counter_t* c) nogil
+    cdef uint8_t* conf_counter_get_conf(conf_counter_t* c, size_t index) nogil
+    cdef double* conf_counter_get_decomp(conf_counter_t* c, size_t index) nogil
+    cdef conf_snapshot_t* conf_counters_snapshot(conf_counter_t** counters, size_t count) nogil
+    cdef void conf_counter_destroy(conf_counter_t* c) nogil
+
+cdef extern from "include/conf_heap.h" nogil:
+    ctypedef struct conf_heap_t:
+        size_t size
+        double threshold
+        bint failed
+
+    cdef conf_heap_t* conf_heap_init(size_t max_size, size_t atoms, size_t decomp_size) nogil
+    cdef bint conf_heap_add(conf_heap_t* h, double objective, uint8_t* conf, double* decomp) nogil
+    cdef void conf_heap_merge(conf_heap_t* h, conf_heap_t* other) nogil
+    cdef uint8_t* conf_heap_get_conf(conf_heap_t* h, size_t index) nogil
+    cdef double* conf_heap_get_decomp(conf_heap_t* h, size_t index) nogil
+    cdef double conf_heap_get_objective(conf_heap_t* h, size_t index) nogil
+    cdef conf_snapshot_t* conf_heaps_snapshot(conf_heap_t** heaps, size_t count) nogil
+    cdef void conf_heap_destroy(conf_heap_t* h) nogil
+
+cdef extern from "include/conf_threads.h" nogil:
+    ctypedef struct conf_threads_t
+
+    cdef conf_threads_t* conf_threads_init(size_t threads, size_t max_size, size_t atoms, size_t species, size_t decomp_size, size_t budget) nogil
+    cdef bint conf_threads_add(conf_threads_t* t, size_t thread, double objective, uint8_t* conf, double* decomp) nogil
+    cdef double conf_threads_best_objective(conf_threads_t* t) nogil
+    cdef conf_collection_t* conf_threads_merge(conf_threads_t* t) nogil
+    cdef conf_snapshot_t* conf_threads_snapshot(conf_threads_t* t) nogil
+    cdef void conf_threads_destroy(conf_threads_t* t) nogil
+
 cdef class ConfigurationCollection:
 
     cdef conf_collection_t * _inner;
@@ -23,4 +78,35 @@ cdef class ConfigurationCollection:
     cdef double get_objective(self, size_t index) nogil
     cdef uint8_t *get_configuration(self, size_t index) nogil
     cdef size_t size(self) nogil
-    cdef double best_objective(self) nogil
\ No newline at end of file
+    cdef double best_objective(self) nogil
+    cdef bint failed(self) nogil
+    cdef conf_snapshot_t *make_snapshot(self) nogil
+
+cdef class CollectionSnapshot:
+
+    cdef conf_snapshot_t * _snapshot;
+
+    cdef size_t checked_index(self, index) except? 0
+
+cdef class ConfigurationCounter(ConfigurationCollection):
+
+    cdef size_t threads
+    cdef bint merged
+    cdef conf_counter_t ** _counters
+
+    cdef void merge(self) nogil
+
+cdef class ThreadLocalCollection(ConfigurationCollection):
+
+    cdef conf_threads_t * _threads
+    cdef openmp.omp_lock_t _lock
+
+    cdef bint merge(self) nogil
+
+cdef class ConfigurationHeap(ConfigurationCollection):
+
+    cdef size_t threads
+    cdef bint merged
+    cdef conf_heap_t ** _heaps
+
+    cdef void merge(self) nogil
\ No newline at end of file
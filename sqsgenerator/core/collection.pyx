@@ -1,8 +1,20 @@
+cimport openmp
+from libc.stdlib cimport calloc, free
+
+cdef extern from '<float.h>':
+    cdef double DBL_MAX
+
 
 cdef class ConfigurationCollection:
 
-    def __cinit__(self, size_t max_size, size_t atoms, size_t shell_count, size_t species_count, size_t dimension=1):
-        self._inner = conf_collection_init(max_size, atoms, shell_count * species_count * species_count * dimension)
+    def __cinit__(self, size_t max_size, size_t atoms, size_t shell_count, size_t species_count, size_t dimension=1, size_t memory_budget=0, **kwargs):
+        # Cython runs this for the subclasses too, they keep their records in their own structures
+        if type(self) is not ConfigurationCollection:
+            return
+        # An unbounded collection (max_size 0) moves its records to a temporary file beyond memory_budget bytes, 0 never spills
+        self._inner = conf_collection_init(max_size, atoms, species_count, shell_count * species_count * species_count * dimension, memory_budget)
+        if not self._inner:
+            raise MemoryError
 
     cdef bint add(self, double objective, uint8_t *configuration, double *decomposition) nogil:
         return conf_collection_add(self._inner, objective, configuration, decomposition)
@@ -22,5 +34,293 @@ cdef class ConfigurationCollection:
     cdef double best_objective(self) nogil:
         return self._inner.best_objective
 
+    cdef bint failed(self) nogil:
+        # An entry was dropped for lack of memory, the results are incomplete
+        return conf_collection_failed(self._inner)
+
+    cdef conf_snapshot_t *make_snapshot(self) nogil:
+        return conf_collection_snapshot(self._inner)
+
+    def snapshot(self):
+        """
+        Takes a consistent copy of the stored configurations, it may be called by another thread while an iteration
+        adds to the collection. The copy is shared as long as nothing was added in the meantime.
+
+        Returns:
+            CollectionSnapshot: The immutable copy
+        """
+        cdef conf_snapshot_t *snapshot
+        with nogil:
+            snapshot = self.make_snapshot()
+        if not snapshot:
+            raise MemoryError
+        result = CollectionSnapshot()
+        result._snapshot = snapshot
+        return result
+
+    def __dealloc__(self):
+        conf_collection_destroy(self._inner)
+
+
+cdef class CollectionSnapshot:
+    """
+    Immutable copy of the configurations of a collection. Snapshots with the same version contain the same entries.
+    """
+
+    @property
+    def version(self):
+        return self._snapshot.version
+
+    @property
+    def best_objective(self):
+        return self._snapshot.best_objective
+
+    def __len__(self):
+        return self._snapshot.size
+
+    cdef size_t checked_index(self, index) except? 0:
+        if index < 0:
+            index += self._snapshot.size
+        if not 0 <= index < self._snapshot.size:
+            raise IndexError('snapshot index out of range')
+        return index
+
+    def objective(self, index):
+        return conf_snapshot_get_objective(self._snapshot, self.checked_index(index))
+
+    def configuration(self, index):
+        """
+        Returns:
+            list: The species index of every site
+        """
+        cdef uint8_t *conf = conf_snapshot_get_conf(self._snapshot, self.checked_index(index))
+        return [conf[i] for i in range(self._snapshot.atoms)]
+
+    def decomposition(self, index):
+        """
+        Returns:
+            list: The flat decomposition of the objective, in the layout of the collection
+        """
+        cdef double *decomp = conf_snapshot_get_decomp(self._snapshot, self.checked_index(index))
+        return [decomp[i] for i in range(self._snapshot.alpha_decomp_size)]
+
+    def __dealloc__(self):
+        conf_snapshot_release(self._snapshot)
+
+
+cdef class ThreadLocalCollection(ConfigurationCollection):
+    """
+    A collection for parallel iterations, each thread adds to its own buffer without waiting for the others. The best
+    objective found by any thread is shared for pruning. The buffers are merged into _inner on the first access of the
+    results, until then _inner is NULL. _lock guards this swap against snapshots taken by other threads. If the merge
+    fails for lack of memory the buffers are kept, the collection reports itself as failed and appears empty.
+    """
+
+    def __cinit__(self, size_t max_size, size_t atoms, size_t shell_count, size_t species_count, size_t dimension=1, size_t threads=1, size_t memory_budget=0):
+        openmp.omp_init_lock(&self._lock)
+        self._threads = conf_threads_init(threads, max_size, atoms, species_count, shell_count * species_count * species_count * dimension, memory_budget)
+        if not self._threads:
+            raise MemoryError
+
+    cdef bint add(self, double objective, uint8_t *configuration, double *decomposition) nogil:
+        return conf_threads_add(self._threads, openmp.omp_get_thread_num(), objective, configuration, decomposition)
+
+    cdef double best_objective(self) nogil:
+        # Once merged the thread buffers are gone and the results are read from _inner
+        if self._threads:
+            return conf_threads_best_objective(self._threads)
+        return self._inner.best_objective
+
+    cdef conf_snapshot_t *make_snapshot(self) nogil:
+        cdef conf_snapshot_t *snapshot
+        openmp.omp_set_lock(&self._lock)
+        if self._threads:
+            snapshot = conf_threads_snapshot(self._threads)
+        else:
+            snapshot = conf_collection_snapshot(self._inner)
+        openmp.omp_unset_lock(&self._lock)
+        return snapshot
+
+    cdef bint merge(self) nogil:
+        # True once the results can be read from _inner
+        cdef conf_collection_t *merged
+        openmp.omp_set_lock(&self._lock)
+        if self._threads:
+            merged = conf_threads_merge(self._threads)
+            if merged:
+                self._inner = merged
+                conf_threads_destroy(self._threads)
+                self._threads = NULL
+        openmp.omp_unset_lock(&self._lock)
+        return self._inner != NULL
+
+    cdef double *get_decomposition(self, size_t index) nogil:
+        if not self.merge():
+            return NULL
+        return conf_collection_get_decomp(self._inner, index)
+
+    cdef double get_objective(self, size_t index) nogil:
+        if not self.merge():
+            return -DBL_MAX
+        return conf_collection_get_objective(self._inner, index)
+
+    cdef uint8_t *get_configuration(self, size_t index) nogil:
+        if not self.merge():
+            return NULL
+        return conf_collection_get_conf(self._inner, index)
+
+    cdef size_t size(self) nogil:
+        if not self.merge():
+            return 0
+        return self._inner.size
+
+    cdef bint failed(self) nogil:
+        # A failed merge makes make_results raise MemoryError like a dropped entry does
+        if not self.merge():
+            return True
+        return conf_collection_failed(self._inner)
+
+    def __dealloc__(self):
+        conf_threads_destroy(self._threads)
+        openmp.omp_destroy_lock(&self._lock)
+
+
+cdef class ConfigurationCounter(ConfigurationCollection):
+    """
+    Counts the configurations attaining the best objective during an exhaustive enumeration instead of storing them.
+    Every thread adds to its own counter, the counters are merged on the first access of the results. Only the
+    max_size lexicographically smallest configurations are kept as representatives.
+    """
+
+    def __cinit__(self, size_t max_size, size_t atoms, size_t shell_count, size_t species_count, size_t dimension=1, size_t threads=1):
+        cdef size_t i = 0
+        self.threads = threads
+        self.merged = False
+        self._counters = <conf_counter_t**>calloc(threads, sizeof(conf_counter_t*))
+        if not self._counters:
+            raise MemoryError
+        for i in range(threads):
+            self._counters[i] = conf_counter_init(max_size, atoms, shell_count * species_count * species_count * dimension)
+            if not self._counters[i]:
+                raise MemoryError
+
+    cdef bint add(self, double objective, uint8_t *configuration, double *decomposition) nogil:
+        return conf_counter_add(self._counters[openmp.omp_get_thread_num()], objective, configuration, decomposition)
+
+    cdef double best_objective(self) nogil:
+        return self._counters[openmp.omp_get_thread_num()].best_objective
+
+    cdef void merge(self) nogil:
+        cdef size_t i = 0
+        if not self.merged:
+            for i in range(1, self.threads):
+                conf_counter_merge(self._counters[0], self._counters[i])
+            self.merged = True
+
+    cdef double *get_decomposition(self, size_t index) nogil:
+        self.merge()
+        return conf_counter_get_decomp(self._counters[0], index)
+
+    cdef double get_objective(self, size_t index) nogil:
+        self.merge()
+        return self._counters[0].best_objective
+
+    cdef uint8_t *get_configuration(self, size_t index) nogil:
+        self.merge()
+        return conf_counter_get_conf(self._counters[0], index)
+
+    cdef size_t size(self) nogil:
+        self.merge()
+        return self._counters[0].samples
+
+    cdef bint failed(self) nogil:
+        return False
+
+    cdef conf_snapshot_t *make_snapshot(self) nogil:
+        # The samples of all counters, the count itself is only available through count()
+        return conf_counters_snapshot(self._counters, self.threads)
+
+    def count(self):
+        """
+        Returns:
+            int: The exact number of configurations attaining the best objective
+        """
+        cdef char *count_str
+        self.merge()
+        count_str = conf_counter_get_count_str(self._counters[0])
+        count = int(count_str.decode('ascii'))
+        free(count_str)
+        return count
+
+    def __dealloc__(self):
+        cdef size_t i = 0
+        if self._counters:
+            for i in range(self.threads):
+                conf_counter_destroy(self._counters[i])
+            free(self._counters)
+
+
+cdef class ConfigurationHeap(ConfigurationCollection):
+    """
+    Keeps the max_size best distinct configurations, not only those tied with the best objective. Every thread adds
+    to its own bounded heap and prunes against its own max_size-th best objective, the heaps are merged on the first
+    access of the results. The results are sorted by objective, ties in lexicographical order.
+    """
+
+    def __cinit__(self, size_t max_size, size_t atoms, size_t shell_count, size_t species_count, size_t dimension=1, size_t threads=1):
+        cdef size_t i = 0
+        self.threads = threads
+        self.merged = False
+        self._heaps = <conf_heap_t**>calloc(threads, sizeof(conf_heap_t*))
+        if not self._heaps:
+            raise MemoryError
+        for i in range(threads):
+            self._heaps[i] = conf_heap_init(max_size, atoms, shell_count * species_count * species_count * dimension)
+            if not self._heaps[i]:
+                raise MemoryError
+
+    cdef bint add(self, double objective, uint8_t *configuration, double *decomposition) nogil:
+        return conf_heap_add(self._heaps[openmp.omp_get_thread_num()], objective, configuration, decomposition)
+
+    cdef double best_objective(self) nogil:
+        return self._heaps[openmp.omp_get_thread_num()].threshold
+
+    cdef void merge(self) nogil:
+        cdef size_t i = 0
+        if not self.merged:
+            for i in range(1, self.threads):
+                conf_heap_merge(self._heaps[0], self._heaps[i])
+            self.merged = True
+
+    cdef double *get_decomposition(self, size_t index) nogil:
+        self.merge()
+        return conf_heap_get_decomp(self._heaps[0], index)
+
+    cdef double get_objective(self, size_t index) nogil:
+        self.merge()
+        return conf_heap_get_objective(self._heaps[0], index)
+
+    cdef uint8_t *get_configuration(self, size_t index) nogil:
+        self.merge()
+        return conf_heap_get_conf(self._heaps[0], index)
+
+    cdef size_t size(self) nogil:
+        self.merge()
+        return self._heaps[0].size
+
+    cdef bint failed(self) nogil:
+        cdef size_t i = 0
+        for i in range(self.threads):
+            if self._heaps[i].failed:
+                return True
+        return False
+
+    cdef conf_snapshot_t *make_snapshot(self) nogil:
+        return conf_heaps_snapshot(self._heaps, self.threads)
+
     def __dealloc__(self):
-        conf_collection_destroy(self._inner)
\ No newline at end of file
+        cdef size_t i = 0
+        if self._heaps:
+            for i in range(self.threads):
+                conf_heap_destroy(self._heaps[i])
+            free(self._heaps)
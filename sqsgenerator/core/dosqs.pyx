@@ -1,16 +1,15 @@
 from libc.stdint cimport uint8_t, uint32_t, uint64_t
 from libc.string cimport memset
-from libc.stdlib cimport malloc, free
+from libc.stdlib cimport calloc, free
 from libc.math cimport fabs
 from sqsgenerator.core.collection cimport ConfigurationCollection
-from sqsgenerator.core.sqs cimport SqsIterator
-from sqsgenerator.core.utils cimport next_permutation_lex, knuth_fisher_yates_shuffle, reseed_xor, unrank_permutation
+from sqsgenerator.core.utils cimport next_permutation_lex, knuth_fisher_yates_shuffle, rank_context_partition
+from sqsgenerator.core.utils cimport philox_t, philox_init
+from sqsgenerator.core.utils cimport arena_t, arena_alloc, arena_reset
 cimport cython
 cimport base
 cimport openmp
-from collections import Counter
-from math import factorial
-from cython.parallel import parallel
+from cython.parallel import parallel, prange
 import numpy as np
 import time
 import multiprocessing
@@ -18,61 +17,52 @@ import multiprocessing
 cdef extern from '<float.h>':
     cdef double DBL_MAX
 
-ctypedef bint (*next_permutation_function) (uint8_t *configuration, size_t atoms) nogil
-
 cdef class DosqsIterator(base.BaseIterator):
 
     cdef double[:, :, :] constant_factor_matrix
     cdef double *constant_factor_matrix_ptr
-    cdef SqsIterator sqs_iterator
+    # The low memory kernel scales the direction shares of a pair by the factor of its shell on the fly
+    cdef double[::1] shell_factors
+    cdef double[:, ::1] pair_directions
 
-    def __cinit__(self, structure, dict mole_fractions, dict weights, verbosity=0):
+    def __cinit__(self, structure, dict mole_fractions, dict weights, verbosity=0, **kwargs):
         #super(SqsIterator, self).__cinit__(structure, mole_fractions, weights, verbosity=verbosity)
-        self.constant_factor_matrix = self.make_constant_factor_matrix()
-        self.constant_factor_matrix_ptr = <double*> &self.constant_factor_matrix[0, 0, 0]
-        self.sqs_iterator = SqsIterator(structure, mole_fractions, weights, verbosity=verbosity)
+        if self.low_memory:
+            self.shell_factors = self.make_shell_factors()
+            self.pair_directions = self.geometry.get_directions()
+            self.constant_factor_matrix_ptr = <double*> &self.shell_factors[0]
+        else:
+            self.constant_factor_matrix = self.make_constant_factor_matrix()
+            self.constant_factor_matrix_ptr = <double*> &self.constant_factor_matrix[0, 0, 0]
 
 
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
     cdef double[:, :, :] make_constant_factor_matrix(self):
-        cdef double[:, :, :] constant_factor_matrix = np.ascontiguousarray(np.zeros((self.atoms, self.atoms, 3)))
-
-        cdef size_t i = 0, j = 0, k = 0, l = 0
-        cdef double denominator
-        cdef double vec_x, vec_y, vec_z, vec_sum
-        cdef double value_x, value_y, value_z
-        cdef double weight
-        cdef int shell
-
-        for i in range(self.atoms):
-            for j in range(i, self.atoms):
-                if i == j:
-                    constant_factor_matrix[i, j, 0] = 0.0
-                    constant_factor_matrix[i, j, 1] = 0.0
-                    constant_factor_matrix[i, j, 2] = 0.0
-                    continue
-                if i != j:
-                    shell = self.shell_number_matrix[i,j]
-                    weight = self.weights[shell] if shell in self.weights else 0.0
-                    denominator = (2 * self.shell_neighbor_mapping[shell] * self.atoms) if shell in self.weights else 0.0
-
-                    vec_x, vec_y, vec_z = self.distance_vectors[i, j, 0], self.distance_vectors[i, j, 1], self.distance_vectors[i, j, 2]
-                    vec_x, vec_y, vec_z = fabs(vec_x ** 2), fabs(vec_y ** 2), fabs(vec_z ** 2)
-                    vec_sum = vec_x + vec_y + vec_z
-                    value_x = ((vec_x / vec_sum) * 3.0 * weight / denominator) if shell in self.weights else 0.0
-                    value_y = ((vec_y / vec_sum) * 3.0 * weight / denominator) if shell in self.weights else 0.0
-                    value_z = ((vec_z / vec_sum) * 3.0 * weight / denominator) if shell in self.weights else 0.0
-
-                    constant_factor_matrix[i, j, 0] = value_x
-                    constant_factor_matrix[j, i, 0] = value_x
-
-                    constant_factor_matrix[i, j, 1] = value_y
-                    constant_factor_matrix[j, i, 1] = value_y
-
-                    constant_factor_matrix[i, j, 2] = value_z
-                    constant_factor_matrix[j, i, 2] = value_z
+        cdef double[:, :, ::1] constant_factor_matrix = np.ascontiguousarray(np.zeros((self.atoms, self.atoms, 3)))
+        cdef double[::1] shell_factors = self.make_shell_factors()
+        cdef double[:, ::1] directions = self.geometry.get_directions()
+        cdef Py_ssize_t i = 0
+        cdef size_t j = 0, p = 0, k = 0
+        cdef Py_ssize_t atoms = self.atoms
+        cdef double factor
+
+        # Pairs which are not neighbors belong to no shell, their factors stay 0. A row only writes its own entries
+        with nogil, parallel(num_threads=openmp.omp_get_max_threads()):
+            for i in prange(atoms, schedule='static'):
+                for p in range(self.neighbors.offsets[i], self.neighbors.offsets[i + 1]):
+                    j = self.neighbors.indices[p]
+                    factor = shell_factors[self.shell_number_matrix_ptr[i * atoms + j]]
+                    if factor == 0.0:
+                        continue
+                    for k in range(3):
+                        constant_factor_matrix[i, j, k] = directions[p, k] * factor
 
         return constant_factor_matrix
 
+    cdef result_decomposition(self, ConfigurationCollection collection, size_t index):
+        return self.alpha_to_dict(np.asarray(<double[:3, :self.shell_count, :self.species_count, :self.species_count]>collection.get_decomposition(index)))
+
     def alpha_to_dict(self, double[:, :, :, :] alpha_decomposition):
         axis_mapping = {
             0: "x",
@@ -101,7 +91,11 @@ cdef class DosqsIterator(base.BaseIterator):
     @cython.wraparound(False)
     @cython.cdivision(True)
     cdef double calculate_parameter(self, uint8_t* configuration, double *constant_factor_matrix, double* alpha_decomposition, int dimensions, double main_sum_weight, double *anisotropic_weight) nogil:
-        cdef size_t i = 0, j = 0, k = 0, l = 0
+        """
+        Computes the objective of a configuration. With a low memory geometry ``constant_factor_matrix`` holds the
+        factors by shell id and only the pairs of the neighbor list are visited
+        """
+        cdef size_t i = 0, j = 0, k = 0, l = 0, p = 0
         cdef int current_species = -1, compare_species = -1, shell = -1
         cdef double alpha[3]
         cdef double current_bond_ratio_x
@@ -109,6 +103,7 @@ cdef class DosqsIterator(base.BaseIterator):
         cdef double current_bond_ratio_z
         cdef double current_alpha
         cdef double denominator
+        cdef double factor
         cdef double objective = 0
         cdef double current_directional_bond_ratio
         cdef int d1 = self.shell_count*self.species_count*self.species_count, d2 = self.species_count*self.species_count, d3 = self.species_count
@@ -117,29 +112,52 @@ cdef class DosqsIterator(base.BaseIterator):
         alpha[1] = 0.0
         alpha[2] = 0.0
 
-        for i in range(self.shell_count):
-            compare_species = configuration[i]
-            for j in range(i, self.atoms):
-                current_species = configuration[j]
-                shell = self.shell_number_matrix[i,j] - 1
-                if current_species != compare_species and -1 < shell <= self.shell_count-1:
+        if self.low_memory:
+            for i in range(self.atoms):
+                compare_species = configuration[i]
+                for p in range(self.neighbors.offsets[i], self.neighbors.offsets[i + 1]):
+                    j = self.neighbors.indices[p]
+                    if j <= i:
+                        continue
+                    current_species = configuration[j]
+                    shell = self.pair_shells_ptr[p] - 1
+                    if current_species != compare_species and -1 < shell <= self.shell_count-1:
+                        factor = constant_factor_matrix[shell + 1] / (self.mole_fractions_ptr[current_species]*self.mole_fractions_ptr[compare_species])
+                        current_bond_ratio_x = alpha_decomposition[shell*d2 + compare_species*d3 + current_species] + self.pair_directions[p, 0] * factor
+                        current_bond_ratio_y = alpha_decomposition[d1 + shell*d2 + compare_species*d3 + current_species] + self.pair_directions[p, 1] * factor
+                        current_bond_ratio_z = alpha_decomposition[2*d1 + shell*d2 + compare_species*d3 + current_species] + self.pair_directions[p, 2] * factor
+
+                        alpha_decomposition[shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_x
+                        alpha_decomposition[d1 + shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_y
+                        alpha_decomposition[2*d1 + shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_z
+
+                        alpha_decomposition[shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_x
+                        alpha_decomposition[d1 + shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_y
+                        alpha_decomposition[2*d1 + shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_z
+        else:
+            for i in range(self.atoms):
+                compare_species = configuration[i]
+                for j in range(i, self.atoms):
+                    current_species = configuration[j]
+                    shell = self.shell_number_matrix[i,j] - 1
+                    if current_species != compare_species and -1 < shell <= self.shell_count-1:
 
-                    denominator = (self.mole_fractions_ptr[current_species]*self.mole_fractions_ptr[compare_species])
-                    current_bond_ratio_x = alpha_decomposition[shell*d2 + compare_species*d3 + current_species]
-                    current_bond_ratio_y = alpha_decomposition[d1 + shell*d2 + compare_species*d3 + current_species]
-                    current_bond_ratio_z = alpha_decomposition[2*d1 + shell*d2 + compare_species*d3 + current_species]
+                        denominator = (self.mole_fractions_ptr[current_species]*self.mole_fractions_ptr[compare_species])
+                        current_bond_ratio_x = alpha_decomposition[shell*d2 + compare_species*d3 + current_species]
+                        current_bond_ratio_y = alpha_decomposition[d1 + shell*d2 + compare_species*d3 + current_species]
+                        current_bond_ratio_z = alpha_decomposition[2*d1 + shell*d2 + compare_species*d3 + current_species]
 
-                    current_bond_ratio_x += constant_factor_matrix[i * self.atoms + j] / denominator
-                    current_bond_ratio_y += constant_factor_matrix[i * self.atoms + j + 1] / denominator
-                    current_bond_ratio_z += constant_factor_matrix[i * self.atoms + j + 2] / denominator
+                        current_bond_ratio_x += constant_factor_matrix[(i * self.atoms + j) * 3 + 0] / denominator
+                        current_bond_ratio_y += constant_factor_matrix[(i * self.atoms + j) * 3 + 1] / denominator
+                        current_bond_ratio_z += constant_factor_matrix[(i * self.atoms + j) * 3 + 2] / denominator
 
-                    alpha_decomposition[shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_x
-                    alpha_decomposition[d1 + shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_y
-                    alpha_decomposition[2*d1 + shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_z
+                        alpha_decomposition[shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_x
+                        alpha_decomposition[d1 + shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_y
+                        alpha_decomposition[2*d1 + shell*d2 + compare_species*d3 + current_species] = current_bond_ratio_z
 
-                    alpha_decomposition[shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_x
-                    alpha_decomposition[d1 + shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_y
-                    alpha_decomposition[2*d1 + shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_z
+                        alpha_decomposition[shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_x
+                        alpha_decomposition[d1 + shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_y
+                        alpha_decomposition[2*d1 + shell*d2 + current_species*d3 + compare_species] = current_bond_ratio_z
 
         # Reduce results
         for i in range(dimensions):
@@ -166,13 +184,7 @@ cdef class DosqsIterator(base.BaseIterator):
         return objective
 
     def calculate_alpha(self, double main_sum_weight, list anisotropic_weights):
-        cdef int species_count = len(
-            set(
-                list(
-                    map(lambda site: site.specie.name, self.structure.sites)
-                )
-            )
-        )
+        cdef int species_count = len(set(self.cell.site_symbols))
         cdef size_t old_species_count = self.species_count
         self.species_count = species_count
         cdef double alpha
@@ -194,69 +206,71 @@ cdef class DosqsIterator(base.BaseIterator):
     def sort_numpy(self, uint8_t[:] a, kind='quick'):
         np.asarray(a).sort(kind=kind)
 
-    def iteration(self, double main_sum_weight, list anisotropic_weights, output_structures=10, iterations=100000):
+    def iteration(self, double main_sum_weight, list anisotropic_weights, output_structures=10, iterations=100000, degeneracy=False, ranked=False):
         cdef double dosqs_alpha
-        cdef double sqs_best_alpha
-        cdef double sqs_alpha
         cdef int dimensions = 3
         cdef uint64_t c_iterations
+        cdef uint64_t chunk_iterations
         cdef bint all_flag = iterations == 'all'
-        cdef bint all_output_structures_flag = output_structures == 'all'
+        cdef Py_ssize_t chunk
+        cdef Py_ssize_t chunk_count = 1 if all_flag else base.RANDOM_CHUNKS
+        cdef philox_t rng
         cdef ConfigurationCollection shared_collection
         cdef double[:] dosqs_anisotropy_weights = np.ascontiguousarray(anisotropic_weights)
         cdef double *dosqs_anisotropy_weights_ptr = <double*> &dosqs_anisotropy_weights[0]
-        #Ensure decomposition are contigous in memory
-        cdef double *dosqs_alpha_decomposition = <double*> malloc(sizeof(double)*3*self.shell_count*self.species_count*self.species_count)
-        cdef double *sqs_alpha_decomposition = <double*> malloc(sizeof(double)*self.shell_count*self.species_count*self.species_count)
+        cdef size_t decomposition_size = sizeof(double)*3*self.shell_count*self.species_count*self.species_count
+        # The decomposition lives in the arena of the iterator like the buffers of the parallel iterators
+        cdef arena_t **scratch = self.make_scratch(1, decomposition_size)
+        cdef double *dosqs_alpha_decomposition
 
-        shared_collection = ConfigurationCollection(output_structures if not all_output_structures_flag else 0, self.atoms, self.shell_count, self.species_count, dimension=3)
+        shared_collection = self.make_collection(iterations, output_structures, degeneracy, 1, 3, ranked)
 
         cdef size_t i = 0
 
+        arena_reset(scratch[0])
+        dosqs_alpha_decomposition = <double*>arena_alloc(scratch[0], decomposition_size)
         # dimensions 0 = x, 1 = y, 2 = z
         self.reset_alpha_results(dosqs_alpha_decomposition)
 
         if iterations == 'all':
-            self.sort_numpy(self.configuration)
-            composition = dict(Counter(np.asarray(self.configuration)))
-
-            total_iterations = factorial(self.atoms)
-            current_iteration = 0
-            for species, amount in composition.items():
-                total_iterations = total_iterations/factorial(amount)
+            total_iterations = self.permutation_count()
             print('Configurations to check: {0}'.format(total_iterations))
-            c_iterations = total_iterations
         else:
             c_iterations = iterations
 
         if all_flag:
-            next_permutation_function_ptr = next_permutation_lex
-        else:
-            next_permutation_function_ptr = knuth_fisher_yates_shuffle
-
-        if all_flag:
-            unrank_permutation(self.configuration_ptr, self.atoms, self.composition_hist_ptr, self.species_count, c_iterations, 1)
-        else:
-            knuth_fisher_yates_shuffle(self.configuration_ptr, self.atoms)
+            #Set to first configuration, the single chunk spans the whole (exact) rank range
+            c_iterations = rank_context_partition(self.rank_context, self.configuration_ptr, 0, 1)
 
         t0 = time.time()
-        for i in range(c_iterations):
-            dosqs_alpha = fabs(self.calculate_parameter(self.configuration_ptr, self.constant_factor_matrix_ptr, dosqs_alpha_decomposition, dimensions, main_sum_weight, dosqs_anisotropy_weights_ptr))
-
-            if dosqs_alpha <= shared_collection.best_objective():
-                shared_collection.add(dosqs_alpha, self.configuration_ptr, dosqs_alpha_decomposition)
-                reseed_xor()
-            self.reset_alpha_results(dosqs_alpha_decomposition)
-            next_permutation_function_ptr(self.configuration_ptr, self.atoms)
+        for chunk in range(chunk_count):
+            if all_flag:
+                chunk_iterations = c_iterations
+            else:
+                # The chunks of the parallel iterator in order, a seed draws the same configurations on any number of
+                # threads. The shuffles of a chunk start from the first configuration
+                chunk_iterations = (c_iterations / chunk_count) + (1 if <uint64_t>chunk < c_iterations % chunk_count else 0)
+                philox_init(&rng, self.seed, chunk)
+                rank_context_partition(self.rank_context, self.configuration_ptr, 0, 1)
+                knuth_fisher_yates_shuffle(&rng, self.configuration_ptr, self.atoms)
+
+            for i in range(chunk_iterations):
+                dosqs_alpha = fabs(self.calculate_parameter(self.configuration_ptr, self.constant_factor_matrix_ptr, dosqs_alpha_decomposition, dimensions, main_sum_weight, dosqs_anisotropy_weights_ptr))
+
+                if dosqs_alpha <= shared_collection.best_objective():
+                    shared_collection.add(dosqs_alpha, self.configuration_ptr, dosqs_alpha_decomposition)
+                self.reset_alpha_results(dosqs_alpha_decomposition)
+                if all_flag:
+                    next_permutation_lex(self.configuration_ptr, self.atoms)
+                else:
+                    knuth_fisher_yates_shuffle(&rng, self.configuration_ptr, self.atoms)
         total = time.time() - t0
 
 
-        structure_list = [self.configuration_to_structure(<uint8_t[:self.atoms]>shared_collection.get_configuration(i)) for i in range(shared_collection.size())]
-        decomp_list = [self.alpha_to_dict(np.asarray(<double[:3, :self.shell_count, :self.species_count, :self.species_count]>shared_collection.get_decomposition(i))) for i in range(shared_collection.size())]
+        self.report_degeneracy(shared_collection)
+        structure_list, decomp_list = self.make_results(shared_collection, output_structures)
 
         lps = total_iterations if iterations == 'all' else iterations
-        for i in range(shared_collection.size()):
-            print('LIST AFTER: {}/{} {}'.format(i, shared_collection.size(), np.array(<uint8_t[:self.atoms]>shared_collection.get_configuration(i))))
 
         return structure_list, decomp_list, lps, total/lps
 
@@ -268,20 +282,20 @@ cdef class DosqsIterator(base.BaseIterator):
 cdef class ParallelDosqsIterator(DosqsIterator):
 
     cdef size_t num_threads
+    cdef readonly list thread_evaluations
 
-    def __cinit__(self, structure, dict mole_fractions, dict weights, verbosity=0, num_threads=multiprocessing.cpu_count()):
+    def __cinit__(self, structure, dict mole_fractions, dict weights, verbosity=0, num_threads=multiprocessing.cpu_count(), **kwargs):
         self.num_threads = num_threads
 
-    def iteration(self, double main_sum_weight, list anisotropic_weights, iterations=100000, output_structures=10):
-        cdef int num_threads = self.num_threads
+    def iteration(self, double main_sum_weight, list anisotropic_weights, iterations=100000, output_structures=10, degeneracy=False, ranked=False):
         cdef int thread_id
         cdef int dimensions = 3
         cdef bint all_flag = iterations == 'all'
-        cdef bint all_output_structures_flag = output_structures == 'all'
-        cdef uint64_t permutations
-        cdef uint64_t start_permutation
-        cdef uint64_t end_permutation
-        cdef uint64_t c_iterations
+        cdef uint64_t local_iterations
+        cdef uint64_t c_iterations = 0
+        cdef Py_ssize_t chunk
+        cdef Py_ssize_t chunk_count = self.num_threads * base.CHUNKS_PER_THREAD if all_flag else base.RANDOM_CHUNKS
+        cdef uint64_t *thread_evaluations
 
         cdef Py_ssize_t i = 0, j = 0, k = 0
 
@@ -290,10 +304,13 @@ cdef class ParallelDosqsIterator(DosqsIterator):
         cdef double local_dosqs_alpha
         cdef uint8_t* local_configuration
         cdef double* local_dosqs_alpha_decomposition
-        cdef next_permutation_function next_permutation_function_ptr
+        cdef size_t decomposition_size = sizeof(double)*3*self.shell_count*self.species_count*self.species_count
+        cdef arena_t **scratch = self.make_scratch(self.num_threads, sizeof(uint8_t)*self.atoms + decomposition_size + sizeof(philox_t))
+        cdef philox_t* local_rng
         cdef ConfigurationCollection shared_collection
 
-        shared_collection = ConfigurationCollection(output_structures if not all_output_structures_flag else 0, self.atoms, self.shell_count, self.species_count, dimension=3)
+        shared_collection = self.make_collection(iterations, output_structures, degeneracy, self.num_threads, 3, ranked)
+        thread_evaluations = <uint64_t*>calloc(self.num_threads, sizeof(uint64_t))
 
         openmp.omp_set_num_threads(self.num_threads)
         print('Threads used: {}'.format(self.num_threads))
@@ -302,14 +319,8 @@ cdef class ParallelDosqsIterator(DosqsIterator):
         cdef double *dosqs_anisotropy_weights_ptr = <double*> &dosqs_anisotropy_weights[0]
 
         if iterations == 'all':
-            self.sort_numpy(self.configuration)
-            composition = dict(Counter(np.asarray(self.configuration)))
-            total_iterations = factorial(self.atoms)
-            current_iteration = 0
-            for species, amount in composition.items():
-                total_iterations = total_iterations/factorial(amount)
-            print('Configurations to check: {0}'.format(int(total_iterations)))
-            permutations = total_iterations
+            total_iterations = self.permutation_count()
+            print('Configurations to check: {0}'.format(total_iterations))
         else:
             c_iterations = iterations
 
@@ -317,45 +328,46 @@ cdef class ParallelDosqsIterator(DosqsIterator):
         with nogil, parallel():
 
             thread_id = openmp.omp_get_thread_num()
-            local_configuration = <uint8_t*>malloc(sizeof(uint8_t)*self.atoms)
-            local_dosqs_alpha_decomposition = <double*>malloc(sizeof(double)*3*self.shell_count*self.species_count*self.species_count)
-
-            for i in range(self.atoms):
-                local_configuration[i] = self.configuration[i]
+            # Buffers come from the threads arena which is kept across runs
+            arena_reset(scratch[thread_id])
+            local_configuration = <uint8_t*>arena_alloc(scratch[thread_id], sizeof(uint8_t)*self.atoms)
+            local_dosqs_alpha_decomposition = <double*>arena_alloc(scratch[thread_id], decomposition_size)
+            local_rng = <philox_t*>arena_alloc(scratch[thread_id], sizeof(philox_t))
             self.reset_alpha_results(local_dosqs_alpha_decomposition)
 
-            start_permutation = thread_id*(permutations if all_flag else c_iterations)/num_threads
-            end_permutation = (thread_id+1)*(permutations if all_flag else c_iterations)/num_threads+1
-
-            if thread_id == 0:
-                start_permutation = 1
-
-            if all_flag:
-                next_permutation_function_ptr = next_permutation_lex
-            else:
-                next_permutation_function_ptr = knuth_fisher_yates_shuffle
-
-            if all_flag:
-                unrank_permutation(local_configuration, self.atoms, self.composition_hist_ptr, self.species_count, permutations, start_permutation)
-            else:
-                knuth_fisher_yates_shuffle(local_configuration, self.atoms)
-
-            for k in range(start_permutation, end_permutation):
-                local_dosqs_alpha = fabs(self.calculate_parameter(local_configuration, self.constant_factor_matrix_ptr, local_dosqs_alpha_decomposition, dimensions, main_sum_weight, dosqs_anisotropy_weights_ptr))
-                if local_dosqs_alpha <= shared_collection.best_objective():
-                    shared_collection.add(local_dosqs_alpha, local_configuration, local_dosqs_alpha_decomposition)
-                    reseed_xor()
-                self.reset_alpha_results(local_dosqs_alpha_decomposition)
-                next_permutation_function_ptr(local_configuration, self.atoms)
-
-
-            free(local_configuration)
+            # Idle threads fetch the next chunk from the shared OpenMP counter
+            for chunk in prange(chunk_count, schedule='dynamic'):
+                if all_flag:
+                    # Exact slice of the rank range, also for compositions with more than 2^64 configurations
+                    local_iterations = rank_context_partition(self.rank_context, local_configuration, chunk, chunk_count)
+                else:
+                    local_iterations = (c_iterations / chunk_count) + (1 if <uint64_t>chunk < c_iterations % chunk_count else 0)
+                    # Every chunk draws from its own stream, the results depend neither on which thread runs it nor
+                    # on the number of threads
+                    philox_init(local_rng, self.seed, chunk)
+                    rank_context_partition(self.rank_context, local_configuration, 0, 1)
+                    knuth_fisher_yates_shuffle(local_rng, local_configuration, self.atoms)
+
+                for k in range(local_iterations):
+                    local_dosqs_alpha = fabs(self.calculate_parameter(local_configuration, self.constant_factor_matrix_ptr, local_dosqs_alpha_decomposition, dimensions, main_sum_weight, dosqs_anisotropy_weights_ptr))
+                    if local_dosqs_alpha <= shared_collection.best_objective():
+                        shared_collection.add(local_dosqs_alpha, local_configuration, local_dosqs_alpha_decomposition)
+                    self.reset_alpha_results(local_dosqs_alpha_decomposition)
+                    if all_flag:
+                        next_permutation_lex(local_configuration, self.atoms)
+                    else:
+                        knuth_fisher_yates_shuffle(local_rng, local_configuration, self.atoms)
+                thread_evaluations[thread_id] = thread_evaluations[thread_id] + local_iterations
 
         total = time.time()-t0
 
-        structure_list = [self.configuration_to_structure(<uint8_t[:self.atoms]>shared_collection.get_configuration(i)) for i in range(shared_collection.size())]
-        decomp_list = [self.alpha_to_dict(np.asarray(<double[:3, :self.shell_count, :self.species_count, :self.species_count]>shared_collection.get_decomposition(i))) for i in range(shared_collection.size())]
-        dl = [<double[:3, :self.shell_count, :self.species_count, :self.species_count]>shared_collection.get_decomposition(i) for i in range(shared_collection.size())]
+        self.thread_evaluations = [thread_evaluations[i] for i in range(self.num_threads)]
+        free(thread_evaluations)
+        if self.verbosity:
+            print('Evaluations per thread: {}'.format(self.thread_evaluations))
+
+        self.report_degeneracy(shared_collection)
+        structure_list, decomp_list = self.make_results(shared_collection, output_structures)
 
         lps = total_iterations if iterations == 'all' else iterations
 
@@ -0,0 +1,25 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/* Blocks start on their own cache line, arenas of different threads never share one */
+#define ARENA_ALIGNMENT 64
+
+/*
+ * Bump allocator over a single aligned block. Blocks are handed out in order and released all at once with
+ * arena_reset, there is no per block free.
+ */
+typedef struct __arena_struct {
+    size_t capacity;
+    size_t offset;
+    uint8_t* memory;
+} arena_t;
+
+arena_t* arena_init(size_t capacity);
+void* arena_alloc(arena_t* a, size_t size);
+void arena_reset(arena_t* a);
+void arena_destroy(arena_t* a);
+
+#endif
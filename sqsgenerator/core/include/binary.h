@@ -0,0 +1,37 @@
+#ifndef BINARY_H
+#define BINARY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "rank.h"
+#include "utils.h"
+
+/* Largest cell which fits into a single mask */
+#define BINARY_MAX_ATOMS 128
+
+/*
+ * Engine for binary cells with at most 128 sites. A configuration is a bitmask where a set bit marks an atom of the
+ * second species. Site i is stored at bit (atoms - 1 - i), thus the numeric order of the masks is the lexicographical
+ * order of the configurations.
+ */
+typedef struct __binary_sqs_struct {
+    size_t atoms;
+    size_t ones;
+    size_t shell_count;
+    uint128_t all;
+    uint128_t *neighbor_masks;
+    double *shell_factors;
+    double *shell_targets;
+    uint128_t *binomials;
+} binary_sqs_t;
+
+binary_sqs_t* binary_sqs_init(size_t atoms, size_t ones, size_t shell_count, uint8_t *shell_matrix, double *shell_factors, double *shell_targets);
+void binary_sqs_destroy(binary_sqs_t* b);
+double binary_sqs_objective(binary_sqs_t* b, uint128_t mask, double *decomposition);
+uint128_t binary_random_mask(binary_sqs_t* b, philox_t* rng);
+bool binary_next_mask(binary_sqs_t* b, uint128_t *mask);
+uint64_t binary_partition(binary_sqs_t* b, uint128_t *mask, uint64_t index, uint64_t chunks);
+void binary_mask_to_configuration(binary_sqs_t* b, uint128_t mask, uint8_t *configuration);
+
+#endif
@@ -1,9 +1,13 @@
+#ifndef CONF_ARRAY_H
+#define CONF_ARRAY_H
+
 #include <stdlib.h>
 #include <pthread.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <gmp.h>
-#include "rank.h"
+#include "conf_hash.h"
+#include "conf_snapshot.h"
 
 typedef struct __conf_array_struct {
     size_t max_size;
@@ -13,10 +17,15 @@ typedef struct __conf_array_struct {
     double* objective;
     double* alpha_decomp;
     uint8_t* data;
-    bool* set_flags;
     double best_objective;
-    uint64_t species_count;
-    mpz_t *ranks;
+    conf_hash_set_t *hashes;
+    /* Entry with the lexicographically largest configuration, max_size while it is not known */
+    size_t largest;
+    /* Incremented on every change of the stored entries, the published snapshot is reused while it matches */
+    uint64_t version;
+    conf_snapshot_t* published;
+    /* Set if an entry could not be indexed for lack of memory, the stored entries are incomplete */
+    bool failed;
     pthread_mutex_t mutex;
 } conf_array_t;
 
@@ -25,4 +34,7 @@ uint8_t* conf_array_get_conf(conf_array_t* array, size_t index);
 double* conf_array_get_decomp(conf_array_t* array, size_t index);
 double conf_array_get_objective(conf_array_t* array, size_t index);
 bool conf_array_add(conf_array_t* array, double objective, uint8_t* configuration, double* decomp);
+conf_snapshot_t* conf_array_snapshot(conf_array_t* array);
 void conf_array_destroy(conf_array_t* array);
+
+#endif
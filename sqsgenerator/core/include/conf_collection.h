@@ -1,3 +1,6 @@
+#ifndef CONF_COLLECTION_H
+#define CONF_COLLECTION_H
+
 #include <stdlib.h>
 #include "conf_array.h"
 #include "conf_list.h"
@@ -10,9 +13,18 @@ typedef struct __conf_collection_struct {
 
 } conf_collection_t;
 
-conf_collection_t* conf_collection_init(size_t max_size, size_t atoms, size_t decomp_size);
+/* An unbounded collection (max_size 0) spills its records to a file beyond budget bytes */
+conf_collection_t* conf_collection_init(size_t max_size, size_t atoms, size_t species, size_t decomp_size, size_t budget);
+/* For an unbounded collection the configuration and the decomposition are unpacked into buffers of the list, which the
+ * next call of the same getter overwrites. They are not synchronized with conf_collection_add */
 uint8_t* conf_collection_get_conf(conf_collection_t* c, size_t index);
 double* conf_collection_get_decomp(conf_collection_t* c, size_t index);
 double conf_collection_get_objective(conf_collection_t* c, size_t index);
+uint8_t* conf_collection_get_record(conf_collection_t* c, size_t index);
+size_t conf_collection_record_size(conf_collection_t* c);
+bool conf_collection_failed(conf_collection_t* c);
+conf_snapshot_t* conf_collection_snapshot(conf_collection_t* c);
 bool conf_collection_add(conf_collection_t* c, double objective, uint8_t *conf, double* decomp);
 void conf_collection_destroy(conf_collection_t* c);
+
+#endif
@@ -0,0 +1,44 @@
+#ifndef CONF_COUNTER_H
+#define CONF_COUNTER_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <gmp.h>
+#include "conf_snapshot.h"
+
+/*
+ * Counts the configurations attaining the best objective instead of storing them. Only the "max_samples"
+ * lexicographically smallest of them are kept as representatives, thus the result does not depend on the order
+ * in which the configurations were visited. Each thread owns a counter, they are merged after the run. The mutex guards
+ * the changes of the samples against concurrent snapshots.
+ */
+typedef struct __conf_counter_struct {
+    size_t max_samples;
+    size_t samples;
+    size_t atoms;
+    size_t alpha_decomp_size;
+    uint64_t pending;
+    double best_objective;
+    uint8_t* data;
+    double* alpha_decomp;
+    mpz_t count;
+    /* Incremented on every change of the samples, the published snapshot is reused while it matches */
+    uint64_t version;
+    conf_snapshot_t* published;
+    pthread_mutex_t mutex;
+} conf_counter_t;
+
+conf_counter_t* conf_counter_init(size_t max_samples, size_t atoms, size_t decomp_size);
+bool conf_counter_add(conf_counter_t* c, double objective, uint8_t* configuration, double* decomp);
+void conf_counter_merge(conf_counter_t* c, conf_counter_t* other);
+void conf_counter_get_count(conf_counter_t* c, mpz_t result);
+char* conf_counter_get_count_str(conf_counter_t* c);
+uint8_t* conf_counter_get_conf(conf_counter_t* c, size_t index);
+double* conf_counter_get_decomp(conf_counter_t* c, size_t index);
+conf_snapshot_t* conf_counter_snapshot(conf_counter_t* c);
+conf_snapshot_t* conf_counters_snapshot(conf_counter_t** counters, size_t count);
+void conf_counter_destroy(conf_counter_t* c);
+
+#endif
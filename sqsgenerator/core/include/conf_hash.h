@@ -0,0 +1,41 @@
+#ifndef CONF_HASH_H
+#define CONF_HASH_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "rank.h"
+
+/* Returns the stored record (the configuration in the layout of the owner) for an index of the owning collection */
+typedef uint8_t* (*conf_hash_get_conf_t)(void* owner, size_t index);
+
+/*
+ * 128-bit Zobrist hashes of configurations in an open addressing set. The hash is the XOR of one key per (site,
+ * species) pair, computed in O(N) when a configuration is added. Equal hashes are verified by comparing the stored
+ * record of record_size bytes, a collision never drops a distinct configuration. A slot is occupied only if its
+ * stamp equals the current generation, clearing the set bumps the generation instead of touching the table.
+ */
+typedef struct __conf_hash_set_struct {
+    size_t atoms;
+    size_t record_size;
+    size_t species;
+    size_t capacity;
+    size_t size;
+    uint128_t* keys;
+    uint128_t* hashes;
+    size_t* indices;
+    uint32_t* stamps;
+    uint32_t generation;
+    void* owner;
+    conf_hash_get_conf_t get_conf;
+} conf_hash_set_t;
+
+conf_hash_set_t* conf_hash_set_init(size_t atoms, size_t record_size, void* owner, conf_hash_get_conf_t get_conf);
+uint128_t conf_hash_compute(conf_hash_set_t* s, uint8_t* conf);
+bool conf_hash_set_contains(conf_hash_set_t* s, uint128_t hash, uint8_t* record);
+bool conf_hash_set_insert(conf_hash_set_t* s, uint128_t hash, size_t index);
+bool conf_hash_set_remove(conf_hash_set_t* s, uint128_t hash, size_t index);
+void conf_hash_set_clear(conf_hash_set_t* s);
+void conf_hash_set_destroy(conf_hash_set_t* s);
+
+#endif
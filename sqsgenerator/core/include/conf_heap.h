@@ -0,0 +1,50 @@
+#ifndef CONF_HEAP_H
+#define CONF_HEAP_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include "conf_hash.h"
+#include "conf_snapshot.h"
+
+/*
+ * Keeps the max_size best distinct configurations in a bounded max-heap. Entries are ordered by objective and ties are
+ * broken by the lexicographical order of the configuration, the kept set does not depend on the order of insertion.
+ * The worst kept entry is the root, as long as the heap is full anything worse than threshold is rejected.
+ * Only the owning thread adds, the mutex guards the changes of the entries against concurrent snapshots.
+ */
+typedef struct __conf_heap_struct {
+    size_t max_size;
+    size_t size;
+    size_t atoms;
+    size_t alpha_decomp_size;
+    double threshold;
+    bool sorted;
+    uint8_t* data;
+    double* alpha_decomp;
+    double* objective;
+    uint128_t* entry_hashes;
+    /* Heap of entry indices, after conf_heap_sort the entries in ascending order */
+    size_t* heap;
+    conf_hash_set_t* hashes;
+    /* Incremented on every change of the kept entries, the published snapshot is reused while it matches */
+    uint64_t version;
+    conf_snapshot_t* published;
+    /* Set if an entry could not be indexed for lack of memory, the kept entries are incomplete */
+    bool failed;
+    pthread_mutex_t mutex;
+} conf_heap_t;
+
+conf_heap_t* conf_heap_init(size_t max_size, size_t atoms, size_t decomp_size);
+bool conf_heap_add(conf_heap_t* h, double objective, uint8_t* conf, double* decomp);
+void conf_heap_merge(conf_heap_t* h, conf_heap_t* other);
+void conf_heap_sort(conf_heap_t* h);
+uint8_t* conf_heap_get_conf(conf_heap_t* h, size_t index);
+double* conf_heap_get_decomp(conf_heap_t* h, size_t index);
+double conf_heap_get_objective(conf_heap_t* h, size_t index);
+conf_snapshot_t* conf_heap_snapshot(conf_heap_t* h);
+conf_snapshot_t* conf_heaps_snapshot(conf_heap_t** heaps, size_t count);
+void conf_heap_destroy(conf_heap_t* h);
+
+#endif
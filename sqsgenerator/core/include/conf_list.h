@@ -1,31 +1,48 @@
+#ifndef CONF_LIST_H
+#define CONF_LIST_H
+
 #include <stdlib.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
 #include <gmp.h>
-#include "list.h"
-#include "rank.h"
-
-#define conf_list_size(l) (l->__inner_list->size)
-
-typedef struct __node_conf_data {
-    uint8_t* configuration;
-    double* alpha_decomp;
-    double alpha;
-    mpz_t rank;
-} node_conf_data_t;
+#include "conf_hash.h"
+#include "conf_record.h"
+#include "conf_store.h"
+#include "conf_snapshot.h"
 
+#define conf_list_size(l) (l->size)
 
+/* Unbounded store, every result is a fixed-size record of the objective, the decomposition and the configuration in
+ * the compact layout of conf_record. The records are kept in a conf_store which grows geometrically and spills to a
+ * mapped file beyond its budget. Indexed access is O(1), appending amortized O(1). The getters unpack into a buffer
+ * of the list which is valid until the next call, they are not synchronized: use them once the adding threads are
+ * done, concurrent readers take a snapshot instead. Only the hash set used for deduplication stays in memory */
 typedef struct __conf_list {
-    list_t* __inner_list;
-    double best_objective;
-    size_t alpha_decomp_size;
-    size_t atoms;
     size_t size;
-    uint64_t species_count;
+    size_t atoms;
+    size_t alpha_decomp_size;
+    conf_record_layout_t layout;
+    conf_store_t store;
+    double best_objective;
+    uint8_t* conf_buffer;
+    uint8_t* record_buffer;
+    double* decomp_buffer;
+    conf_hash_set_t *hashes;
+    uint64_t version;
+    conf_snapshot_t* published;
+    /* Set if a record could not be stored or indexed for lack of memory, the stored records are incomplete */
+    bool failed;
+    pthread_mutex_t mutex;
 } conf_list_t;
 
-conf_list_t* conf_list_init(size_t atoms, size_t decomp_size);
+conf_list_t* conf_list_init(size_t atoms, size_t species, size_t decomp_size, size_t budget);
 bool conf_list_add(conf_list_t* l, double alpha, uint8_t* conf, double* decomp);
 void conf_list_destroy(conf_list_t* l);
 double conf_list_get_objective(conf_list_t* l, size_t index);
 uint8_t* conf_list_get_conf(conf_list_t* l, size_t index);
-double* conf_list_get_decomp(conf_list_t* l, size_t index);
\ No newline at end of file
+double* conf_list_get_decomp(conf_list_t* l, size_t index);
+uint8_t* conf_list_get_record(conf_list_t* l, size_t index);
+conf_snapshot_t* conf_list_snapshot(conf_list_t* l);
+
+#endif
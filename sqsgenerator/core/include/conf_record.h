@@ -0,0 +1,29 @@
+#ifndef CONF_RECORD_H
+#define CONF_RECORD_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * Compact layout of a stored result. Every site is packed into ceil(log2(species)) bits, the first site in the most
+ * significant bits of the first byte, thus packed configurations compare with memcmp like the unpacked ones.
+ * Decompositions are symmetric in the species pair and vanish on the diagonal, only the entries above the diagonal
+ * are kept for every shell (and direction).
+ */
+typedef struct __conf_record_layout_struct {
+    size_t atoms;
+    size_t species;
+    size_t bits;
+    size_t conf_size;
+    size_t blocks;
+    size_t decomp_size;
+    size_t packed_decomp_size;
+} conf_record_layout_t;
+
+void conf_record_layout_init(conf_record_layout_t* l, size_t atoms, size_t species, size_t decomp_size);
+void conf_record_pack_conf(conf_record_layout_t* l, uint8_t* conf, uint8_t* packed);
+void conf_record_unpack_conf(conf_record_layout_t* l, uint8_t* packed, uint8_t* conf);
+void conf_record_pack_decomp(conf_record_layout_t* l, double* decomp, double* packed);
+void conf_record_unpack_decomp(conf_record_layout_t* l, double* packed, double* decomp);
+
+#endif
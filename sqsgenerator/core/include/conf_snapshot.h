@@ -0,0 +1,33 @@
+#ifndef CONF_SNAPSHOT_H
+#define CONF_SNAPSHOT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+/*
+ * Immutable copy of the best set of a collection. A collection publishes its last snapshot and hands it out again as
+ * long as nothing was added, readers never see entries change under them and never hold the lock of the collection
+ * while reading. Snapshots are reference counted, the last conf_snapshot_release frees it.
+ */
+typedef struct __conf_snapshot_struct {
+    uint64_t version;
+    size_t size;
+    size_t atoms;
+    size_t alpha_decomp_size;
+    double best_objective;
+    double* objective;
+    double* alpha_decomp;
+    uint8_t* data;
+    atomic_size_t references;
+} conf_snapshot_t;
+
+#define conf_snapshot_get_conf(s, index) (&((s)->data[(index) * (s)->atoms]))
+#define conf_snapshot_get_decomp(s, index) (&((s)->alpha_decomp[(index) * (s)->alpha_decomp_size]))
+#define conf_snapshot_get_objective(s, index) ((s)->objective[index])
+
+conf_snapshot_t* conf_snapshot_init(uint64_t version, size_t size, size_t atoms, size_t decomp_size);
+conf_snapshot_t* conf_snapshot_acquire(conf_snapshot_t* s);
+void conf_snapshot_release(conf_snapshot_t* s);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef CONF_STORE_H
+#define CONF_STORE_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Growable block of fixed-size records. The block lives on the heap until it would exceed budget bytes, afterwards
+ * it is moved to an unlinked temporary file which is mapped into memory. The kernel may then write the records back
+ * to the file and evict them, the store is no longer limited by the available memory. A budget of 0 never spills.
+ */
+typedef struct __conf_store_struct {
+    size_t record_size;
+    size_t capacity;
+    size_t budget;
+    uint8_t* memory;
+    int fd;
+} conf_store_t;
+
+#define conf_store_spilled(s) ((s)->fd >= 0)
+#define conf_store_get(s, index) (&((s)->memory[(index) * (s)->record_size]))
+
+bool conf_store_init(conf_store_t* s, size_t record_size, size_t capacity, size_t budget);
+bool conf_store_grow(conf_store_t* s);
+void conf_store_release(conf_store_t* s);
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef CONF_THREADS_H
+#define CONF_THREADS_H
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include "conf_collection.h"
+
+/*
+ * One collection per thread, no thread ever waits for another one while adding. The best objective of all threads is
+ * published atomically and used for pruning. The buffers are merged deterministically: among the configurations
+ * attaining the best objective the lexicographically smallest ones are kept, as a serial exhaustive run would do.
+ * Snapshots combine the snapshots of the buffers the same way, the mutex only guards the published one.
+ */
+typedef struct __conf_threads_struct {
+    _Atomic double best_objective;
+    size_t threads;
+    size_t max_size;
+    size_t atoms;
+    size_t species;
+    size_t alpha_decomp_size;
+    size_t budget;
+    conf_collection_t** locals;
+    conf_snapshot_t* published;
+    pthread_mutex_t mutex;
+} conf_threads_t;
+
+conf_threads_t* conf_threads_init(size_t threads, size_t max_size, size_t atoms, size_t species, size_t decomp_size, size_t budget);
+bool conf_threads_add(conf_threads_t* t, size_t thread, double objective, uint8_t* conf, double* decomp);
+double conf_threads_best_objective(conf_threads_t* t);
+conf_collection_t* conf_threads_merge(conf_threads_t* t);
+conf_snapshot_t* conf_threads_snapshot(conf_threads_t* t);
+void conf_threads_destroy(conf_threads_t* t);
+
+#endif
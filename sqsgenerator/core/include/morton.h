@@ -0,0 +1,16 @@
+#ifndef MORTON_H
+#define MORTON_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * Orders sites along a Morton (Z-order) curve through the fractional coordinates. The wrapped coordinates are quantized
+ * to MORTON_BITS bits per direction and interleaved, sites close in space mostly get close positions on the curve.
+ */
+#define MORTON_BITS 21
+
+uint64_t morton_key(double* frac);
+void morton_order(double* frac_coords, size_t atoms, size_t* order);
+
+#endif
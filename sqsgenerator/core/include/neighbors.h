@@ -0,0 +1,77 @@
+#ifndef NEIGHBORS_H
+#define NEIGHBORS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * Every periodic image within the cutoff of the sites of a unit cell. An entry stores the unit cell site it reaches,
+ * the lattice translation of the image and the vector to it. Built by brute force, unit cells are small.
+ */
+typedef struct __neighbor_table_struct {
+    size_t atoms;
+    double cutoff;
+    size_t entries;
+    size_t* offsets;
+    size_t* indices;
+    int64_t* translations;
+    double* vectors;
+} neighbor_table_t;
+
+/*
+ * Periodic cell list over the fractional coordinates of a cell. Every lattice direction is divided into bins which are
+ * at least as wide as the cutoff, thus a site only has to visit the bins within "reach" of its own one. Bins beyond
+ * the border are the periodic images of the bins on the other side. The pairs within the cutoff are stored row by row
+ * (CSR), a pair keeps only its shortest image like pbc_shortest_vectors. Time and memory are O(atoms) for a fixed
+ * cutoff and density.
+ */
+typedef struct __neighbor_list_struct {
+    size_t atoms;
+    double cutoff;
+    double lattice[9];
+    double* frac;
+    size_t bins[3];
+    size_t reach[3];
+    size_t* cell_start;
+    size_t* cell_sites;
+    /* Row i holds the pairs offsets[i] to offsets[i+1], sorted by the index of the second site */
+    size_t pairs;
+    size_t* offsets;
+    size_t* indices;
+    double* distances;
+    /* Shortest image vector from the first to the second site, three per pair */
+    double* vectors;
+    /* Supercells built from a unit cell table have no cell list. Site s of translation c has the index
+     * s * cells + c, their "cells" are the translations of the unit cell */
+    neighbor_table_t* table;
+    size_t multiples[3];
+} neighbor_list_t;
+
+/* Scratch of a single thread, a stamp equal to the generation marks a site reached from the current site */
+typedef struct __neighbor_workspace_struct {
+    size_t atoms;
+    size_t count;
+    size_t generation;
+    size_t* stamps;
+    size_t* touched;
+    double* d2;
+    double* vectors;
+} neighbor_workspace_t;
+
+neighbor_table_t* neighbor_table_init(double* lattice, double* frac_coords, size_t atoms, double cutoff);
+void neighbor_table_destroy(neighbor_table_t* t);
+
+neighbor_list_t* neighbor_list_init(double* lattice, double* frac_coords, size_t atoms, double cutoff);
+neighbor_list_t* neighbor_list_supercell(neighbor_table_t* table, size_t* multiples);
+size_t neighbor_list_cells(neighbor_list_t* nl);
+void neighbor_list_count(neighbor_list_t* nl, size_t cell, neighbor_workspace_t* w);
+bool neighbor_list_allocate(neighbor_list_t* nl);
+void neighbor_list_fill(neighbor_list_t* nl, size_t cell, neighbor_workspace_t* w);
+neighbor_list_t* neighbor_list_reorder(neighbor_list_t* nl, size_t* order, size_t* rank);
+void neighbor_list_destroy(neighbor_list_t* nl);
+
+neighbor_workspace_t* neighbor_workspace_init(size_t atoms);
+void neighbor_workspace_destroy(neighbor_workspace_t* w);
+
+#endif
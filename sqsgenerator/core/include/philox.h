@@ -0,0 +1,45 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+ * Philox4x32-10 counter based generator (Salmon et al., SC'11). The output is a pure function of the key and a 128 bit
+ * counter, the key is the seed and the upper 64 bits of the counter select a stream. Streams never overlap and any
+ * position of a stream is reached in O(1), a generator is a few words which every thread keeps for itself.
+ */
+typedef struct __philox_struct {
+    uint32_t counter[4];
+    uint32_t key[2];
+    uint32_t output[4];
+    size_t used;
+} philox_t;
+
+void philox_init(philox_t* p, uint64_t seed, uint64_t stream);
+void philox_jump(philox_t* p, uint64_t blocks, uint64_t streams);
+void philox_refill(philox_t* p);
+
+/* Every block yields four numbers, a new one is only computed when they are used up */
+static inline uint32_t philox_next(philox_t* p) {
+    if (p->used == 4) {
+        philox_refill(p);
+    }
+    return p->output[p->used++];
+}
+
+/* Uniform in [0, n) without modulo bias (Lemire), a second draw is needed with a probability below n / 2^32 */
+static inline uint32_t philox_bounded(philox_t* p, uint32_t n) {
+    uint64_t m = (uint64_t) philox_next(p) * n;
+    uint32_t low = (uint32_t) m, threshold;
+    if (low < n) {
+        threshold = -n % n;
+        while (low < threshold) {
+            m = (uint64_t) philox_next(p) * n;
+            low = (uint32_t) m;
+        }
+    }
+    return (uint32_t) (m >> 32);
+}
+
+#endif
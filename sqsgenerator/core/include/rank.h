@@ -1,3 +1,6 @@
+#ifndef RANK_H
+#define RANK_H
+
 #include <gmp.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -5,6 +8,8 @@
 #include <string.h>
 #include "utils.h"
 
+typedef unsigned __int128 uint128_t;
+
 void permutation_count_mpz(mpz_t mi_result, uint8_t *configuration, size_t atoms);
 uint64_t rank_permutation(uint8_t *configuration, size_t atoms, size_t species);
 void rank_permutation_mpz(mpz_t result, uint8_t *configuration, size_t atoms, size_t species);
@@ -12,4 +17,14 @@ void unrank_permutation_mpz(uint8_t *configuration, size_t atoms, size_t *hist,
 void unrank_permutation(uint8_t *configuration, size_t atoms, size_t *hist, size_t species, uint64_t permutations, uint64_t rank);
 bool next_permutation_lex(uint8_t *configuration, size_t atoms);
 void rank_permutation_mpz(mpz_t result, uint8_t *configuration, size_t atoms, size_t species);
-size_t configuration_species_count(uint8_t *configuration, size_t atoms);
\ No newline at end of file
+size_t configuration_species_count(uint8_t *configuration, size_t atoms);
+void mpz_set_u128(mpz_t result, uint128_t value);
+bool mpz_get_u128(uint128_t *result, mpz_t value);
+bool mul_div_exact_128(uint128_t *result, uint128_t a, uint128_t b, uint128_t c);
+bool permutation_count_128(uint128_t *result, size_t atoms, size_t *hist, size_t species);
+void permutation_count_hist_mpz(mpz_t result, size_t atoms, size_t *hist, size_t species);
+bool rank_permutation_128(uint128_t *result, uint8_t *configuration, size_t atoms, size_t species);
+void unrank_permutation_128(uint8_t *configuration, size_t atoms, size_t *hist, size_t species, uint128_t permutations, uint128_t rank);
+uint64_t permutation_partition(uint8_t *configuration, size_t atoms, size_t *hist, size_t species, uint64_t index, uint64_t chunks);
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef RANK_CONTEXT_H
+#define RANK_CONTEXT_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <gmp.h>
+#include "rank.h"
+
+/* Upper bound for the number of histogram states which are tabulated */
+#define RANK_CONTEXT_MAX_STATES ((size_t)1 << 20)
+#define RANK_CONTEXT_MAX_STATES_MPZ ((size_t)1 << 18)
+
+typedef struct __rank_context_struct {
+    size_t atoms;
+    size_t species;
+    size_t *hist;
+    size_t *strides;
+    size_t states;
+    bool wide;
+    uint128_t count;
+    mpz_t permutations;
+    uint128_t *table;
+    mpz_t *table_mpz;
+} rank_context_t;
+
+rank_context_t* rank_context_init(size_t atoms, size_t *hist, size_t species);
+rank_context_t* rank_context_from_configuration(uint8_t *configuration, size_t atoms);
+void rank_context_destroy(rank_context_t* ctx);
+void rank_context_count_mpz(rank_context_t* ctx, mpz_t result);
+void rank_context_rank_mpz(rank_context_t* ctx, mpz_t result, uint8_t *configuration);
+void rank_context_unrank_mpz(rank_context_t* ctx, uint8_t *configuration, mpz_t rank);
+uint64_t rank_context_partition(rank_context_t* ctx, uint8_t *configuration, uint64_t index, uint64_t chunks);
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef READER_H
+#define READER_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#define READER_SYMBOL_LENGTH 8
+#define READER_MAX_SPECIES 255
+
+/*
+ * Flat arrays of a periodic structure. The lattice vectors are the rows of lattice, every site has three fractional
+ * coordinates and the index of its species in symbols. The files are read line by line, no per site objects are made.
+ */
+typedef struct __reader_structure_struct {
+    size_t atoms;
+    size_t species;
+    double lattice[9];
+    double* frac_coords;
+    uint8_t* site_species;
+    char symbols[READER_MAX_SPECIES][READER_SYMBOL_LENGTH];
+} reader_structure_t;
+
+reader_structure_t* reader_read_poscar(const char* path);
+reader_structure_t* reader_read_xyz(const char* path);
+void reader_expand(double* frac_coords, size_t atoms, size_t* multiples, double* result);
+void reader_structure_destroy(reader_structure_t* s);
+
+#endif
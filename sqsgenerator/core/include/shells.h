@@ -0,0 +1,26 @@
+#ifndef SHELLS_H
+#define SHELLS_H
+
+#include <stdlib.h>
+#include <stdint.h>
+#include "neighbors.h"
+
+/*
+ * Coordination shells of a neighbor list. The distances of the selected rows are sorted and clustered in one pass, a
+ * distance starts a new shell if it is not close to the smallest distance of the current one. Radius k is the smallest
+ * distance of shell k + 1, shell 0 marks pairs which belong to no shell.
+ */
+typedef struct __shell_table_struct {
+    size_t count;
+    double rel_tol;
+    double* radii;
+} shell_table_t;
+
+shell_table_t* shell_table_init(neighbor_list_t* nl, size_t* rows, size_t nrows, double rel_tol);
+void shell_table_truncate(shell_table_t* st, size_t count);
+uint8_t shell_table_find(shell_table_t* st, double distance);
+void shell_table_classify(shell_table_t* st, neighbor_list_t* nl, size_t i, uint8_t* row, size_t* counts);
+void shell_table_classify_pairs(shell_table_t* st, neighbor_list_t* nl, size_t i, uint8_t* shells, size_t* counts);
+void shell_table_destroy(shell_table_t* st);
+
+#endif
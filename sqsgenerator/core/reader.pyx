@@ -0,0 +1,188 @@
+import numpy as np
+cimport numpy as np
+import os
+cimport sqsgenerator.core.utils as utils
+from sqsgenerator.core.utils cimport reader_structure_t
+from libc.stdint cimport uint8_t
+from libc.string cimport memcpy
+from sqsgenerator.utils.utils import is_valid_symbol
+
+# Extensions of the extended XYZ files and of the formats only pymatgen reads, any other file is tried as POSCAR
+XYZ_EXTENSIONS = ('.xyz', '.extxyz')
+FALLBACK_EXTENSIONS = ('.cif', '.cssr', '.xml')
+
+
+cdef class Cell:
+    """
+    A periodic structure as flat arrays, the lattice vectors as rows, the fractional coordinates and the index of the
+    species of every site. It is all an iterator needs, a :class:`pymatgen.Structure` is only made for the output
+    """
+
+    cdef readonly object lattice
+    cdef readonly object frac_coords
+    cdef readonly object species
+    cdef readonly tuple symbols
+
+    def __cinit__(self, lattice, frac_coords, species, symbols):
+        self.lattice = np.ascontiguousarray(lattice, dtype=np.float64).reshape(3, 3)
+        self.frac_coords = np.ascontiguousarray(frac_coords, dtype=np.float64).reshape(-1, 3)
+        self.species = np.ascontiguousarray(species, dtype=np.uint8)
+        self.symbols = tuple(symbols)
+        if len(self.species) != len(self.frac_coords):
+            raise ValueError('Every site needs a species')
+
+    def __len__(self):
+        return len(self.species)
+
+    @property
+    def site_symbols(self):
+        """
+        The element of every site
+
+        Returns:
+            list: A list of ``len(self)`` element symbols
+        """
+        return [self.symbols[s] for s in self.species]
+
+    def select(self, indices):
+        """
+        The cell of the sites ``indices`` in the same lattice
+
+        Args:
+            indices (list): The site indices in the order of the new cell
+
+        Returns:
+            Cell: The smaller cell
+        """
+        indices = np.asarray(indices, dtype=np.intp)
+        return Cell(self.lattice, self.frac_coords[indices], self.species[indices], self.symbols)
+
+    def supercell(self, multiples):
+        """
+        Stacks the cell ``multiples[0] x multiples[1] x multiples[2]`` times in the site order of
+        :func:`sqsgenerator.core.base.make_supercell`
+
+        Args:
+            multiples (tuple): The number of unit cells along each lattice vector
+
+        Returns:
+            Cell: The supercell
+        """
+        cdef size_t[::1] m = np.ascontiguousarray(multiples, dtype=np.uintp)
+        cdef size_t atoms = len(self)
+        cdef size_t cells = m[0] * m[1] * m[2]
+        cdef double[:, ::1] frac_coords = self.frac_coords
+        cdef double[:, ::1] result = np.empty((atoms * cells, 3), dtype=np.float64)
+        if atoms > 0 and cells > 0:
+            with nogil:
+                utils.reader_expand(&frac_coords[0, 0], atoms, &m[0], &result[0, 0])
+        lattice = self.lattice * np.asarray(multiples, dtype=np.float64)[:, None]
+        return Cell(lattice, np.asarray(result), np.repeat(self.species, cells), self.symbols)
+
+    def to_structure(self):
+        """
+        Converts the cell into a structure, pymatgen is imported on the first call
+
+        Returns:
+            :class:`pymatgen.Structure`: The structure
+        """
+        from pymatgen import Structure
+        return Structure(self.lattice, self.site_symbols, self.frac_coords)
+
+    @staticmethod
+    def from_structure(structure):
+        """
+        Copies the arrays of a structure
+
+        Args:
+            structure (:class:`pymatgen.Structure`): The structure
+
+        Returns:
+            Cell: The cell
+        """
+        names = [site.specie.symbol for site in structure.sites]
+        symbols = list(dict.fromkeys(names))
+        index = {symbol: i for i, symbol in enumerate(symbols)}
+        return Cell(structure.lattice.matrix, structure.frac_coords, [index[name] for name in names], symbols)
+
+
+cdef Cell cell_from_reader(reader_structure_t *s):
+    cdef size_t atoms = s.atoms
+    cdef double[:, ::1] lattice = np.empty((3, 3), dtype=np.float64)
+    cdef double[:, ::1] frac_coords = np.empty((atoms, 3), dtype=np.float64)
+    cdef uint8_t[::1] species = np.empty((atoms,), dtype=np.uint8)
+    memcpy(&lattice[0, 0], s.lattice, sizeof(double) * 9)
+    if atoms > 0:
+        memcpy(&frac_coords[0, 0], s.frac_coords, sizeof(double) * 3 * atoms)
+        memcpy(&species[0], s.site_species, sizeof(uint8_t) * atoms)
+    symbols = [s.symbols[k].decode('ascii') for k in range(s.species)]
+    return Cell(np.asarray(lattice), np.asarray(frac_coords), np.asarray(species), symbols)
+
+
+def read_structure(path):
+    """
+    Reads a POSCAR or an extended XYZ file without pymatgen
+
+    Args:
+        path (str): The path of the file
+
+    Returns:
+        Cell: The cell, None if the format is not one of the two, the file could not be read natively or a species is no
+        element (a VASP 4 comment line which does not list the species)
+    """
+    cdef Cell cell
+    cdef reader_structure_t *s
+    cdef bytes encoded = os.fsencode(path)
+    cdef const char *c_path = encoded
+    name = os.path.basename(path)
+    extension = os.path.splitext(name)[1].lower()
+    if extension in XYZ_EXTENSIONS:
+        with nogil:
+            s = utils.reader_read_xyz(c_path)
+    elif extension not in FALLBACK_EXTENSIONS:
+        with nogil:
+            s = utils.reader_read_poscar(c_path)
+    else:
+        return None
+    if s is NULL:
+        return None
+    try:
+        cell = cell_from_reader(s)
+    finally:
+        utils.reader_structure_destroy(s)
+    return cell if all(is_valid_symbol(symbol) for symbol in cell.symbols) else None
+
+
+def as_cell(structure):
+    """
+    Args:
+        structure (Cell or :class:`pymatgen.Structure`): The structure
+
+    Returns:
+        Cell: The structure itself if it already is a cell
+    """
+    return structure if isinstance(structure, Cell) else Cell.from_structure(structure)
+
+
+def as_structure(structure):
+    """
+    Args:
+        structure (Cell or :class:`pymatgen.Structure`): The structure
+
+    Returns:
+        :class:`pymatgen.Structure`: The structure itself if it is no cell
+    """
+    return structure.to_structure() if isinstance(structure, Cell) else structure
+
+
+def site_symbols(structure):
+    """
+    Args:
+        structure (Cell or :class:`pymatgen.Structure`): The structure
+
+    Returns:
+        list: The element of every site
+    """
+    if isinstance(structure, Cell):
+        return structure.site_symbols
+    return [site.specie.symbol for site in structure.sites]
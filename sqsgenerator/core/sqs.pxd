@@ -1,12 +1,20 @@
 from libc.stdint cimport uint8_t, uint32_t, uint64_t
 cimport sqsgenerator.core.base
+from sqsgenerator.core.collection cimport ConfigurationCollection
+from sqsgenerator.core.utils cimport binary_sqs_t
 
 cdef class SqsIterator(sqsgenerator.core.base.BaseIterator):
 
     cdef double[:, :] constant_factor_matrix
     cdef double *constant_factor_matrix_ptr
+    # Factor of every shell id, the low memory kernel uses it instead of the matrix
+    cdef double[::1] shell_factors
+    cdef binary_sqs_t *binary_engine
 
     cdef double[:, :] make_constant_factor_matrix(self)
+    cdef binary_sqs_t* make_binary_engine(self)
+    cdef tuple binary_iteration(self, iterations, output_structures, double objective_value, size_t num_threads, list thread_evaluations, bint degeneracy, bint ranked)
     cdef alpha_to_dict(self, double[:, :, :]  alpha_decomposition)
+    cdef result_decomposition(self, ConfigurationCollection collection, size_t index)
     cdef double calculate_parameter(self, uint8_t* configuration, double *constant_factor_matrix, double* alpha_decomposition) nogil
     cdef void reset_alpha_results(self, double* alpha_decomposition) nogil
\ No newline at end of file
@@ -1,16 +1,17 @@
 from libc.stdint cimport uint8_t, uint32_t, uint64_t
 from libc.string cimport memset
-from libc.stdlib cimport malloc, free
+from libc.stdlib cimport malloc, calloc, free
 from libc.math cimport fabs
-from sqsgenerator.core.utils cimport next_permutation_lex, knuth_fisher_yates_shuffle, reseed_xor, unrank_permutation
+from sqsgenerator.core.utils cimport next_permutation_lex, knuth_fisher_yates_shuffle, rank_context_partition
+from sqsgenerator.core.utils cimport philox_t, philox_init
+from sqsgenerator.core.utils cimport arena_t, arena_alloc, arena_reset
+from sqsgenerator.core.utils cimport uint128_t, binary_sqs_t, BINARY_MAX_ATOMS, binary_sqs_init, binary_sqs_destroy, binary_sqs_objective, binary_random_mask, binary_next_mask, binary_partition, binary_mask_to_configuration
 from sqsgenerator.core.collection cimport ConfigurationCollection
 cimport numpy as np
 cimport cython
 cimport base
 cimport openmp
-from collections import Counter
-from cython.parallel import parallel
-from math import factorial
+from cython.parallel import parallel, prange
 import time
 import multiprocessing
 import numpy as np
@@ -18,8 +19,6 @@ import numpy as np
 cdef extern from '<float.h>':
     cdef double DBL_MAX
 
-ctypedef bint (*next_permutation_function) (uint8_t *configuration, size_t atoms) nogil
-
 cdef class SqsIterator(base.BaseIterator):
 
     #cdef double[:, :] constant_factor_matrix
@@ -27,29 +26,56 @@ cdef class SqsIterator(base.BaseIterator):
 
     def __cinit__(self, structure, dict mole_fractions, dict weights, verbosity=0, **kwargs):
         #super(SqsIterator, self).__cinit__(structure, mole_fractions, weights, verbosity=verbosity)
-        self.constant_factor_matrix = self.make_constant_factor_matrix()
-        self.constant_factor_matrix_ptr = <double*> &self.constant_factor_matrix[0, 0]
+        if self.low_memory:
+            # All pairs of a shell share their factor, the sparse kernel looks it up by the shell id of the pair
+            self.shell_factors = self.make_shell_factors()
+            self.constant_factor_matrix_ptr = <double*> &self.shell_factors[0]
+        else:
+            self.constant_factor_matrix = self.make_constant_factor_matrix()
+            self.constant_factor_matrix_ptr = <double*> &self.constant_factor_matrix[0, 0]
+        self.binary_engine = self.make_binary_engine()
+
+    def __dealloc__(self):
+        binary_sqs_destroy(self.binary_engine)
+
+    cdef binary_sqs_t* make_binary_engine(self):
+        """
+        Builds the bitmask engine for binary cells with at most 128 atoms. The constant factors of a shell are the same
+        for all pairs, therefore only one factor and target value per shell is needed
+
+        Returns:
+            A pointer to the engine or NULL if the cell is not binary or too large
+        """
+        cdef size_t s = 0
+
+        if self.species_count != 2 or self.atoms > BINARY_MAX_ATOMS or self.shell_count == 0 or self.low_memory:
+            return NULL
+        if self.composition_hist[0] == 0 or self.composition_hist[1] == 0:
+            return NULL
+
+        cdef double[::1] constant_factors = self.make_shell_factors()
+        cdef double[::1] shell_factors = np.zeros((self.shell_count,))
+        cdef double[::1] shell_targets = np.zeros((self.shell_count,))
+        for s in range(self.shell_count):
+            shell_factors[s] = constant_factors[s + 1] / (self.mole_fractions_ptr[0] * self.mole_fractions_ptr[1])
+            shell_targets[s] = self.weights_ptr[s] / 2
+
+        return binary_sqs_init(self.atoms, self.composition_hist[1], self.shell_count, self.shell_number_matrix_ptr,
+                               &shell_factors[0], &shell_targets[0])
 
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
     cdef double[:, :] make_constant_factor_matrix(self):
-        cdef double[:, :] constant_factor_matrix = np.ascontiguousarray(np.zeros((self.atoms, self.atoms)))
-
+        cdef double[:, ::1] constant_factor_matrix = np.ascontiguousarray(np.zeros((self.atoms, self.atoms)))
+        cdef double[::1] shell_factors = self.make_shell_factors()
         cdef Py_ssize_t i = 0, j = 0
-        cdef double weight
-        cdef double value
-        cdef uint8_t shell
-
-        for i in range(self.atoms):
-            for j in range(i, self.atoms):
-                if i == j:
-                    constant_factor_matrix[i, j] = 0.0
-                    continue
-                if i != j:
-                    shell = self.shell_number_matrix[i,j]
-                    weight = self.weights[shell] if shell in self.weights else 0.0
-                    value = weight / (2* self.shell_neighbor_mapping[shell] * self.atoms) if shell in self.weights else 0.0
+        cdef Py_ssize_t atoms = self.atoms
 
-                    constant_factor_matrix[i, j] = value
-                    constant_factor_matrix[j, i] = value
+        # Every row is looked up from the shell ids, the diagonal belongs to shell 0 and stays 0
+        with nogil, parallel(num_threads=openmp.omp_get_max_threads()):
+            for i in prange(atoms, schedule='static'):
+                for j in range(atoms):
+                    constant_factor_matrix[i, j] = shell_factors[self.shell_number_matrix_ptr[i * atoms + j]]
 
         return constant_factor_matrix
 
@@ -57,7 +83,11 @@ cdef class SqsIterator(base.BaseIterator):
     @cython.wraparound(False)
     @cython.cdivision(True)
     cdef double calculate_parameter(self, uint8_t* configuration, double *constant_factor_matrix, double* alpha_decomposition) nogil:
-        cdef size_t i = 0, j = 0, k = 0
+        """
+        Computes the objective of a configuration. With a low memory geometry ``constant_factor_matrix`` holds the
+        factors by shell id and only the pairs of the neighbor list are visited
+        """
+        cdef size_t i = 0, j = 0, k = 0, p = 0
         cdef uint8_t current_species
         cdef uint8_t compare_species
         cdef uint8_t shell
@@ -67,17 +97,33 @@ cdef class SqsIterator(base.BaseIterator):
 
         cdef int d1 = self.species_count * self.species_count, d2 = self.species_count
 
-        for i in range(self.atoms):
-            compare_species = configuration[i]
-            for j in range(i, self.atoms):
-                current_species = configuration[j]
-                shell = self.shell_number_matrix_ptr[i * self.atoms + j] - 1
-                if current_species != compare_species and -1 < shell <= self.shell_count - 1:
-                    current_bond_ratio = alpha_decomposition[shell * d1 + compare_species * d2 + current_species]
-                    current_bond_ratio += constant_factor_matrix[i * self.atoms + j] / (
-                            self.mole_fractions_ptr[current_species] * self.mole_fractions_ptr[compare_species])
-                    alpha_decomposition[shell * d1 + compare_species * d2 + current_species] = current_bond_ratio
-                    alpha_decomposition[shell * d1 + current_species * d2 + compare_species] = current_bond_ratio
+        if self.low_memory:
+            for i in range(self.atoms):
+                compare_species = configuration[i]
+                for p in range(self.neighbors.offsets[i], self.neighbors.offsets[i + 1]):
+                    j = self.neighbors.indices[p]
+                    if j <= i:
+                        continue
+                    current_species = configuration[j]
+                    shell = self.pair_shells_ptr[p] - 1
+                    if current_species != compare_species and -1 < shell <= self.shell_count - 1:
+                        current_bond_ratio = alpha_decomposition[shell * d1 + compare_species * d2 + current_species]
+                        current_bond_ratio += constant_factor_matrix[shell + 1] / (
+                                self.mole_fractions_ptr[current_species] * self.mole_fractions_ptr[compare_species])
+                        alpha_decomposition[shell * d1 + compare_species * d2 + current_species] = current_bond_ratio
+                        alpha_decomposition[shell * d1 + current_species * d2 + compare_species] = current_bond_ratio
+        else:
+            for i in range(self.atoms):
+                compare_species = configuration[i]
+                for j in range(i, self.atoms):
+                    current_species = configuration[j]
+                    shell = self.shell_number_matrix_ptr[i * self.atoms + j] - 1
+                    if current_species != compare_species and -1 < shell <= self.shell_count - 1:
+                        current_bond_ratio = alpha_decomposition[shell * d1 + compare_species * d2 + current_species]
+                        current_bond_ratio += constant_factor_matrix[i * self.atoms + j] / (
+                                self.mole_fractions_ptr[current_species] * self.mole_fractions_ptr[compare_species])
+                        alpha_decomposition[shell * d1 + compare_species * d2 + current_species] = current_bond_ratio
+                        alpha_decomposition[shell * d1 + current_species * d2 + compare_species] = current_bond_ratio
 
         for i in range(self.shell_count):
             for j in range(self.species_count):
@@ -90,14 +136,17 @@ cdef class SqsIterator(base.BaseIterator):
 
         return alpha
 
-    def iteration(self, iterations=100000, output_structures=10, objective=0.0):
+    def iteration(self, iterations=100000, output_structures=10, objective=0.0, degeneracy=False, ranked=False):
         #Definition
         cdef double best_alpha
         cdef double alpha
         cdef double objective_value
         cdef double *alpha_decomposition_ptr
-        cdef bint all_output_structures_flag = output_structures == 'all'
-        cdef ConfigurationCollection collection
+        cdef uint64_t c_iterations
+        cdef uint64_t chunk_iterations
+        cdef Py_ssize_t chunk
+        cdef philox_t rng
+        cdef ConfigurationCollection shared_collection
 
         if objective == float('inf'):
             objective_value = DBL_MAX
@@ -111,25 +160,21 @@ cdef class SqsIterator(base.BaseIterator):
 
         cdef size_t i = 0, j = 0, k = 0
 
-        shared_collection = ConfigurationCollection(output_structures if not all_output_structures_flag else 0, self.atoms, self.shell_count, self.species_count)
+        if self.binary_engine != NULL:
+            return self.binary_iteration(iterations, output_structures, objective_value, 1, None, degeneracy, ranked)
+
+        shared_collection = self.make_collection(iterations, output_structures, degeneracy, 1, 1, ranked)
 
         self.reset_alpha_results(alpha_decomposition_ptr)
         best_alpha = 1e15
 
         if iterations == 'all':
-            self.sort_numpy(self.configuration)
-            composition = dict(Counter(np.asarray(self.configuration)))
-
-            total_iterations = factorial(self.atoms)
-            current_iteration = 0
-            for species, amount in composition.items():
-                total_iterations = total_iterations/factorial(amount)
-            print('Configurations to check: {0}'.format(round(total_iterations)))
-            iterations = total_iterations
+            total_iterations = self.permutation_count()
+            print('Configurations to check: {0}'.format(total_iterations))
             t0 = time.time()
-            #Set to frist configuration
-            unrank_permutation(self.configuration_ptr, self.atoms, self.composition_hist_ptr, self.species_count, iterations, 1)
-            for i in range(iterations):
+            #Set to first configuration, the single chunk spans the whole (exact) rank range
+            c_iterations = rank_context_partition(self.rank_context, self.configuration_ptr, 0, 1)
+            for i in range(c_iterations):
                 alpha = self.calculate_parameter(self.configuration_ptr, self.constant_factor_matrix_ptr, alpha_decomposition_ptr)
 
                 if objective_value == -DBL_MAX:
@@ -141,26 +186,31 @@ cdef class SqsIterator(base.BaseIterator):
 
                 if alpha <= shared_collection.best_objective():
                     shared_collection.add(alpha, self.configuration_ptr, alpha_decomposition_ptr)
-                    reseed_xor()
                 self.reset_alpha_results(alpha_decomposition_ptr)
                 next_permutation_lex(self.configuration_ptr, self.atoms)
         else:
             t0 = time.time()
-            for i in range(iterations):
-                knuth_fisher_yates_shuffle(self.configuration_ptr, self.atoms)
-                alpha = self.calculate_parameter(self.configuration_ptr, self.constant_factor_matrix_ptr, alpha_decomposition_ptr)
-
-                if objective_value == -DBL_MAX:
-                    pass
-                elif objective_value == DBL_MAX:
-                    alpha = -alpha
-                else:
-                    alpha = fabs(alpha-objective_value)
-
-                if alpha <= shared_collection.best_objective():
-                    shared_collection.add(alpha, self.configuration_ptr, alpha_decomposition_ptr)
-                    reseed_xor()
-                self.reset_alpha_results(alpha_decomposition_ptr)
+            c_iterations = iterations
+            # The chunks of the parallel iterator in order, a seed draws the same configurations on any number of
+            # threads. The shuffles of a chunk start from the first configuration
+            for chunk in range(base.RANDOM_CHUNKS):
+                chunk_iterations = (c_iterations / base.RANDOM_CHUNKS) + (1 if <uint64_t>chunk < c_iterations % base.RANDOM_CHUNKS else 0)
+                philox_init(&rng, self.seed, chunk)
+                rank_context_partition(self.rank_context, self.configuration_ptr, 0, 1)
+                for i in range(chunk_iterations):
+                    knuth_fisher_yates_shuffle(&rng, self.configuration_ptr, self.atoms)
+                    alpha = self.calculate_parameter(self.configuration_ptr, self.constant_factor_matrix_ptr, alpha_decomposition_ptr)
+
+                    if objective_value == -DBL_MAX:
+                        pass
+                    elif objective_value == DBL_MAX:
+                        alpha = -alpha
+                    else:
+                        alpha = fabs(alpha-objective_value)
+
+                    if alpha <= shared_collection.best_objective():
+                        shared_collection.add(alpha, self.configuration_ptr, alpha_decomposition_ptr)
+                    self.reset_alpha_results(alpha_decomposition_ptr)
 
         total = time.time() - t0
 
@@ -169,13 +219,104 @@ cdef class SqsIterator(base.BaseIterator):
             #assert isclose(shared_collection.best_objective, fabs(self.calculate_parameter_ptr(conf_collection_get_conf(shared_collection, i), self.sqs_constant_factor_matrix, &alpha_decomposition[0,0,0])))
             #self.reset_alpha_results(alpha_decomposition)
 
-        structure_list = [self.configuration_to_structure(<uint8_t[:self.atoms]>shared_collection.get_configuration(i)) for i in range(shared_collection.size())]
-        decomp_list = [self.alpha_to_dict(np.asarray(<double[:self.shell_count, :self.species_count, :self.species_count]>shared_collection.get_decomposition(i))) for i in range(shared_collection.size())]
+        self.report_degeneracy(shared_collection)
+        structure_list, decomp_list = self.make_results(shared_collection, output_structures)
 
         lps = total_iterations if iterations == 'all' else iterations
 
         return structure_list, decomp_list, lps, total/lps
 
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    @cython.cdivision(True)
+    cdef tuple binary_iteration(self, iterations, output_structures, double objective_value, size_t num_threads, list thread_evaluations, bint degeneracy, bint ranked):
+        """
+        Main loop for binary cells. Configurations are bitmasks, the exhaustive mode walks them with Gosper's hack in
+        lexicographical order, the random mode draws them directly. The byte configuration and the decomposition are
+        only built for candidates which enter the collection
+        """
+        cdef int thread_id
+        cdef bint all_flag = iterations == 'all'
+        cdef uint64_t local_iterations
+        cdef uint64_t c_iterations = 0
+        cdef uint64_t j = 0
+        cdef size_t i = 0
+        cdef Py_ssize_t chunk
+        cdef Py_ssize_t chunk_count = num_threads * base.CHUNKS_PER_THREAD if all_flag else base.RANDOM_CHUNKS
+        cdef uint64_t *local_thread_evaluations
+        cdef uint128_t local_mask
+        cdef philox_t* local_rng
+        cdef uint8_t* local_configuration
+        cdef double local_alpha
+        cdef double* local_alpha_decomposition
+        cdef size_t decomposition_size = sizeof(double)*self.shell_count*self.species_count*self.species_count
+        cdef arena_t **scratch = self.make_scratch(num_threads, sizeof(uint8_t)*self.atoms + decomposition_size + sizeof(philox_t))
+        cdef ConfigurationCollection shared_collection
+
+        shared_collection = self.make_collection(iterations, output_structures, degeneracy, num_threads, 1, ranked)
+        local_thread_evaluations = <uint64_t*>calloc(num_threads, sizeof(uint64_t))
+
+        if all_flag:
+            total_iterations = self.permutation_count()
+            print('Configurations to check: {0}'.format(total_iterations))
+        else:
+            c_iterations = iterations
+        t0 = time.time()
+        with nogil, parallel(num_threads=num_threads):
+
+            thread_id = openmp.omp_get_thread_num()
+            # Buffers come from the threads arena which is kept across runs
+            arena_reset(scratch[thread_id])
+            local_configuration = <uint8_t*>arena_alloc(scratch[thread_id], sizeof(uint8_t)*self.atoms)
+            local_alpha_decomposition = <double*>arena_alloc(scratch[thread_id], decomposition_size)
+            local_rng = <philox_t*>arena_alloc(scratch[thread_id], sizeof(philox_t))
+
+            for chunk in prange(chunk_count, schedule='dynamic'):
+                local_mask = 0
+                if all_flag:
+                    local_iterations = binary_partition(self.binary_engine, &local_mask, chunk, chunk_count)
+                else:
+                    local_iterations = (c_iterations / chunk_count) + (1 if <uint64_t>chunk < c_iterations % chunk_count else 0)
+                    # Every chunk draws from its own stream, the results depend neither on which thread runs it nor
+                    # on the number of threads
+                    philox_init(local_rng, self.seed, chunk)
+
+                for j in range(local_iterations):
+                    if not all_flag:
+                        local_mask = binary_random_mask(self.binary_engine, local_rng)
+                    local_alpha = binary_sqs_objective(self.binary_engine, local_mask, NULL)
+
+                    if objective_value == -DBL_MAX:
+                        pass
+                    elif objective_value == DBL_MAX:
+                        local_alpha = -local_alpha
+                    else:
+                        local_alpha = fabs(local_alpha-objective_value)
+
+                    if local_alpha <= shared_collection.best_objective():
+                        binary_mask_to_configuration(self.binary_engine, local_mask, local_configuration)
+                        binary_sqs_objective(self.binary_engine, local_mask, local_alpha_decomposition)
+                        shared_collection.add(local_alpha, local_configuration, local_alpha_decomposition)
+                    if all_flag:
+                        binary_next_mask(self.binary_engine, &local_mask)
+                local_thread_evaluations[thread_id] = local_thread_evaluations[thread_id] + local_iterations
+
+        total = time.time()-t0
+
+        if thread_evaluations is not None:
+            thread_evaluations.extend([local_thread_evaluations[i] for i in range(num_threads)])
+        free(local_thread_evaluations)
+
+        self.report_degeneracy(shared_collection)
+        structure_list, decomp_list = self.make_results(shared_collection, output_structures)
+
+        lps = total_iterations if all_flag else iterations
+
+        return structure_list, decomp_list, lps, total/lps
+
+    cdef result_decomposition(self, ConfigurationCollection collection, size_t index):
+        return self.alpha_to_dict(np.asarray(<double[:self.shell_count, :self.species_count, :self.species_count]>collection.get_decomposition(index)))
+
     cdef alpha_to_dict(self, double[:, :, :]  alpha_decomposition):
         rearranged_alphas = {}
         cdef size_t i = 0, j = 0, k = 0
@@ -197,13 +338,7 @@ cdef class SqsIterator(base.BaseIterator):
         memset(alpha_decomposition, 0, sizeof(double) * self.shell_count * self.species_count * self.species_count)
 
     def calculate_alpha(self):
-        cdef int species_count = len(
-            set(
-                list(
-                    map(lambda site: site.specie.name, self.structure.sites)
-                )
-            )
-        )
+        cdef int species_count = len(set(self.cell.site_symbols))
         cdef size_t old_species_count = self.species_count
         self.species_count = species_count
         cdef double alpha
@@ -226,95 +361,101 @@ cdef class SqsIterator(base.BaseIterator):
 cdef class ParallelSqsIterator(SqsIterator):
 
     cdef size_t num_threads
+    cdef readonly list thread_evaluations
 
-    def __cinit__(self, structure, dict mole_fractions, dict weights, verbosity=0, num_threads=multiprocessing.cpu_count()):
+    def __cinit__(self, structure, dict mole_fractions, dict weights, verbosity=0, num_threads=multiprocessing.cpu_count(), **kwargs):
         self.num_threads = num_threads
 
     @cython.boundscheck(False)
-    def iteration(self, iterations=100000, output_structures=10, objective=0.0):
+    def iteration(self, iterations=100000, output_structures=10, objective=0.0, degeneracy=False, ranked=False):
         #Definition
         cdef int thread_id
         cdef bint all_flag = iterations == 'all'
-        cdef bint all_output_structures_flag = output_structures == 'all'
-        cdef uint64_t permutations
-        cdef uint64_t start_permutation
-        cdef uint64_t end_permutation
-        cdef uint64_t c_iterations
+        cdef uint64_t local_iterations
+        cdef uint64_t c_iterations = 0
+        cdef Py_ssize_t chunk
+        cdef Py_ssize_t chunk_count = self.num_threads * base.CHUNKS_PER_THREAD if all_flag else base.RANDOM_CHUNKS
+        cdef uint64_t *thread_evaluations
         cdef uint8_t* local_configuration
         cdef size_t i = 0, j = 0, k = 0
         cdef double local_alpha
         cdef double objective_value = DBL_MAX if objective == float('inf') else (-DBL_MAX if objective == float('-inf') else objective)
         cdef double* local_alpha_decomposition
-        cdef ConfigurationCollection collection
-        cdef next_permutation_function next_permutation_function_ptr
-
-        shared_collection = ConfigurationCollection(output_structures if not all_output_structures_flag else 0, self.atoms, self.shell_count, self.species_count)
+        cdef size_t decomposition_size = sizeof(double)*self.shell_count*self.species_count*self.species_count
+        cdef arena_t **scratch
+        cdef philox_t* local_rng
+        cdef ConfigurationCollection shared_collection
 
         openmp.omp_set_num_threads(self.num_threads)
         print('Threads used: {}'.format(self.num_threads))
+        if self.binary_engine != NULL:
+            self.thread_evaluations = []
+            result = self.binary_iteration(iterations, output_structures, objective_value, self.num_threads, self.thread_evaluations, degeneracy, ranked)
+            if self.verbosity:
+                print('Evaluations per thread: {}'.format(self.thread_evaluations))
+            return result
+
+        shared_collection = self.make_collection(iterations, output_structures, degeneracy, self.num_threads, 1, ranked)
+        scratch = self.make_scratch(self.num_threads, sizeof(uint8_t)*self.atoms + decomposition_size + sizeof(philox_t))
+        thread_evaluations = <uint64_t*>calloc(self.num_threads, sizeof(uint64_t))
+
         if iterations == 'all':
-            self.sort_numpy(self.configuration)
-            composition = dict(Counter(np.asarray(self.configuration)))
-            total_iterations = factorial(self.atoms)
-            current_iteration = 0
-            for species, amount in composition.items():
-                total_iterations = total_iterations/factorial(amount)
-            print('Configurations to check: {0}'.format(int(total_iterations)))
-            permutations = total_iterations
+            total_iterations = self.permutation_count()
+            print('Configurations to check: {0}'.format(total_iterations))
         else:
             c_iterations = iterations
         t0 = time.time()
         with nogil, parallel():
 
             thread_id = openmp.omp_get_thread_num()
-            local_configuration = <uint8_t*>malloc(sizeof(uint8_t)*self.atoms)
-            local_alpha_decomposition = <double*>malloc(sizeof(double)*self.shell_count*self.species_count*self.species_count)
-
-            for i in range(self.atoms):
-                local_configuration[i] = self.configuration[i]
+            # Buffers come from the threads arena which is kept across runs
+            arena_reset(scratch[thread_id])
+            local_configuration = <uint8_t*>arena_alloc(scratch[thread_id], sizeof(uint8_t)*self.atoms)
+            local_alpha_decomposition = <double*>arena_alloc(scratch[thread_id], decomposition_size)
+            local_rng = <philox_t*>arena_alloc(scratch[thread_id], sizeof(philox_t))
             self.reset_alpha_results(local_alpha_decomposition)
 
-            start_permutation = thread_id*(permutations if all_flag else c_iterations)/self.num_threads
-            end_permutation = (thread_id+1)*(permutations if all_flag else c_iterations)/self.num_threads+1
-
-            if thread_id+1 == self.num_threads:
-                end_permutation = permutations if all_flag else c_iterations
-            if thread_id == 0:
-                start_permutation = 1
-
-            if all_flag:
-                next_permutation_function_ptr = next_permutation_lex
-            else:
-                next_permutation_function_ptr = knuth_fisher_yates_shuffle
-
-            if all_flag:
-                unrank_permutation(local_configuration, self.atoms, self.composition_hist_ptr, self.species_count, permutations, start_permutation)
-            else:
-                knuth_fisher_yates_shuffle(local_configuration, self.atoms)
-
-            for j in range(start_permutation, end_permutation):
-                local_alpha = self.calculate_parameter(local_configuration, self.constant_factor_matrix_ptr, local_alpha_decomposition)
-
-                if objective_value == -DBL_MAX:
-                    pass
-                elif objective_value == DBL_MAX:
-                    local_alpha = -local_alpha
+            # Idle threads fetch the next chunk from the shared OpenMP counter
+            for chunk in prange(chunk_count, schedule='dynamic'):
+                if all_flag:
+                    # Exact slice of the rank range, also for compositions with more than 2^64 configurations
+                    local_iterations = rank_context_partition(self.rank_context, local_configuration, chunk, chunk_count)
                 else:
-                    local_alpha = fabs(local_alpha-objective_value)
-
-                if local_alpha <= shared_collection.best_objective():
-                    shared_collection.add(local_alpha, local_configuration, local_alpha_decomposition)
-                    reseed_xor()
-                self.reset_alpha_results(local_alpha_decomposition)
-                next_permutation_function_ptr(local_configuration, self.atoms)
-
-            free(local_configuration)
-            free(local_alpha_decomposition)
+                    local_iterations = (c_iterations / chunk_count) + (1 if <uint64_t>chunk < c_iterations % chunk_count else 0)
+                    # Every chunk draws from its own stream, the results depend neither on which thread runs it nor
+                    # on the number of threads
+                    philox_init(local_rng, self.seed, chunk)
+                    rank_context_partition(self.rank_context, local_configuration, 0, 1)
+                    knuth_fisher_yates_shuffle(local_rng, local_configuration, self.atoms)
+
+                for j in range(local_iterations):
+                    local_alpha = self.calculate_parameter(local_configuration, self.constant_factor_matrix_ptr, local_alpha_decomposition)
+
+                    if objective_value == -DBL_MAX:
+                        pass
+                    elif objective_value == DBL_MAX:
+                        local_alpha = -local_alpha
+                    else:
+                        local_alpha = fabs(local_alpha-objective_value)
+
+                    if local_alpha <= shared_collection.best_objective():
+                        shared_collection.add(local_alpha, local_configuration, local_alpha_decomposition)
+                    self.reset_alpha_results(local_alpha_decomposition)
+                    if all_flag:
+                        next_permutation_lex(local_configuration, self.atoms)
+                    else:
+                        knuth_fisher_yates_shuffle(local_rng, local_configuration, self.atoms)
+                thread_evaluations[thread_id] = thread_evaluations[thread_id] + local_iterations
 
         total = time.time()-t0
 
-        structure_list = [self.configuration_to_structure(<uint8_t[:self.atoms]>shared_collection.get_configuration(i)) for i in range(shared_collection.size())]
-        decomp_list = [self.alpha_to_dict(np.asarray(<double[:self.shell_count, :self.species_count, :self.species_count]>shared_collection.get_decomposition(i))) for i in range(shared_collection.size())]
+        self.thread_evaluations = [thread_evaluations[i] for i in range(self.num_threads)]
+        free(thread_evaluations)
+        if self.verbosity:
+            print('Evaluations per thread: {}'.format(self.thread_evaluations))
+
+        self.report_degeneracy(shared_collection)
+        structure_list, decomp_list = self.make_results(shared_collection, output_structures)
 
         lps = total_iterations if iterations == 'all' else iterations
 
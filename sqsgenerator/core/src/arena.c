@@ -0,0 +1,40 @@
+#include "arena.h"
+
+#define arena_round_up(size) (((size) + ARENA_ALIGNMENT - 1) / ARENA_ALIGNMENT * ARENA_ALIGNMENT)
+
+arena_t* arena_init(size_t capacity){
+    arena_t* a = malloc(sizeof(arena_t));
+    if (a) {
+        a->capacity = arena_round_up(capacity > 0 ? capacity : 1);
+        a->offset = 0;
+        a->memory = aligned_alloc(ARENA_ALIGNMENT, a->capacity);
+        if (!a->memory) {
+            free(a);
+            return NULL;
+        }
+    }
+    return a;
+}
+
+/* Returns NULL if the arena is exhausted */
+void* arena_alloc(arena_t* a, size_t size){
+    size_t rounded = arena_round_up(size);
+    void* block;
+    if (rounded > a->capacity - a->offset) {
+        return NULL;
+    }
+    block = &(a->memory[a->offset]);
+    a->offset += rounded;
+    return block;
+}
+
+void arena_reset(arena_t* a){
+    a->offset = 0;
+}
+
+void arena_destroy(arena_t* a){
+    if (a) {
+        free(a->memory);
+        free(a);
+    }
+}
@@ -0,0 +1,176 @@
+#include <string.h>
+#include <math.h>
+#include "binary.h"
+
+static inline size_t ctz_128(uint128_t x) {
+    uint64_t low = (uint64_t) x;
+    return low ? (size_t) __builtin_ctzll(low) : 64 + (size_t) __builtin_ctzll((uint64_t) (x >> 64));
+}
+
+static inline size_t popcount_128(uint128_t x) {
+    return (size_t) (__builtin_popcountll((uint64_t) x) + __builtin_popcountll((uint64_t) (x >> 64)));
+}
+
+#define binary_bit(b, site) (((uint128_t) 1) << ((b)->atoms - 1 - (site)))
+#define binary_binomial(b, n, k) ((b)->binomials[(n) * ((b)->ones + 1) + (k)])
+
+binary_sqs_t* binary_sqs_init(size_t atoms, size_t ones, size_t shell_count, uint8_t *shell_matrix, double *shell_factors, double *shell_targets) {
+    binary_sqs_t* b;
+    size_t shell;
+
+    if (atoms == 0 || atoms > BINARY_MAX_ATOMS || ones > atoms) {
+        return NULL;
+    }
+    b = malloc(sizeof(binary_sqs_t));
+    if (!b) {
+        return NULL;
+    }
+    b->atoms = atoms;
+    b->ones = ones;
+    b->shell_count = shell_count;
+    b->all = atoms == BINARY_MAX_ATOMS ? ~((uint128_t) 0) : (((uint128_t) 1) << atoms) - 1;
+    b->neighbor_masks = calloc(atoms * shell_count, sizeof(uint128_t));
+    b->shell_factors = malloc(sizeof(double) * shell_count);
+    b->shell_targets = malloc(sizeof(double) * shell_count);
+    b->binomials = calloc((atoms + 1) * (ones + 1), sizeof(uint128_t));
+    if (!b->neighbor_masks || !b->shell_factors || !b->shell_targets || !b->binomials) {
+        binary_sqs_destroy(b);
+        return NULL;
+    }
+    memcpy(b->shell_factors, shell_factors, sizeof(double) * shell_count);
+    memcpy(b->shell_targets, shell_targets, sizeof(double) * shell_count);
+
+    /* Shell numbers start with 1, zero marks the site itself */
+    for (size_t i = 0; i < atoms; i++) {
+        for (size_t j = 0; j < atoms; j++) {
+            shell = shell_matrix[i * atoms + j];
+            if (i != j && shell > 0 && shell <= shell_count) {
+                b->neighbor_masks[i * shell_count + shell - 1] |= binary_bit(b, j);
+            }
+        }
+    }
+
+    /* C(128, 64) < 2^127, the whole Pascal triangle fits into 128 bits */
+    for (size_t n = 0; n <= atoms; n++) {
+        binary_binomial(b, n, 0) = 1;
+        for (size_t k = 1; k <= ones && k <= n; k++) {
+            binary_binomial(b, n, k) = binary_binomial(b, n - 1, k - 1) + (k < n ? binary_binomial(b, n - 1, k) : 0);
+        }
+    }
+    return b;
+}
+
+void binary_sqs_destroy(binary_sqs_t* b) {
+    if (b) {
+        free(b->neighbor_masks);
+        free(b->shell_factors);
+        free(b->shell_targets);
+        free(b->binomials);
+        free(b);
+    }
+}
+
+/* Computes the SQS objective of a mask, the unlike pairs of each shell are popcounts of neighbor masks. If
+ * decomposition is not NULL it is filled in the (shell_count, 2, 2) layout of the generic iterator */
+double binary_sqs_objective(binary_sqs_t* b, uint128_t mask, double *decomposition) {
+    size_t pairs[b->shell_count];
+    size_t site, s;
+    uint128_t minority, majority;
+    uint128_t *neighbors;
+    double value, alpha = 0.0;
+
+    /* Count the pairs from the side of the species with fewer atoms */
+    if (b->ones <= b->atoms - b->ones) {
+        minority = mask;
+        majority = ~mask & b->all;
+    }
+    else {
+        minority = ~mask & b->all;
+        majority = mask;
+    }
+    for (s = 0; s < b->shell_count; s++) {
+        pairs[s] = 0;
+    }
+    while (minority) {
+        site = b->atoms - 1 - ctz_128(minority);
+        minority &= minority - 1;
+        neighbors = &(b->neighbor_masks[site * b->shell_count]);
+        for (s = 0; s < b->shell_count; s++) {
+            pairs[s] += popcount_128(neighbors[s] & majority);
+        }
+    }
+    for (s = 0; s < b->shell_count; s++) {
+        value = b->shell_targets[s] - (double) pairs[s] * b->shell_factors[s];
+        alpha += 2.0 * fabs(value);
+        if (decomposition) {
+            decomposition[s * 4] = 0.0;
+            decomposition[s * 4 + 1] = value;
+            decomposition[s * 4 + 2] = value;
+            decomposition[s * 4 + 3] = 0.0;
+        }
+    }
+    return alpha;
+}
+
+/* Floyd's algorithm, draws a uniformly distributed subset of "ones" sites */
+uint128_t binary_random_mask(binary_sqs_t* b, philox_t* rng) {
+    uint128_t mask = 0, bit;
+    size_t t;
+
+    for (size_t j = b->atoms - b->ones; j < b->atoms; j++) {
+        t = philox_bounded(rng, (uint32_t) (j + 1));
+        bit = ((uint128_t) 1) << t;
+        mask |= (mask & bit) ? ((uint128_t) 1) << j : bit;
+    }
+    return mask;
+}
+
+/* Gosper's hack, advances to the next larger mask with the same number of set bits */
+bool binary_next_mask(binary_sqs_t* b, uint128_t *mask) {
+    uint128_t x = *mask;
+    uint128_t r, next;
+
+    if (x == 0) {
+        return false;
+    }
+    r = x + (x & (~x + 1));
+    if (r == 0) {
+        return false;
+    }
+    next = (((r ^ x) >> 2) >> ctz_128(x)) | r;
+    if (next & ~b->all) {
+        return false;
+    }
+    *mask = next;
+    return true;
+}
+
+/* Splits the C(atoms, ones) masks into contiguous slices, sets mask to the first mask of slice "index" and returns the
+ * length of the slice */
+uint64_t binary_partition(binary_sqs_t* b, uint128_t *mask, uint64_t index, uint64_t chunks) {
+    uint128_t count = binary_binomial(b, b->atoms, b->ones);
+    uint128_t q = count / chunks, r = count % chunks;
+    uint128_t start = index * q + ((uint128_t) index * r) / chunks;
+    uint128_t end = (index + 1) * q + ((uint128_t) (index + 1) * r) / chunks;
+    uint128_t rank = start, result = 0;
+    size_t p = b->atoms;
+
+    if (end > start) {
+        /* Combinatorial number system, the rank is the sum of C(p_k, k) over the set bits */
+        for (size_t k = b->ones; k > 0; k--) {
+            do {
+                p--;
+            } while (binary_binomial(b, p, k) > rank);
+            result |= ((uint128_t) 1) << p;
+            rank -= binary_binomial(b, p, k);
+        }
+        *mask = result;
+    }
+    return (end - start) > UINT64_MAX ? UINT64_MAX : (uint64_t) (end - start);
+}
+
+void binary_mask_to_configuration(binary_sqs_t* b, uint128_t mask, uint8_t *configuration) {
+    for (size_t i = 0; i < b->atoms; i++) {
+        configuration[i] = (mask & binary_bit(b, i)) ? 1 : 0;
+    }
+}
@@ -16,15 +16,17 @@ void conf_array_release_mutex(conf_array_t* a){
 }
 
 
+uint8_t* __conf_array_get_conf_internal(void* array, size_t index){
+    conf_array_t* a = (conf_array_t*) array;
+    return &(a->data[index*a->atoms]);
+}
+
+/* O(1), entries beyond size are stale and the hash set drops its slots by starting a new generation */
 void __conf_array_clear_internal(conf_array_t* array){
-    uint8_t* d = array->data;
-    for (size_t i = 0; i < array->max_size; i++) {
-        array->objective[i] = DBL_MAX;
-        array->set_flags[i] = false;
-        mpz_set_ui(array->ranks[i], 0);
-    }
-    memset(d, 0, sizeof(uint8_t) * array->atoms * array->max_size);
+    conf_hash_set_clear(array->hashes);
     array->size = 0;
+    array->largest = array->max_size;
+    array->version++;
 }
 
 void conf_array_clear(conf_array_t* array){
@@ -36,46 +38,61 @@ void conf_array_clear(conf_array_t* array){
 conf_array_t* conf_array_init(size_t max_size, size_t atoms, size_t decomp_size){
     conf_array_t* a = malloc(sizeof(conf_array_t));
     uint8_t* d = malloc(sizeof(uint8_t) * atoms * max_size);
-    bool* flags = malloc(sizeof(bool) * max_size);
     double* obj = malloc(sizeof(double) * max_size);
     double* decomp = malloc(sizeof(double) * max_size * decomp_size);
-    mpz_t* r = malloc(sizeof(mpz_t) * max_size);
-    for (size_t i = 0; i < max_size; i++) {
-        mpz_init(r[i]);
-        mpz_set_ui(r[i], 0);
-    }
     pthread_mutex_init(&(a->mutex), NULL);
-    a->species_count = 0;
-    a->ranks = r;
+    a->hashes = conf_hash_set_init(atoms, atoms, a, __conf_array_get_conf_internal);
     a->max_size = max_size;
+    a->largest = max_size;
     a->size = 0;
     a->atoms = atoms;
     a->data = d;
-    a->set_flags = flags;
     a->objective = obj;
     a->best_objective = DBL_MAX;
     a->alpha_decomp_size = decomp_size;
     a->alpha_decomp = decomp;
+    a->version = 0;
+    a->published = NULL;
+    a->failed = false;
     conf_array_clear(a);
     return a;
 }
 
 
+/* Index of the entry with the lexicographically largest configuration, the scan is only repeated after a replacement */
+size_t __conf_array_largest_internal(conf_array_t* array){
+    if (array->largest >= array->size) {
+        array->largest = 0;
+        for (size_t i = 1; i < array->size; i++) {
+            if (memcmp(&(array->data[i*array->atoms]), &(array->data[array->largest*array->atoms]), array->atoms) > 0) {
+                array->largest = i;
+            }
+        }
+    }
+    return array->largest;
+}
+
 void __conf_array_set_internal(conf_array_t* array, size_t index, double objective, uint8_t* conf, double* decomp){
     if (index < array->max_size) {
-        //Count number of species in the configuration if it was not done before
         memcpy(&(array->data[index*array->atoms]), conf, sizeof(uint8_t)*array->atoms);
         memcpy(&(array->alpha_decomp[index*(array->alpha_decomp_size)]), decomp, sizeof(double)*array->alpha_decomp_size);
         array->objective[index] = objective;
-        array->set_flags[index] = true;
-        //Rank permutation
-        rank_permutation_mpz(array->ranks[index], conf, array->atoms, array->species_count);
     }
 }
 
 void conf_array_set(conf_array_t* array, size_t index, double objective, uint8_t* conf, double* decomp){
     conf_array_acquire_mutex(array);
-    __conf_array_set_internal(array, index, objective, conf, decomp);
+    //Only the next free entry may be set, the stored entries stay contiguous
+    if (index == array->size && index < array->max_size) {
+        __conf_array_set_internal(array, index, objective, conf, decomp);
+        if (conf_hash_set_insert(array->hashes, conf_hash_compute(array->hashes, conf), index)) {
+            array->size = index + 1;
+            array->version++;
+        }
+        else {
+            array->failed = true;
+        }
+    }
     conf_array_release_mutex(array);
 }
 
@@ -117,29 +134,40 @@ double conf_array_get_objective(conf_array_t* array, size_t index){
     return result;
 }
 
+/* Copies the stored entries only if they changed since the last snapshot, the caller releases the result */
+conf_snapshot_t* conf_array_snapshot(conf_array_t* array){
+    conf_snapshot_t* s;
+    conf_array_acquire_mutex(array);
+    if (!array->published || array->published->version != array->version) {
+        s = conf_snapshot_init(array->version, array->size, array->atoms, array->alpha_decomp_size);
+        if (!s) {
+            conf_array_release_mutex(array);
+            return NULL;
+        }
+        s->best_objective = array->best_objective;
+        memcpy(s->objective, array->objective, sizeof(double) * array->size);
+        memcpy(s->alpha_decomp, array->alpha_decomp, sizeof(double) * array->size * array->alpha_decomp_size);
+        memcpy(s->data, array->data, sizeof(uint8_t) * array->size * array->atoms);
+        conf_snapshot_release(array->published);
+        array->published = s;
+    }
+    s = conf_snapshot_acquire(array->published);
+    conf_array_release_mutex(array);
+    return s;
+}
+
 void conf_array_destroy(conf_array_t* array){
     conf_array_acquire_mutex(array);
-    for(size_t i = 0; i < array->max_size; i++){
-        mpz_clear(array->ranks[i]);
-    }
-    free(array->set_flags);
     free(array->data);
     free(array->objective);
-    free(array->ranks);
+    free(array->alpha_decomp);
+    conf_hash_set_destroy(array->hashes);
+    conf_snapshot_release(array->published);
     conf_array_release_mutex(array);
     pthread_mutex_destroy(&(array->mutex));
     free(array);
 }
 
-int conf_array_available(conf_array_t* array){
-    for (size_t i = 0; i < array->max_size; i++) {
-        if (!array->set_flags[i]) {
-            return i;
-        }
-    }
-    return -1;
-}
-
 bool conf_array_add(conf_array_t* array, double objective, uint8_t* conf, double* decomp){
     conf_array_acquire_mutex(array);
     //New configuration is better than anything we had before
@@ -153,32 +181,38 @@ bool conf_array_add(conf_array_t* array, double objective, uint8_t* conf, double
         conf_array_release_mutex(array);
         return false;
     }
-    if (array->species_count <= 0) {
-        array->species_count = configuration_species_count(conf, array->atoms);
-    }
-    //Check if this configuration is already stored
-    if(objective == array->best_objective) {
-        //Check if configuration is already there
-        mpz_t current_rank;
-        mpz_init(current_rank);
-        rank_permutation_mpz(current_rank, conf, array->atoms, array->species_count);
-        for (size_t i = 0; i < array->size; i++) {
-            if(mpz_cmp(current_rank, array->ranks[i]) == 0) {
-                 mpz_clear(current_rank);
-                 conf_array_release_mutex(array);
-                 return false;
-            }
+    //Here if the new objective is smaller of if its EQUAL. A full array keeps the lexicographically smallest
+    //configurations like the heap does, thus the stored entries do not depend on the order in which threads add them
+    size_t index = array->size, largest = array->max_size;
+    if (array->size >= array->max_size) {
+        largest = __conf_array_largest_internal(array);
+        if (array->max_size == 0 || memcmp(conf, &(array->data[largest*array->atoms]), array->atoms) >= 0) {
+            conf_array_release_mutex(array);
+            return false;
         }
+        index = largest;
     }
-
-    //Here if the new objective is smaller of if its EQUAL
-    int available_index = conf_array_available(array);
-    if (available_index >= 0) {
-        __conf_array_set_internal(array, (size_t)available_index, objective, conf, decomp);
-        array->size = (available_index+1);
+    //Check if this configuration is already stored, the hash is only a filter the stored configuration decides
+    uint128_t hash = conf_hash_compute(array->hashes, conf);
+    if (conf_hash_set_contains(array->hashes, hash, conf)) {
+        conf_array_release_mutex(array);
+        return false;
+    }
+    if (index == largest) {
+        conf_hash_set_remove(array->hashes, conf_hash_compute(array->hashes, &(array->data[index*array->atoms])), index);
+        array->largest = array->max_size;
+    }
+    __conf_array_set_internal(array, index, objective, conf, decomp);
+    //Only an appended entry may grow the hash set, a replaced one reuses the slot count of the removed entry
+    if (!conf_hash_set_insert(array->hashes, hash, index)) {
+        array->failed = true;
         conf_array_release_mutex(array);
-        return true;
+        return false;
+    }
+    if (index == array->size) {
+        array->size++;
     }
+    array->version++;
     conf_array_release_mutex(array);
-    return false;
+    return true;
 }
@@ -3,7 +3,7 @@
 #include <string.h>
 #include <stdio.h>
 
-conf_collection_t* conf_collection_init(size_t max_size, size_t atoms, size_t decomp_size){
+conf_collection_t* conf_collection_init(size_t max_size, size_t atoms, size_t species, size_t decomp_size, size_t budget){
     conf_collection_t* collection = malloc(sizeof(conf_collection_t));
     if (collection) {
         if (max_size > 0) {
@@ -17,7 +17,7 @@ conf_collection_t* conf_collection_init(size_t max_size, size_t atoms, size_t de
             }
         }
         else {
-            conf_list_t* list = conf_list_init(atoms, decomp_size);
+            conf_list_t* list = conf_list_init(atoms, species, decomp_size, budget);
             if (list) {
                 collection->__inner_list = list;
                 collection->__inner_array = NULL;
@@ -59,6 +59,44 @@ double conf_collection_get_objective(conf_collection_t* c, size_t index){
     }
 }
 
+/* The stored form of a configuration, records of the same collection compare like their configurations */
+uint8_t* conf_collection_get_record(conf_collection_t* c, size_t index){
+    if (c->__inner_array) {
+        return conf_array_get_conf(c->__inner_array, index);
+    }
+    else {
+        return conf_list_get_record(c->__inner_list, index);
+    }
+}
+
+size_t conf_collection_record_size(conf_collection_t* c){
+    if (c->__inner_array) {
+        return c->__inner_array->atoms;
+    }
+    else {
+        return c->__inner_list->layout.conf_size;
+    }
+}
+
+/* True if an entry was dropped for lack of memory, the stored entries are not the complete result */
+bool conf_collection_failed(conf_collection_t* c){
+    if (c->__inner_array) {
+        return c->__inner_array->failed;
+    }
+    else {
+        return c->__inner_list->failed;
+    }
+}
+
+conf_snapshot_t* conf_collection_snapshot(conf_collection_t* c){
+    if (c->__inner_array) {
+        return conf_array_snapshot(c->__inner_array);
+    }
+    else {
+        return conf_list_snapshot(c->__inner_list);
+    }
+}
+
 bool conf_collection_add(conf_collection_t* c, double objective, uint8_t *conf, double* decomp){
     bool result;
     if (c->__inner_array) {
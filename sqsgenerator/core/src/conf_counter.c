@@ -0,0 +1,195 @@
+#include <float.h>
+#include <string.h>
+#include "conf_counter.h"
+
+conf_counter_t* conf_counter_init(size_t max_samples, size_t atoms, size_t decomp_size){
+    conf_counter_t* c = malloc(sizeof(conf_counter_t));
+    if (c) {
+        c->data = malloc(sizeof(uint8_t) * atoms * (max_samples > 0 ? max_samples : 1));
+        c->alpha_decomp = malloc(sizeof(double) * decomp_size * (max_samples > 0 ? max_samples : 1));
+        if (!c->data || !c->alpha_decomp) {
+            free(c->data);
+            free(c->alpha_decomp);
+            free(c);
+            return NULL;
+        }
+        mpz_init(c->count);
+        c->max_samples = max_samples;
+        c->samples = 0;
+        c->atoms = atoms;
+        c->alpha_decomp_size = decomp_size;
+        c->pending = 0;
+        c->best_objective = DBL_MAX;
+        c->version = 0;
+        c->published = NULL;
+        pthread_mutex_init(&(c->mutex), NULL);
+    }
+    return c;
+}
+
+void __conf_counter_clear_internal(conf_counter_t* c, double objective){
+    mpz_set_ui(c->count, 0);
+    c->pending = 0;
+    c->samples = 0;
+    c->best_objective = objective;
+}
+
+/* Samples are kept in ascending lexicographical order, a new configuration is inserted at its position and the
+ * largest one drops out if the buffer is full */
+void __conf_counter_sample_internal(conf_counter_t* c, uint8_t* configuration, double* decomp){
+    size_t index = c->samples;
+    while (index > 0 && memcmp(configuration, &c->data[(index - 1) * c->atoms], c->atoms) < 0) {
+        index--;
+    }
+    if (index >= c->max_samples) {
+        return;
+    }
+    if (c->samples < c->max_samples) {
+        c->samples++;
+    }
+    memmove(&c->data[(index + 1) * c->atoms], &c->data[index * c->atoms], sizeof(uint8_t) * c->atoms * (c->samples - index - 1));
+    memmove(&c->alpha_decomp[(index + 1) * c->alpha_decomp_size], &c->alpha_decomp[index * c->alpha_decomp_size], sizeof(double) * c->alpha_decomp_size * (c->samples - index - 1));
+    memcpy(&c->data[index * c->atoms], configuration, sizeof(uint8_t) * c->atoms);
+    memcpy(&c->alpha_decomp[index * c->alpha_decomp_size], decomp, sizeof(double) * c->alpha_decomp_size);
+}
+
+void __conf_counter_flush_internal(conf_counter_t* c){
+    mpz_t pending;
+    mpz_init(pending);
+    mpz_import(pending, 1, -1, sizeof(uint64_t), 0, 0, &c->pending);
+    mpz_add(c->count, c->count, pending);
+    mpz_clear(pending);
+    c->pending = 0;
+}
+
+/* Each configuration must be passed only once, the counter does not check for duplicates */
+bool conf_counter_add(conf_counter_t* c, double objective, uint8_t* configuration, double* decomp){
+    if (objective > c->best_objective) {
+        return false;
+    }
+    pthread_mutex_lock(&(c->mutex));
+    if (objective < c->best_objective) {
+        __conf_counter_clear_internal(c, objective);
+    }
+    /* Plain increments in the hot loop, the GMP integer only absorbs overflows */
+    if (c->pending == UINT64_MAX) {
+        __conf_counter_flush_internal(c);
+    }
+    c->pending++;
+    __conf_counter_sample_internal(c, configuration, decomp);
+    c->version++;
+    pthread_mutex_unlock(&(c->mutex));
+    return true;
+}
+
+void conf_counter_get_count(conf_counter_t* c, mpz_t result){
+    mpz_import(result, 1, -1, sizeof(uint64_t), 0, 0, &c->pending);
+    mpz_add(result, result, c->count);
+}
+
+/* Adds the counts of "other" if both reached the same best objective, replaces them if "other" is better */
+void conf_counter_merge(conf_counter_t* c, conf_counter_t* other){
+    mpz_t other_count;
+    if (other->best_objective > c->best_objective || other->best_objective == DBL_MAX) {
+        return;
+    }
+    pthread_mutex_lock(&(c->mutex));
+    if (other->best_objective < c->best_objective) {
+        __conf_counter_clear_internal(c, other->best_objective);
+    }
+    mpz_init(other_count);
+    conf_counter_get_count(other, other_count);
+    mpz_add(c->count, c->count, other_count);
+    mpz_clear(other_count);
+    for (size_t i = 0; i < other->samples; i++) {
+        __conf_counter_sample_internal(c, &other->data[i * other->atoms], &other->alpha_decomp[i * other->alpha_decomp_size]);
+    }
+    c->version++;
+    pthread_mutex_unlock(&(c->mutex));
+}
+
+/* The string is allocated with the GMP allocator (malloc by default) */
+char* conf_counter_get_count_str(conf_counter_t* c){
+    char* result;
+    mpz_t count;
+    mpz_init(count);
+    conf_counter_get_count(c, count);
+    result = mpz_get_str(NULL, 10, count);
+    mpz_clear(count);
+    return result;
+}
+
+uint8_t* conf_counter_get_conf(conf_counter_t* c, size_t index){
+    if (index < c->samples) {
+        return &c->data[index * c->atoms];
+    }
+    return NULL;
+}
+
+double* conf_counter_get_decomp(conf_counter_t* c, size_t index){
+    if (index < c->samples) {
+        return &c->alpha_decomp[index * c->alpha_decomp_size];
+    }
+    return NULL;
+}
+
+/* Copies the samples, all of them attain the best objective. The count is not part of the snapshot */
+conf_snapshot_t* conf_counter_snapshot(conf_counter_t* c){
+    conf_snapshot_t* s;
+    pthread_mutex_lock(&(c->mutex));
+    if (!c->published || c->published->version != c->version) {
+        s = conf_snapshot_init(c->version, c->samples, c->atoms, c->alpha_decomp_size);
+        if (!s) {
+            pthread_mutex_unlock(&(c->mutex));
+            return NULL;
+        }
+        s->best_objective = c->best_objective;
+        for (size_t i = 0; i < c->samples; i++) {
+            s->objective[i] = c->best_objective;
+        }
+        memcpy(s->alpha_decomp, c->alpha_decomp, sizeof(double) * c->samples * c->alpha_decomp_size);
+        memcpy(s->data, c->data, sizeof(uint8_t) * c->samples * c->atoms);
+        conf_snapshot_release(c->published);
+        c->published = s;
+    }
+    s = conf_snapshot_acquire(c->published);
+    pthread_mutex_unlock(&(c->mutex));
+    return s;
+}
+
+/* Combines the snapshots of the counters of all threads like conf_counter_merge, version is the sum of their versions */
+conf_snapshot_t* conf_counters_snapshot(conf_counter_t** counters, size_t count){
+    conf_counter_t* combined = conf_counter_init(counters[0]->max_samples, counters[0]->atoms, counters[0]->alpha_decomp_size);
+    conf_snapshot_t *local, *s;
+    uint64_t version = 0;
+    if (!combined) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        local = conf_counter_snapshot(counters[i]);
+        if (!local) {
+            conf_counter_destroy(combined);
+            return NULL;
+        }
+        version += local->version;
+        for (size_t j = 0; j < local->size; j++) {
+            conf_counter_add(combined, local->best_objective, conf_snapshot_get_conf(local, j), conf_snapshot_get_decomp(local, j));
+        }
+        conf_snapshot_release(local);
+    }
+    combined->version = version;
+    s = conf_counter_snapshot(combined);
+    conf_counter_destroy(combined);
+    return s;
+}
+
+void conf_counter_destroy(conf_counter_t* c){
+    if (c) {
+        conf_snapshot_release(c->published);
+        pthread_mutex_destroy(&(c->mutex));
+        mpz_clear(c->count);
+        free(c->data);
+        free(c->alpha_decomp);
+        free(c);
+    }
+}
@@ -0,0 +1,183 @@
+#include <string.h>
+#include "conf_hash.h"
+
+#define CONF_HASH_INITIAL_CAPACITY 64
+/* Fixed seed, the hashes of a configuration are the same in every run */
+#define CONF_HASH_SEED 0x5351534745e3779bULL
+
+static uint64_t splitmix64(uint64_t *state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* The number of species is taken from the first configuration, all configurations of a collection share it */
+bool __conf_hash_make_keys_internal(conf_hash_set_t* s, uint8_t* conf) {
+    uint64_t state = CONF_HASH_SEED;
+    uint128_t high;
+    s->species = 0;
+    for (size_t i = 0; i < s->atoms; i++) {
+        if ((size_t) conf[i] + 1 > s->species) {
+            s->species = (size_t) conf[i] + 1;
+        }
+    }
+    s->keys = malloc(sizeof(uint128_t) * s->atoms * s->species);
+    if (!s->keys) {
+        return false;
+    }
+    for (size_t i = 0; i < s->atoms * s->species; i++) {
+        high = splitmix64(&state);
+        s->keys[i] = (high << 64) | splitmix64(&state);
+    }
+    return true;
+}
+
+bool __conf_hash_set_alloc_internal(conf_hash_set_t* s, size_t capacity) {
+    s->hashes = malloc(sizeof(uint128_t) * capacity);
+    s->indices = malloc(sizeof(size_t) * capacity);
+    s->stamps = calloc(capacity, sizeof(uint32_t));
+    if (!s->hashes || !s->indices || !s->stamps) {
+        free(s->hashes);
+        free(s->indices);
+        free(s->stamps);
+        return false;
+    }
+    s->capacity = capacity;
+    s->size = 0;
+    return true;
+}
+
+conf_hash_set_t* conf_hash_set_init(size_t atoms, size_t record_size, void* owner, conf_hash_get_conf_t get_conf) {
+    conf_hash_set_t* s = malloc(sizeof(conf_hash_set_t));
+    if (s) {
+        s->atoms = atoms;
+        s->record_size = record_size;
+        s->species = 0;
+        s->keys = NULL;
+        s->generation = 1;
+        s->owner = owner;
+        s->get_conf = get_conf;
+        if (!__conf_hash_set_alloc_internal(s, CONF_HASH_INITIAL_CAPACITY)) {
+            free(s);
+            return NULL;
+        }
+    }
+    return s;
+}
+
+uint128_t conf_hash_compute(conf_hash_set_t* s, uint8_t* conf) {
+    uint128_t hash = 0;
+    if (!s->keys && !__conf_hash_make_keys_internal(s, conf)) {
+        return 0;
+    }
+    for (size_t i = 0; i < s->atoms; i++) {
+        hash ^= s->keys[i * s->species + conf[i]];
+    }
+    return hash;
+}
+
+static inline size_t __conf_hash_slot(conf_hash_set_t* s, uint128_t hash) {
+    return (size_t) (hash ^ (hash >> 64)) & (s->capacity - 1);
+}
+
+bool conf_hash_set_contains(conf_hash_set_t* s, uint128_t hash, uint8_t* record) {
+    size_t slot = __conf_hash_slot(s, hash);
+    while (s->stamps[slot] == s->generation) {
+        if (s->hashes[slot] == hash && memcmp(s->get_conf(s->owner, s->indices[slot]), record, s->record_size) == 0) {
+            return true;
+        }
+        slot = (slot + 1) & (s->capacity - 1);
+    }
+    return false;
+}
+
+void __conf_hash_set_put_internal(conf_hash_set_t* s, uint128_t hash, size_t index) {
+    size_t slot = __conf_hash_slot(s, hash);
+    while (s->stamps[slot] == s->generation) {
+        slot = (slot + 1) & (s->capacity - 1);
+    }
+    s->hashes[slot] = hash;
+    s->indices[slot] = index;
+    s->stamps[slot] = s->generation;
+    s->size++;
+}
+
+/* Keeps the load factor below one half, linear probing stays short */
+bool conf_hash_set_insert(conf_hash_set_t* s, uint128_t hash, size_t index) {
+    uint128_t* hashes;
+    size_t* indices;
+    uint32_t* stamps;
+    size_t capacity;
+
+    if (2 * (s->size + 1) > s->capacity) {
+        hashes = s->hashes;
+        indices = s->indices;
+        stamps = s->stamps;
+        capacity = s->capacity;
+        if (!__conf_hash_set_alloc_internal(s, 2 * capacity)) {
+            s->hashes = hashes;
+            s->indices = indices;
+            s->stamps = stamps;
+            return false;
+        }
+        for (size_t i = 0; i < capacity; i++) {
+            if (stamps[i] == s->generation) {
+                __conf_hash_set_put_internal(s, hashes[i], indices[i]);
+            }
+        }
+        free(hashes);
+        free(indices);
+        free(stamps);
+    }
+    __conf_hash_set_put_internal(s, hash, index);
+    return true;
+}
+
+/* Backward shift deletion, the entries behind the removed one are moved up so no probe sequence is broken */
+bool conf_hash_set_remove(conf_hash_set_t* s, uint128_t hash, size_t index) {
+    size_t slot = __conf_hash_slot(s, hash), next, home;
+    while (s->stamps[slot] == s->generation && s->indices[slot] != index) {
+        slot = (slot + 1) & (s->capacity - 1);
+    }
+    if (s->stamps[slot] != s->generation) {
+        return false;
+    }
+    next = slot;
+    while (true) {
+        next = (next + 1) & (s->capacity - 1);
+        if (s->stamps[next] != s->generation) {
+            break;
+        }
+        home = __conf_hash_slot(s, s->hashes[next]);
+        //The entry may move to the hole only if its home slot does not lie cyclically in (slot, next]
+        if ((slot <= next) ? (home <= slot || home > next) : (home <= slot && home > next)) {
+            s->hashes[slot] = s->hashes[next];
+            s->indices[slot] = s->indices[next];
+            slot = next;
+        }
+    }
+    s->stamps[slot] = 0;
+    s->size--;
+    return true;
+}
+
+/* O(1), slots stamped with an older generation count as empty. The stamps are only wiped when the counter wraps */
+void conf_hash_set_clear(conf_hash_set_t* s) {
+    s->generation++;
+    if (s->generation == 0) {
+        memset(s->stamps, 0, sizeof(uint32_t) * s->capacity);
+        s->generation = 1;
+    }
+    s->size = 0;
+}
+
+void conf_hash_set_destroy(conf_hash_set_t* s) {
+    if (s) {
+        free(s->keys);
+        free(s->hashes);
+        free(s->indices);
+        free(s->stamps);
+        free(s);
+    }
+}
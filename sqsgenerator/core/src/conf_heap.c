@@ -0,0 +1,238 @@
+#include <float.h>
+#include <string.h>
+#include "conf_heap.h"
+
+uint8_t* __conf_heap_get_conf_internal(void* heap, size_t index){
+    conf_heap_t* h = (conf_heap_t*) heap;
+    return &(h->data[index * h->atoms]);
+}
+
+/* Compares two entries, the objective decides and the configuration breaks ties */
+static inline int __conf_heap_compare(conf_heap_t* h, double objective, uint8_t* conf, size_t entry) {
+    if (objective != h->objective[entry]) {
+        return objective < h->objective[entry] ? -1 : 1;
+    }
+    return memcmp(conf, &(h->data[entry * h->atoms]), h->atoms);
+}
+
+static inline bool __conf_heap_worse(conf_heap_t* h, size_t a, size_t b) {
+    return __conf_heap_compare(h, h->objective[a], &(h->data[a * h->atoms]), b) > 0;
+}
+
+void __conf_heap_sift_up_internal(conf_heap_t* h, size_t pos) {
+    size_t entry = h->heap[pos], parent;
+    while (pos > 0) {
+        parent = (pos - 1) / 2;
+        if (!__conf_heap_worse(h, entry, h->heap[parent])) {
+            break;
+        }
+        h->heap[pos] = h->heap[parent];
+        pos = parent;
+    }
+    h->heap[pos] = entry;
+}
+
+void __conf_heap_sift_down_internal(conf_heap_t* h, size_t* heap, size_t pos, size_t end) {
+    size_t entry = heap[pos], child;
+    while ((child = 2 * pos + 1) < end) {
+        if (child + 1 < end && __conf_heap_worse(h, heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!__conf_heap_worse(h, heap[child], entry)) {
+            break;
+        }
+        heap[pos] = heap[child];
+        pos = child;
+    }
+    heap[pos] = entry;
+}
+
+/* Heapsort of the entry indices in "heap", afterwards they are in ascending order */
+void __conf_heap_sort_internal(conf_heap_t* h, size_t* heap) {
+    size_t end, entry;
+    for (end = h->size; end > 1; end--) {
+        entry = heap[0];
+        heap[0] = heap[end - 1];
+        heap[end - 1] = entry;
+        __conf_heap_sift_down_internal(h, heap, 0, end - 1);
+    }
+}
+
+conf_heap_t* conf_heap_init(size_t max_size, size_t atoms, size_t decomp_size){
+    conf_heap_t* h = malloc(sizeof(conf_heap_t));
+    if (h) {
+        h->max_size = max_size;
+        h->size = 0;
+        h->atoms = atoms;
+        h->alpha_decomp_size = decomp_size;
+        h->threshold = max_size > 0 ? DBL_MAX : -DBL_MAX;
+        h->sorted = false;
+        h->version = 0;
+        h->published = NULL;
+        h->failed = false;
+        pthread_mutex_init(&(h->mutex), NULL);
+        h->data = malloc(sizeof(uint8_t) * atoms * max_size);
+        h->alpha_decomp = malloc(sizeof(double) * decomp_size * max_size);
+        h->objective = malloc(sizeof(double) * max_size);
+        h->entry_hashes = malloc(sizeof(uint128_t) * max_size);
+        h->heap = malloc(sizeof(size_t) * max_size);
+        h->hashes = conf_hash_set_init(atoms, atoms, h, __conf_heap_get_conf_internal);
+        if (max_size > 0 && (!h->data || !h->alpha_decomp || !h->objective || !h->entry_hashes || !h->heap || !h->hashes)) {
+            conf_heap_destroy(h);
+            return NULL;
+        }
+    }
+    return h;
+}
+
+/* O(log max_size), a full heap replaces its worst entry. Returns false for rejected and already kept configurations */
+bool conf_heap_add(conf_heap_t* h, double objective, uint8_t* conf, double* decomp){
+    size_t entry;
+    uint128_t hash;
+    if (h->sorted || objective > h->threshold) {
+        return false;
+    }
+    if (h->size == h->max_size && __conf_heap_compare(h, objective, conf, h->heap[0]) >= 0) {
+        return false;
+    }
+    hash = conf_hash_compute(h->hashes, conf);
+    if (conf_hash_set_contains(h->hashes, hash, conf)) {
+        return false;
+    }
+    //A full heap drops its worst entry and reuses the storage
+    pthread_mutex_lock(&(h->mutex));
+    entry = h->size < h->max_size ? h->size : h->heap[0];
+    if (h->size == h->max_size) {
+        conf_hash_set_remove(h->hashes, h->entry_hashes[entry], entry);
+    }
+    memcpy(&(h->data[entry * h->atoms]), conf, sizeof(uint8_t) * h->atoms);
+    memcpy(&(h->alpha_decomp[entry * h->alpha_decomp_size]), decomp, sizeof(double) * h->alpha_decomp_size);
+    h->objective[entry] = objective;
+    h->entry_hashes[entry] = hash;
+    //Only an appended entry may grow the hash set, a replaced one reuses the slot count of the dropped entry
+    if (!conf_hash_set_insert(h->hashes, hash, entry)) {
+        h->failed = true;
+        pthread_mutex_unlock(&(h->mutex));
+        return false;
+    }
+    if (h->size < h->max_size) {
+        h->heap[h->size] = entry;
+        h->size++;
+        __conf_heap_sift_up_internal(h, h->size - 1);
+    }
+    else {
+        __conf_heap_sift_down_internal(h, h->heap, 0, h->size);
+    }
+    if (h->size == h->max_size) {
+        h->threshold = h->objective[h->heap[0]];
+    }
+    h->version++;
+    pthread_mutex_unlock(&(h->mutex));
+    return true;
+}
+
+void conf_heap_merge(conf_heap_t* h, conf_heap_t* other){
+    for (size_t i = 0; i < other->size; i++) {
+        conf_heap_add(h, other->objective[i], &(other->data[i * other->atoms]), &(other->alpha_decomp[i * other->alpha_decomp_size]));
+    }
+}
+
+/* Heapsort in place, afterwards the entries are in ascending order and the heap accepts no more configurations */
+void conf_heap_sort(conf_heap_t* h){
+    if (h->sorted) {
+        return;
+    }
+    pthread_mutex_lock(&(h->mutex));
+    __conf_heap_sort_internal(h, h->heap);
+    h->sorted = true;
+    pthread_mutex_unlock(&(h->mutex));
+}
+
+uint8_t* conf_heap_get_conf(conf_heap_t* h, size_t index){
+    conf_heap_sort(h);
+    return index < h->size ? &(h->data[h->heap[index] * h->atoms]) : NULL;
+}
+
+double* conf_heap_get_decomp(conf_heap_t* h, size_t index){
+    conf_heap_sort(h);
+    return index < h->size ? &(h->alpha_decomp[h->heap[index] * h->alpha_decomp_size]) : NULL;
+}
+
+double conf_heap_get_objective(conf_heap_t* h, size_t index){
+    conf_heap_sort(h);
+    return index < h->size ? h->objective[h->heap[index]] : -DBL_MAX;
+}
+
+/* Copies the kept entries in ascending order, an unsorted heap is sorted in a copy of its indices */
+conf_snapshot_t* conf_heap_snapshot(conf_heap_t* h){
+    conf_snapshot_t* s;
+    size_t* order;
+    pthread_mutex_lock(&(h->mutex));
+    if (!h->published || h->published->version != h->version) {
+        s = conf_snapshot_init(h->version, h->size, h->atoms, h->alpha_decomp_size);
+        order = h->sorted ? h->heap : malloc(sizeof(size_t) * (h->size > 0 ? h->size : 1));
+        if (!s || !order) {
+            conf_snapshot_release(s);
+            pthread_mutex_unlock(&(h->mutex));
+            return NULL;
+        }
+        if (!h->sorted) {
+            memcpy(order, h->heap, sizeof(size_t) * h->size);
+            __conf_heap_sort_internal(h, order);
+        }
+        for (size_t i = 0; i < h->size; i++) {
+            s->objective[i] = h->objective[order[i]];
+            memcpy(conf_snapshot_get_decomp(s, i), &(h->alpha_decomp[order[i] * h->alpha_decomp_size]), sizeof(double) * h->alpha_decomp_size);
+            memcpy(conf_snapshot_get_conf(s, i), &(h->data[order[i] * h->atoms]), sizeof(uint8_t) * h->atoms);
+        }
+        s->best_objective = h->size > 0 ? s->objective[0] : DBL_MAX;
+        if (order != h->heap) {
+            free(order);
+        }
+        conf_snapshot_release(h->published);
+        h->published = s;
+    }
+    s = conf_snapshot_acquire(h->published);
+    pthread_mutex_unlock(&(h->mutex));
+    return s;
+}
+
+/* Combines the snapshots of the heaps of all threads like conf_heap_merge, version is the sum of their versions */
+conf_snapshot_t* conf_heaps_snapshot(conf_heap_t** heaps, size_t count){
+    conf_heap_t* combined = conf_heap_init(heaps[0]->max_size, heaps[0]->atoms, heaps[0]->alpha_decomp_size);
+    conf_snapshot_t *local, *s;
+    uint64_t version = 0;
+    if (!combined) {
+        return NULL;
+    }
+    for (size_t i = 0; i < count; i++) {
+        local = conf_heap_snapshot(heaps[i]);
+        if (!local) {
+            conf_heap_destroy(combined);
+            return NULL;
+        }
+        version += local->version;
+        for (size_t j = 0; j < local->size; j++) {
+            conf_heap_add(combined, conf_snapshot_get_objective(local, j), conf_snapshot_get_conf(local, j), conf_snapshot_get_decomp(local, j));
+        }
+        conf_snapshot_release(local);
+    }
+    combined->version = version;
+    s = conf_heap_snapshot(combined);
+    conf_heap_destroy(combined);
+    return s;
+}
+
+void conf_heap_destroy(conf_heap_t* h){
+    if (h) {
+        free(h->data);
+        free(h->alpha_decomp);
+        free(h->objective);
+        free(h->entry_hashes);
+        free(h->heap);
+        conf_hash_set_destroy(h->hashes);
+        conf_snapshot_release(h->published);
+        pthread_mutex_destroy(&(h->mutex));
+        free(h);
+    }
+}
@@ -3,132 +3,171 @@
 #include <string.h>
 #include <stdio.h>
 
-void conf_list_destroy_element(void *data, void *meta_data){
-    node_conf_data_t* node_data = (node_conf_data_t*)data;
-    mpz_clear(node_data->rank);
-    free(node_data->alpha_decomp);
-    free(node_data->configuration);
-    free(node_data);
+#define CONF_LIST_INITIAL_CAPACITY 16
+
+/* A record is the objective, the packed decomposition and the packed configuration padded to whole doubles */
+#define conf_list_objective(l, index) ((double*) conf_store_get(&(l)->store, index))
+#define conf_list_decomp(l, index) (conf_list_objective(l, index) + 1)
+#define conf_list_record(l, index) ((uint8_t*) (conf_list_decomp(l, index) + (l)->layout.packed_decomp_size))
+
+void conf_list_acquire_mutex(conf_list_t* l){
+    pthread_mutex_lock(&(l->mutex));
 }
 
-node_conf_data_t* conf_list_create_data_struct(conf_list_t* l, double alpha, uint8_t* conf, double* decomp){
-    node_conf_data_t* node_data = malloc(sizeof(node_conf_data_t));
-    if (node_data) {
-        /* Create a copy of the array */
-        uint8_t* conf_ptr = malloc(sizeof(uint8_t)*l->atoms);
-        if (!conf_ptr) {
-            return NULL;
-        }
-        double* decomp_ptr = malloc(sizeof(double)*l->alpha_decomp_size);
-        if (!decomp_ptr) {
-            return NULL;
-        }
-        memcpy(conf_ptr, conf, sizeof(uint8_t)*l->atoms);
-        memcpy(decomp_ptr, decomp, sizeof(double)*l->alpha_decomp_size);
-        node_data->alpha_decomp = decomp_ptr;
-        node_data->alpha = alpha;
-        node_data->configuration = conf_ptr;
-        mpz_init(node_data->rank);
-        rank_permutation_mpz(node_data->rank, conf, l->atoms, l->species_count);
-        return node_data;
-    }
-    return NULL;
+void conf_list_release_mutex(conf_list_t* l){
+    pthread_mutex_unlock(&(l->mutex));
 }
 
-conf_list_t* conf_list_init(size_t atoms, size_t decomp_size){
+uint8_t* __conf_list_get_conf_internal(void* list, size_t index){
+    conf_list_t* l = (conf_list_t*) list;
+    return conf_list_record(l, index);
+}
+
+conf_list_t* conf_list_init(size_t atoms, size_t species, size_t decomp_size, size_t budget){
     conf_list_t* l = malloc(sizeof(conf_list_t));
+    size_t record_size;
+    bool stored;
     if(l){
         l->best_objective = DBL_MAX;
         l->atoms = atoms;
         l->alpha_decomp_size = decomp_size;
-        l->species_count = 0;
-        list_t* inner = list_init(conf_list_destroy_element);
-        if (inner) {
-            l->__inner_list = inner;
+        conf_record_layout_init(&(l->layout), atoms, species, decomp_size);
+        record_size = sizeof(double) * (1 + l->layout.packed_decomp_size)
+                      + (l->layout.conf_size + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+        stored = conf_store_init(&(l->store), record_size, CONF_LIST_INITIAL_CAPACITY, budget);
+        l->size = 0;
+        l->version = 0;
+        l->published = NULL;
+        l->failed = false;
+        l->conf_buffer = malloc(sizeof(uint8_t) * atoms);
+        l->record_buffer = malloc(sizeof(uint8_t) * l->layout.conf_size);
+        l->decomp_buffer = malloc(sizeof(double) * decomp_size);
+        l->hashes = conf_hash_set_init(atoms, l->layout.conf_size, l, __conf_list_get_conf_internal);
+        if (!stored || !l->conf_buffer || !l->record_buffer || !l->decomp_buffer || !l->hashes) {
+            if (stored) {
+                conf_store_release(&(l->store));
+            }
+            free(l->conf_buffer);
+            free(l->record_buffer);
+            free(l->decomp_buffer);
+            conf_hash_set_destroy(l->hashes);
+            free(l);
+            return NULL;
         }
+        pthread_mutex_init(&(l->mutex), NULL);
     }
     return l;
 }
 
 bool conf_list_add(conf_list_t* l, double alpha, uint8_t *conf, double* decomp){
-    list_acquire_mutex(l->__inner_list);
+    conf_list_acquire_mutex(l);
 
     if (alpha < l->best_objective) {
         l->best_objective = alpha;
-        __list_clear_internal(l->__inner_list);
+        /* The memory is kept for the next ties */
+        conf_hash_set_clear(l->hashes);
         l->size  = 0;
+        l->version++;
     }
 
     if (alpha > l->best_objective){
-        list_release_mutex(l->__inner_list);
+        conf_list_release_mutex(l);
         return false;
     }
 
-    if (l->species_count <= 0) {
-        l->species_count = configuration_species_count(conf, l->atoms);
+    //Check if configuration is already there, the stored records are compared in the packed layout
+    uint128_t hash = conf_hash_compute(l->hashes, conf);
+    conf_record_pack_conf(&(l->layout), conf, l->record_buffer);
+    if (conf_hash_set_contains(l->hashes, hash, l->record_buffer)) {
+        conf_list_release_mutex(l);
+        return false;
     }
 
-    if(alpha == l->best_objective) {
-    //Check if configuration is already there
-        mpz_t current_rank;
-        mpz_init(current_rank);
-        node_t *current;
-        node_conf_data_t *current_data;
-        rank_permutation_mpz(current_rank, conf, l->atoms, l->species_count);
-
-        for (size_t i = 0; i < l->__inner_list->size; i++) {
-            current = __list_get_node_internal(l->__inner_list, i);
-            current_data = current->data;
-            if(mpz_cmp(current_rank, current_data->rank) == 0) {
-                 //printf("Duplicate rank: %u and %u -> CMP: %i\n", mpz_get_ui(current_rank), mpz_get_ui(current_data->rank), mpz_cmp(current_rank, current_data->rank));
-                 mpz_clear(current_rank);
-                 list_release_mutex(l->__inner_list);
-                 return false;
-            }
-        }
+    if (l->size == l->store.capacity && !conf_store_grow(&(l->store))) {
+        l->failed = true;
+        conf_list_release_mutex(l);
+        return false;
     }
-
-    node_conf_data_t* data = conf_list_create_data_struct(l, alpha, conf, decomp);
-    if (data) {
-        bool result = __list_append_internal(l->__inner_list, data, NULL);
-        if (result) {
-            l->size = l->__inner_list->size;
-            list_release_mutex(l->__inner_list);
-            return result;
-        }
-        list_release_mutex(l->__inner_list);
+    *conf_list_objective(l, l->size) = alpha;
+    conf_record_pack_decomp(&(l->layout), decomp, conf_list_decomp(l, l->size));
+    memcpy(conf_list_record(l, l->size), l->record_buffer, sizeof(uint8_t)*l->layout.conf_size);
+    if (!conf_hash_set_insert(l->hashes, hash, l->size)) {
+        l->failed = true;
+        conf_list_release_mutex(l);
+        return false;
     }
-    list_release_mutex(l->__inner_list);
-    return false;
+    l->size++;
+    l->version++;
+    conf_list_release_mutex(l);
+    return true;
 }
 
 double conf_list_get_objective(conf_list_t* l, size_t index){
-    node_conf_data_t* data = (node_conf_data_t*) list_get_data(l->__inner_list, index);
-    if (data) {
-        return data->alpha;
+    if (index < l->size) {
+        return *conf_list_objective(l, index);
     }
     return -DBL_MAX;
 }
 
+/* The getters below take no lock and unpack into the one buffer of the list. The result is valid until the next call
+ * of the same getter, they must not run concurrently with each other or with conf_list_add */
 uint8_t *conf_list_get_conf(conf_list_t* l, size_t index){
-    node_conf_data_t* data = (node_conf_data_t*) list_get_data(l->__inner_list, index);
-    if (data) {
-        return data->configuration;
+    if (index < l->size) {
+        conf_record_unpack_conf(&(l->layout), conf_list_record(l, index), l->conf_buffer);
+        return l->conf_buffer;
     }
     return NULL;
 }
 
 double* conf_list_get_decomp(conf_list_t* l, size_t index){
-    node_conf_data_t* data = (node_conf_data_t*) list_get_data(l->__inner_list, index);
-    if (data) {
-        return data->alpha_decomp;
+    if (index < l->size) {
+        conf_record_unpack_decomp(&(l->layout), conf_list_decomp(l, index), l->decomp_buffer);
+        return l->decomp_buffer;
+    }
+    return NULL;
+}
+
+/* The packed configuration, it orders like the configuration itself */
+uint8_t *conf_list_get_record(conf_list_t* l, size_t index){
+    if (index < l->size) {
+        return conf_list_record(l, index);
     }
     return NULL;
 }
 
+/* Unpacks all stored records, a snapshot of an unchanged list is handed out again. The caller releases the result */
+conf_snapshot_t* conf_list_snapshot(conf_list_t* l){
+    conf_snapshot_t* s;
+    conf_list_acquire_mutex(l);
+    if (!l->published || l->published->version != l->version) {
+        s = conf_snapshot_init(l->version, l->size, l->atoms, l->alpha_decomp_size);
+        if (!s) {
+            conf_list_release_mutex(l);
+            return NULL;
+        }
+        s->best_objective = l->best_objective;
+        for (size_t i = 0; i < l->size; i++) {
+            s->objective[i] = *conf_list_objective(l, i);
+            conf_record_unpack_decomp(&(l->layout), conf_list_decomp(l, i), conf_snapshot_get_decomp(s, i));
+            conf_record_unpack_conf(&(l->layout), conf_list_record(l, i), conf_snapshot_get_conf(s, i));
+        }
+        conf_snapshot_release(l->published);
+        l->published = s;
+    }
+    s = conf_snapshot_acquire(l->published);
+    conf_list_release_mutex(l);
+    return s;
+}
+
 void conf_list_destroy(conf_list_t* l){
     if (l) {
-        list_destroy(l->__inner_list);
+        conf_snapshot_release(l->published);
+        conf_store_release(&(l->store));
+        free(l->conf_buffer);
+        free(l->record_buffer);
+        free(l->decomp_buffer);
+        conf_hash_set_destroy(l->hashes);
+        pthread_mutex_destroy(&(l->mutex));
         free(l);
     }
 }
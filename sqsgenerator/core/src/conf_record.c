@@ -0,0 +1,67 @@
+#include <string.h>
+#include "conf_record.h"
+
+void conf_record_layout_init(conf_record_layout_t* l, size_t atoms, size_t species, size_t decomp_size){
+    l->atoms = atoms;
+    l->species = species > 0 ? species : 1;
+    l->bits = 1;
+    while (((size_t) 1 << l->bits) < l->species) {
+        l->bits++;
+    }
+    l->conf_size = (atoms * l->bits + 7) / 8;
+    l->decomp_size = decomp_size;
+    l->blocks = decomp_size / (l->species * l->species);
+    //A single species has no pairs, one unused entry keeps the allocations of the owner non-empty
+    l->packed_decomp_size = l->blocks * (l->species * (l->species - 1) / 2);
+    if (l->packed_decomp_size == 0) {
+        l->packed_decomp_size = 1;
+    }
+}
+
+void conf_record_pack_conf(conf_record_layout_t* l, uint8_t* conf, uint8_t* packed){
+    size_t bit = 0, shift;
+    memset(packed, 0, l->conf_size);
+    for (size_t i = 0; i < l->atoms; i++) {
+        for (size_t b = l->bits; b-- > 0; bit++) {
+            shift = 7 - (bit & 7);
+            packed[bit >> 3] |= (uint8_t) (((conf[i] >> b) & 1) << shift);
+        }
+    }
+}
+
+void conf_record_unpack_conf(conf_record_layout_t* l, uint8_t* packed, uint8_t* conf){
+    size_t bit = 0;
+    uint8_t value;
+    for (size_t i = 0; i < l->atoms; i++) {
+        value = 0;
+        for (size_t b = 0; b < l->bits; b++, bit++) {
+            value = (uint8_t) ((value << 1) | ((packed[bit >> 3] >> (7 - (bit & 7))) & 1));
+        }
+        conf[i] = value;
+    }
+}
+
+void conf_record_pack_decomp(conf_record_layout_t* l, double* decomp, double* packed){
+    size_t s = l->species, k = 0;
+    for (size_t block = 0; block < l->blocks; block++) {
+        for (size_t i = 0; i < s; i++) {
+            for (size_t j = i + 1; j < s; j++) {
+                packed[k++] = decomp[block * s * s + i * s + j];
+            }
+        }
+    }
+}
+
+void conf_record_unpack_decomp(conf_record_layout_t* l, double* packed, double* decomp){
+    size_t s = l->species, k = 0;
+    memset(decomp, 0, sizeof(double) * l->decomp_size);
+    for (size_t block = 0; block < l->blocks; block++) {
+        for (size_t i = 0; i < s; i++) {
+            for (size_t j = i + 1; j < s; j++) {
+                decomp[block * s * s + i * s + j] = packed[k];
+                decomp[block * s * s + j * s + i] = packed[k];
+                k++;
+            }
+        }
+    }
+}
@@ -0,0 +1,31 @@
+#include <float.h>
+#include "conf_snapshot.h"
+
+/* The entries follow the header in the same block, the caller fills them in before publishing the snapshot */
+conf_snapshot_t* conf_snapshot_init(uint64_t version, size_t size, size_t atoms, size_t decomp_size){
+    size_t header = (sizeof(conf_snapshot_t) + sizeof(double) - 1) / sizeof(double) * sizeof(double);
+    conf_snapshot_t* s = malloc(header + sizeof(double) * size * (1 + decomp_size) + sizeof(uint8_t) * size * atoms);
+    if (s) {
+        s->version = version;
+        s->size = size;
+        s->atoms = atoms;
+        s->alpha_decomp_size = decomp_size;
+        s->best_objective = DBL_MAX;
+        s->objective = (double*) ((uint8_t*) s + header);
+        s->alpha_decomp = s->objective + size;
+        s->data = (uint8_t*) (s->alpha_decomp + size * decomp_size);
+        atomic_init(&s->references, 1);
+    }
+    return s;
+}
+
+conf_snapshot_t* conf_snapshot_acquire(conf_snapshot_t* s){
+    atomic_fetch_add_explicit(&s->references, 1, memory_order_relaxed);
+    return s;
+}
+
+void conf_snapshot_release(conf_snapshot_t* s){
+    if (s && atomic_fetch_sub_explicit(&s->references, 1, memory_order_acq_rel) == 1) {
+        free(s);
+    }
+}
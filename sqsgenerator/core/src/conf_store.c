@@ -0,0 +1,98 @@
+/* mkstemp, ftruncate and mmap are POSIX, the extensions are compiled in strict C mode */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "conf_store.h"
+
+#define CONF_STORE_TEMPLATE "sqsgenerator-XXXXXX"
+
+bool conf_store_init(conf_store_t* s, size_t record_size, size_t capacity, size_t budget){
+    s->record_size = record_size;
+    s->capacity = capacity;
+    s->budget = budget;
+    s->fd = -1;
+    s->memory = malloc(record_size * capacity);
+    return s->memory != NULL;
+}
+
+/* The file is removed from the directory right away, it disappears with the store or the process */
+int __conf_store_open_internal(void){
+    const char* directory = getenv("TMPDIR");
+    char path[4096];
+    int fd;
+    if (!directory || !directory[0]) {
+        directory = "/tmp";
+    }
+    if (snprintf(path, sizeof(path), "%s/%s", directory, CONF_STORE_TEMPLATE) >= (int) sizeof(path)) {
+        return -1;
+    }
+    fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+    }
+    return fd;
+}
+
+uint8_t* __conf_store_map_internal(int fd, size_t bytes){
+    uint8_t* memory;
+    if (ftruncate(fd, (off_t) bytes) != 0) {
+        return NULL;
+    }
+    memory = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    return memory == MAP_FAILED ? NULL : memory;
+}
+
+/* Doubles the capacity, nothing is changed if the memory or the file cannot be extended */
+bool conf_store_grow(conf_store_t* s){
+    size_t capacity = s->capacity * 2;
+    size_t bytes = s->record_size * capacity;
+    uint8_t* memory;
+    int fd;
+
+    if (!conf_store_spilled(s) && (s->budget == 0 || bytes <= s->budget)) {
+        memory = realloc(s->memory, bytes);
+        if (!memory) {
+            return false;
+        }
+    }
+    else if (!conf_store_spilled(s)) {
+        fd = __conf_store_open_internal();
+        if (fd < 0) {
+            return false;
+        }
+        memory = __conf_store_map_internal(fd, bytes);
+        if (!memory) {
+            close(fd);
+            return false;
+        }
+        memcpy(memory, s->memory, s->record_size * s->capacity);
+        free(s->memory);
+        s->fd = fd;
+    }
+    else {
+        //The old mapping stays valid until the new one exists, both show the same file
+        memory = __conf_store_map_internal(s->fd, bytes);
+        if (!memory) {
+            return false;
+        }
+        munmap(s->memory, s->record_size * s->capacity);
+    }
+    s->memory = memory;
+    s->capacity = capacity;
+    return true;
+}
+
+void conf_store_release(conf_store_t* s){
+    if (conf_store_spilled(s)) {
+        munmap(s->memory, s->record_size * s->capacity);
+        close(s->fd);
+        s->fd = -1;
+    }
+    else {
+        free(s->memory);
+    }
+    s->memory = NULL;
+}
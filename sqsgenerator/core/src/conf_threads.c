@@ -0,0 +1,260 @@
+#include <float.h>
+#include <string.h>
+#include "conf_threads.h"
+
+/* The buffers may store packed records, they are compared in that form and only unpacked when they are kept */
+typedef struct __conf_threads_entry {
+    conf_collection_t* local;
+    size_t index;
+    uint8_t* record;
+    size_t record_size;
+} conf_threads_entry_t;
+
+typedef struct __conf_threads_snapshot_entry {
+    conf_snapshot_t* snapshot;
+    size_t index;
+} conf_threads_snapshot_entry_t;
+
+conf_threads_t* conf_threads_init(size_t threads, size_t max_size, size_t atoms, size_t species, size_t decomp_size, size_t budget){
+    conf_threads_t* t = malloc(sizeof(conf_threads_t));
+    if (t) {
+        t->locals = calloc(threads, sizeof(conf_collection_t*));
+        if (!t->locals) {
+            free(t);
+            return NULL;
+        }
+        t->threads = threads;
+        t->max_size = max_size;
+        t->atoms = atoms;
+        t->species = species;
+        t->alpha_decomp_size = decomp_size;
+        t->budget = budget;
+        t->published = NULL;
+        pthread_mutex_init(&(t->mutex), NULL);
+        atomic_init(&t->best_objective, DBL_MAX);
+        for (size_t i = 0; i < threads; i++) {
+            t->locals[i] = conf_collection_init(max_size, atoms, species, decomp_size, budget);
+            if (!t->locals[i]) {
+                conf_threads_destroy(t);
+                return NULL;
+            }
+        }
+    }
+    return t;
+}
+
+double conf_threads_best_objective(conf_threads_t* t){
+    return atomic_load_explicit(&t->best_objective, memory_order_relaxed);
+}
+
+/* Lowers the global best objective, a failed exchange reloads the current value */
+void __conf_threads_publish_internal(conf_threads_t* t, double objective){
+    double current = atomic_load_explicit(&t->best_objective, memory_order_relaxed);
+    while (objective < current) {
+        if (atomic_compare_exchange_weak_explicit(&t->best_objective, &current, objective, memory_order_relaxed, memory_order_relaxed)) {
+            break;
+        }
+    }
+}
+
+bool conf_threads_add(conf_threads_t* t, size_t thread, double objective, uint8_t* conf, double* decomp){
+    /* Another thread has already found something better */
+    if (objective > conf_threads_best_objective(t)) {
+        return false;
+    }
+    if (conf_collection_add(t->locals[thread], objective, conf, decomp)) {
+        __conf_threads_publish_internal(t, objective);
+        return true;
+    }
+    return false;
+}
+
+int __conf_threads_entry_compare(const void* a, const void* b){
+    const conf_threads_entry_t* x = a;
+    const conf_threads_entry_t* y = b;
+    return memcmp(x->record, y->record, x->record_size);
+}
+
+uint64_t* __conf_threads_version_internal(conf_collection_t* c){
+    return c->__inner_array ? &(c->__inner_array->version) : &(c->__inner_list->version);
+}
+
+bool* __conf_threads_failed_internal(conf_collection_t* c){
+    return c->__inner_array ? &(c->__inner_array->failed) : &(c->__inner_list->failed);
+}
+
+/* The merged collection holds the entries of a snapshot of the buffers, it gets the version of that snapshot. It is
+ * incomplete if any of the buffers is */
+void __conf_threads_continue_version_internal(conf_threads_t* t, conf_collection_t* result){
+    uint64_t version = 0;
+    for (size_t i = 0; i < t->threads; i++) {
+        version += *__conf_threads_version_internal(t->locals[i]);
+        *__conf_threads_failed_internal(result) |= conf_collection_failed(t->locals[i]);
+    }
+    *__conf_threads_version_internal(result) = version;
+}
+
+/* Builds a new collection from the thread buffers, the caller owns it */
+conf_collection_t* conf_threads_merge(conf_threads_t* t){
+    double best = conf_threads_best_objective(t);
+    size_t count = 0, index = 0;
+    conf_collection_t* result;
+    conf_collection_t* local;
+    conf_threads_entry_t* entries;
+
+    result = conf_collection_init(t->max_size, t->atoms, t->species, t->alpha_decomp_size, t->budget);
+    if (!result) {
+        return NULL;
+    }
+    for (size_t i = 0; i < t->threads; i++) {
+        if (t->locals[i]->best_objective == best) {
+            count += t->locals[i]->size;
+        }
+    }
+    if (count == 0) {
+        __conf_threads_continue_version_internal(t, result);
+        return result;
+    }
+    entries = malloc(sizeof(conf_threads_entry_t) * count);
+    if (!entries) {
+        conf_collection_destroy(result);
+        return NULL;
+    }
+    for (size_t i = 0; i < t->threads; i++) {
+        local = t->locals[i];
+        if (local->best_objective != best) {
+            continue;
+        }
+        for (size_t j = 0; j < local->size; j++) {
+            entries[index].local = local;
+            entries[index].index = j;
+            entries[index].record = conf_collection_get_record(local, j);
+            entries[index].record_size = conf_collection_record_size(local);
+            index++;
+        }
+    }
+    qsort(entries, count, sizeof(conf_threads_entry_t), __conf_threads_entry_compare);
+    for (size_t i = 0; i < count; i++) {
+        if (t->max_size > 0 && result->size >= t->max_size) {
+            break;
+        }
+        /* Two threads never visit the same configuration in the exhaustive mode, but random draws may repeat */
+        if (i > 0 && __conf_threads_entry_compare(&entries[i - 1], &entries[i]) == 0) {
+            continue;
+        }
+        conf_collection_add(result, best, conf_collection_get_conf(entries[i].local, entries[i].index),
+                            conf_collection_get_decomp(entries[i].local, entries[i].index));
+    }
+    free(entries);
+    __conf_threads_continue_version_internal(t, result);
+    return result;
+}
+
+int __conf_threads_snapshot_entry_compare(const void* a, const void* b){
+    const conf_threads_snapshot_entry_t* x = a;
+    const conf_threads_snapshot_entry_t* y = b;
+    return memcmp(conf_snapshot_get_conf(x->snapshot, x->index), conf_snapshot_get_conf(y->snapshot, y->index), x->snapshot->atoms);
+}
+
+/* Combines the snapshots of the buffers like conf_threads_merge, version is the sum of their versions */
+conf_snapshot_t* __conf_threads_combine_internal(conf_threads_t* t, conf_snapshot_t** locals, uint64_t version, double best){
+    size_t count = 0, index = 0, kept = 0;
+    conf_threads_snapshot_entry_t* entries;
+    conf_snapshot_t* s;
+
+    for (size_t i = 0; i < t->threads; i++) {
+        if (locals[i]->best_objective == best) {
+            count += locals[i]->size;
+        }
+    }
+    entries = malloc(sizeof(conf_threads_snapshot_entry_t) * (count > 0 ? count : 1));
+    if (!entries) {
+        return NULL;
+    }
+    for (size_t i = 0; i < t->threads; i++) {
+        if (locals[i]->best_objective != best) {
+            continue;
+        }
+        for (size_t j = 0; j < locals[i]->size; j++) {
+            entries[index].snapshot = locals[i];
+            entries[index].index = j;
+            index++;
+        }
+    }
+    qsort(entries, count, sizeof(conf_threads_snapshot_entry_t), __conf_threads_snapshot_entry_compare);
+    /* Drops the duplicates in place */
+    for (size_t i = 0; i < count; i++) {
+        if (t->max_size > 0 && kept >= t->max_size) {
+            break;
+        }
+        if (kept > 0 && __conf_threads_snapshot_entry_compare(&entries[kept - 1], &entries[i]) == 0) {
+            continue;
+        }
+        entries[kept++] = entries[i];
+    }
+    s = conf_snapshot_init(version, kept, t->atoms, t->alpha_decomp_size);
+    if (s) {
+        s->best_objective = best;
+        for (size_t i = 0; i < kept; i++) {
+            s->objective[i] = conf_snapshot_get_objective(entries[i].snapshot, entries[i].index);
+            memcpy(conf_snapshot_get_decomp(s, i), conf_snapshot_get_decomp(entries[i].snapshot, entries[i].index), sizeof(double) * t->alpha_decomp_size);
+            memcpy(conf_snapshot_get_conf(s, i), conf_snapshot_get_conf(entries[i].snapshot, entries[i].index), sizeof(uint8_t) * t->atoms);
+        }
+    }
+    free(entries);
+    return s;
+}
+
+/* Each buffer is locked only while its own snapshot is taken, the adding threads are never stopped all at once */
+conf_snapshot_t* conf_threads_snapshot(conf_threads_t* t){
+    conf_snapshot_t** locals = calloc(t->threads, sizeof(conf_snapshot_t*));
+    conf_snapshot_t* s = NULL;
+    uint64_t version = 0;
+    double best = DBL_MAX;
+    size_t i;
+
+    if (!locals) {
+        return NULL;
+    }
+    for (i = 0; i < t->threads; i++) {
+        locals[i] = conf_collection_snapshot(t->locals[i]);
+        if (!locals[i]) {
+            break;
+        }
+        version += locals[i]->version;
+        if (locals[i]->best_objective < best) {
+            best = locals[i]->best_objective;
+        }
+    }
+    if (i == t->threads) {
+        pthread_mutex_lock(&(t->mutex));
+        if (!t->published || t->published->version != version) {
+            s = __conf_threads_combine_internal(t, locals, version, best);
+            if (s) {
+                conf_snapshot_release(t->published);
+                t->published = s;
+            }
+        }
+        s = t->published && t->published->version == version ? conf_snapshot_acquire(t->published) : NULL;
+        pthread_mutex_unlock(&(t->mutex));
+    }
+    for (i = 0; i < t->threads; i++) {
+        conf_snapshot_release(locals[i]);
+    }
+    free(locals);
+    return s;
+}
+
+void conf_threads_destroy(conf_threads_t* t){
+    if (t) {
+        conf_snapshot_release(t->published);
+        pthread_mutex_destroy(&(t->mutex));
+        for (size_t i = 0; i < t->threads; i++) {
+            if (t->locals[i]) {
+                conf_collection_destroy(t->locals[i]);
+            }
+        }
+        free(t->locals);
+        free(t);
+    }
+}
@@ -0,0 +1,59 @@
+#include <math.h>
+#include "morton.h"
+
+typedef struct {
+    uint64_t key;
+    size_t index;
+} __morton_entry_t;
+
+static int __morton_entry_compare(const void* a, const void* b) {
+    const __morton_entry_t* x = a;
+    const __morton_entry_t* y = b;
+    if (x->key != y->key) {
+        return (x->key > y->key) - (x->key < y->key);
+    }
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+/* Moves the lowest MORTON_BITS bits of v two bits apart from each other */
+static inline uint64_t __morton_spread(uint64_t v) {
+    v &= 0x1FFFFF;
+    v = (v | v << 32) & 0x1F00000000FFFF;
+    v = (v | v << 16) & 0x1F0000FF0000FF;
+    v = (v | v << 8) & 0x100F00F00F00F00F;
+    v = (v | v << 4) & 0x10C30C30C30C30C3;
+    v = (v | v << 2) & 0x1249249249249249;
+    return v;
+}
+
+uint64_t morton_key(double* frac) {
+    uint64_t key = 0, q;
+    double f;
+    for (size_t k = 0; k < 3; k++) {
+        f = frac[k] - floor(frac[k]);
+        q = (uint64_t) (f * (double) (1 << MORTON_BITS));
+        q = q < (1 << MORTON_BITS) ? q : (1 << MORTON_BITS) - 1;
+        key |= __morton_spread(q) << (2 - k);
+    }
+    return key;
+}
+
+/* order[i] is the site at position i of the curve, sites with the same key keep their relative order */
+void morton_order(double* frac_coords, size_t atoms, size_t* order) {
+    __morton_entry_t* entries = malloc(sizeof(__morton_entry_t) * (atoms > 0 ? atoms : 1));
+    if (!entries) {
+        for (size_t i = 0; i < atoms; i++) {
+            order[i] = i;
+        }
+        return;
+    }
+    for (size_t i = 0; i < atoms; i++) {
+        entries[i].key = morton_key(&frac_coords[3 * i]);
+        entries[i].index = i;
+    }
+    qsort(entries, atoms, sizeof(__morton_entry_t), __morton_entry_compare);
+    for (size_t i = 0; i < atoms; i++) {
+        order[i] = entries[i].index;
+    }
+    free(entries);
+}
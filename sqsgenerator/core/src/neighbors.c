@@ -0,0 +1,438 @@
+#include <math.h>
+#include <string.h>
+#include "neighbors.h"
+
+static inline size_t __neighbor_list_bin(double f, size_t bins) {
+    size_t bin = (size_t) (f * bins);
+    return bin < bins ? bin : bins - 1;
+}
+
+static int __neighbor_list_index_compare(const void* a, const void* b) {
+    size_t x = *(const size_t*) a, y = *(const size_t*) b;
+    return (x > y) - (x < y);
+}
+
+/* Width of the cell perpendicular to the plane of the two other lattice vectors */
+static double __neighbor_list_width(double* lattice, size_t k) {
+    double* a = &lattice[3 * k];
+    double* b = &lattice[3 * ((k + 1) % 3)];
+    double* c = &lattice[3 * ((k + 2) % 3)];
+    double n[3] = {b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0]};
+    return fabs(a[0] * n[0] + a[1] * n[1] + a[2] * n[2]) / sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+}
+
+/* Adds a candidate to the workspace, a site which was already reached keeps its shorter image */
+static inline void __neighbor_workspace_offer(neighbor_workspace_t* w, size_t j, double d2, double* v) {
+    if (w->stamps[j] != w->generation) {
+        w->stamps[j] = w->generation;
+        w->touched[w->count++] = j;
+    }
+    else if (d2 >= w->d2[j]) {
+        return;
+    }
+    w->d2[j] = d2;
+    memcpy(&(w->vectors[3 * j]), v, sizeof(double) * 3);
+}
+
+/* Visits the translations which may bring site j within the cutoff of site i, the first pass only counts */
+static size_t __neighbor_table_images(neighbor_table_t* t, double* lattice, double* frac_coords, double* widths, size_t i, size_t j, size_t entry, bool fill) {
+    double* fi = &frac_coords[3 * i];
+    double* fj = &frac_coords[3 * j];
+    double cutoff2 = t->cutoff * t->cutoff, diff[3], v[3];
+    int64_t low[3], high[3], n[3];
+
+    for (size_t k = 0; k < 3; k++) {
+        low[k] = (int64_t) ceil(fi[k] - fj[k] - t->cutoff / widths[k]);
+        high[k] = (int64_t) floor(fi[k] - fj[k] + t->cutoff / widths[k]);
+    }
+    for (n[0] = low[0]; n[0] <= high[0]; n[0]++) {
+        for (n[1] = low[1]; n[1] <= high[1]; n[1]++) {
+            for (n[2] = low[2]; n[2] <= high[2]; n[2]++) {
+                if (i == j && n[0] == 0 && n[1] == 0 && n[2] == 0) {
+                    continue;
+                }
+                for (size_t k = 0; k < 3; k++) {
+                    diff[k] = fj[k] + (double) n[k] - fi[k];
+                }
+                for (size_t c = 0; c < 3; c++) {
+                    v[c] = diff[0] * lattice[c] + diff[1] * lattice[3 + c] + diff[2] * lattice[6 + c];
+                }
+                if (v[0] * v[0] + v[1] * v[1] + v[2] * v[2] > cutoff2) {
+                    continue;
+                }
+                if (fill) {
+                    t->indices[entry] = j;
+                    memcpy(&(t->translations[3 * entry]), n, sizeof(int64_t) * 3);
+                    memcpy(&(t->vectors[3 * entry]), v, sizeof(double) * 3);
+                }
+                entry++;
+            }
+        }
+    }
+    return entry;
+}
+
+neighbor_table_t* neighbor_table_init(double* lattice, double* frac_coords, size_t atoms, double cutoff) {
+    neighbor_table_t* t = calloc(1, sizeof(neighbor_table_t));
+    double widths[3];
+    size_t entry = 0;
+
+    if (!t) {
+        return NULL;
+    }
+    t->atoms = atoms;
+    t->cutoff = cutoff;
+    for (size_t k = 0; k < 3; k++) {
+        widths[k] = __neighbor_list_width(lattice, k);
+    }
+    t->offsets = calloc(atoms + 1, sizeof(size_t));
+    if (!t->offsets) {
+        neighbor_table_destroy(t);
+        return NULL;
+    }
+    for (size_t i = 0; i < atoms; i++) {
+        for (size_t j = 0; j < atoms; j++) {
+            entry = __neighbor_table_images(t, lattice, frac_coords, widths, i, j, entry, false);
+        }
+        t->offsets[i + 1] = entry;
+    }
+    t->entries = entry;
+    t->indices = malloc(sizeof(size_t) * (entry > 0 ? entry : 1));
+    t->translations = malloc(sizeof(int64_t) * 3 * (entry > 0 ? entry : 1));
+    t->vectors = malloc(sizeof(double) * 3 * (entry > 0 ? entry : 1));
+    if (!t->indices || !t->translations || !t->vectors) {
+        neighbor_table_destroy(t);
+        return NULL;
+    }
+    entry = 0;
+    for (size_t i = 0; i < atoms; i++) {
+        for (size_t j = 0; j < atoms; j++) {
+            entry = __neighbor_table_images(t, lattice, frac_coords, widths, i, j, entry, true);
+        }
+    }
+    return t;
+}
+
+void neighbor_table_destroy(neighbor_table_t* t) {
+    if (t) {
+        free(t->offsets);
+        free(t->indices);
+        free(t->translations);
+        free(t->vectors);
+        free(t);
+    }
+}
+
+/* The supercell takes ownership of the table, its rows are derived from the table in the two passes */
+neighbor_list_t* neighbor_list_supercell(neighbor_table_t* table, size_t* multiples) {
+    neighbor_list_t* nl = calloc(1, sizeof(neighbor_list_t));
+    size_t cells = multiples[0] * multiples[1] * multiples[2];
+
+    if (!nl) {
+        return NULL;
+    }
+    nl->atoms = table->atoms * cells;
+    nl->cutoff = table->cutoff;
+    memcpy(nl->multiples, multiples, sizeof(size_t) * 3);
+    nl->bins[0] = cells;
+    nl->bins[1] = nl->bins[2] = 1;
+    nl->offsets = calloc(nl->atoms + 1, sizeof(size_t));
+    if (!nl->offsets) {
+        free(nl);
+        return NULL;
+    }
+    nl->table = table;
+    return nl;
+}
+
+neighbor_list_t* neighbor_list_init(double* lattice, double* frac_coords, size_t atoms, double cutoff) {
+    neighbor_list_t* nl = calloc(1, sizeof(neighbor_list_t));
+    size_t cells, largest, *fill;
+    double width;
+
+    if (!nl) {
+        return NULL;
+    }
+    nl->atoms = atoms;
+    nl->cutoff = cutoff;
+    memcpy(nl->lattice, lattice, sizeof(double) * 9);
+    for (size_t k = 0; k < 3; k++) {
+        width = __neighbor_list_width(lattice, k);
+        nl->bins[k] = (cutoff > 0.0 && width > cutoff) ? (size_t) (width / cutoff) : 1;
+    }
+    //More cells than sites only cost time, a tiny cutoff must not create a huge grid
+    while (nl->bins[0] * nl->bins[1] * nl->bins[2] > (atoms > 0 ? atoms : 1)) {
+        largest = (nl->bins[0] >= nl->bins[1] && nl->bins[0] >= nl->bins[2]) ? 0 : (nl->bins[1] >= nl->bins[2] ? 1 : 2);
+        nl->bins[largest] = nl->bins[largest] / 2 > 0 ? nl->bins[largest] / 2 : 1;
+    }
+    for (size_t k = 0; k < 3; k++) {
+        width = __neighbor_list_width(lattice, k);
+        nl->reach[k] = cutoff > 0.0 ? (size_t) ceil(cutoff * nl->bins[k] / width) : 0;
+    }
+    cells = nl->bins[0] * nl->bins[1] * nl->bins[2];
+
+    nl->frac = malloc(sizeof(double) * 3 * (atoms > 0 ? atoms : 1));
+    nl->cell_start = calloc(cells + 1, sizeof(size_t));
+    nl->cell_sites = malloc(sizeof(size_t) * (atoms > 0 ? atoms : 1));
+    nl->offsets = calloc(atoms + 1, sizeof(size_t));
+    fill = calloc(cells, sizeof(size_t));
+    if (!nl->frac || !nl->cell_start || !nl->cell_sites || !nl->offsets || !fill) {
+        free(fill);
+        neighbor_list_destroy(nl);
+        return NULL;
+    }
+    //Counting sort of the sites into their cells, the coordinates are wrapped into [0, 1)
+    for (size_t i = 0; i < atoms; i++) {
+        for (size_t k = 0; k < 3; k++) {
+            nl->frac[3 * i + k] = frac_coords[3 * i + k] - floor(frac_coords[3 * i + k]);
+        }
+        nl->cell_start[(__neighbor_list_bin(nl->frac[3 * i], nl->bins[0]) * nl->bins[1]
+                        + __neighbor_list_bin(nl->frac[3 * i + 1], nl->bins[1])) * nl->bins[2]
+                       + __neighbor_list_bin(nl->frac[3 * i + 2], nl->bins[2]) + 1]++;
+    }
+    for (size_t c = 0; c < cells; c++) {
+        nl->cell_start[c + 1] += nl->cell_start[c];
+    }
+    for (size_t i = 0; i < atoms; i++) {
+        size_t c = (__neighbor_list_bin(nl->frac[3 * i], nl->bins[0]) * nl->bins[1]
+                    + __neighbor_list_bin(nl->frac[3 * i + 1], nl->bins[1])) * nl->bins[2]
+                   + __neighbor_list_bin(nl->frac[3 * i + 2], nl->bins[2]);
+        nl->cell_sites[nl->cell_start[c] + fill[c]++] = i;
+    }
+    free(fill);
+    return nl;
+}
+
+size_t neighbor_list_cells(neighbor_list_t* nl) {
+    return nl->bins[0] * nl->bins[1] * nl->bins[2];
+}
+
+/* Collects the shortest image of every site within the cutoff of site i in the workspace */
+static void __neighbor_list_search_internal(neighbor_list_t* nl, size_t i, neighbor_workspace_t* w) {
+    double* fi = &(nl->frac[3 * i]);
+    double cutoff2 = nl->cutoff * nl->cutoff;
+    int64_t home[3], bins[3], reach[3], shift[3], wrapped[3], d[3];
+    double diff[3], v[3], d2;
+    size_t cell, j;
+
+    w->count = 0;
+    w->generation++;
+    for (size_t k = 0; k < 3; k++) {
+        bins[k] = (int64_t) nl->bins[k];
+        reach[k] = (int64_t) nl->reach[k];
+        home[k] = (int64_t) __neighbor_list_bin(fi[k], nl->bins[k]);
+    }
+    for (d[0] = -reach[0]; d[0] <= reach[0]; d[0]++) {
+        for (d[1] = -reach[1]; d[1] <= reach[1]; d[1]++) {
+            for (d[2] = -reach[2]; d[2] <= reach[2]; d[2]++) {
+                for (size_t k = 0; k < 3; k++) {
+                    //Floor division, a bin beyond the border is a bin of the neighboring image
+                    wrapped[k] = home[k] + d[k];
+                    shift[k] = wrapped[k] >= 0 ? wrapped[k] / bins[k] : -((-wrapped[k] + bins[k] - 1) / bins[k]);
+                    wrapped[k] -= shift[k] * bins[k];
+                }
+                cell = ((size_t) wrapped[0] * nl->bins[1] + (size_t) wrapped[1]) * nl->bins[2] + (size_t) wrapped[2];
+                for (size_t s = nl->cell_start[cell]; s < nl->cell_start[cell + 1]; s++) {
+                    j = nl->cell_sites[s];
+                    if (j == i) {
+                        continue;
+                    }
+                    for (size_t k = 0; k < 3; k++) {
+                        diff[k] = nl->frac[3 * j + k] + (double) shift[k] - fi[k];
+                    }
+                    for (size_t c = 0; c < 3; c++) {
+                        v[c] = diff[0] * nl->lattice[c] + diff[1] * nl->lattice[3 + c] + diff[2] * nl->lattice[6 + c];
+                    }
+                    d2 = v[0] * v[0] + v[1] * v[1] + v[2] * v[2];
+                    if (d2 <= cutoff2) {
+                        __neighbor_workspace_offer(w, j, d2, v);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* Moves the neighbors of unit cell site s from translation c to the neighboring translations of the supercell */
+static void __neighbor_list_map_internal(neighbor_list_t* nl, size_t s, size_t c, neighbor_workspace_t* w) {
+    neighbor_table_t* t = nl->table;
+    size_t cells = nl->bins[0], i = s * cells + c, j;
+    int64_t m[3], home[3], n[3];
+    double* v;
+
+    w->count = 0;
+    w->generation++;
+    for (size_t k = 0; k < 3; k++) {
+        m[k] = (int64_t) nl->multiples[k];
+    }
+    home[0] = (int64_t) (c / (nl->multiples[1] * nl->multiples[2]));
+    home[1] = (int64_t) ((c / nl->multiples[2]) % nl->multiples[1]);
+    home[2] = (int64_t) (c % nl->multiples[2]);
+    for (size_t e = t->offsets[s]; e < t->offsets[s + 1]; e++) {
+        for (size_t k = 0; k < 3; k++) {
+            n[k] = (home[k] + t->translations[3 * e + k]) % m[k];
+            n[k] += n[k] < 0 ? m[k] : 0;
+        }
+        j = t->indices[e] * cells + (size_t) ((n[0] * m[1] + n[1]) * m[2] + n[2]);
+        //Small supercells map several images onto the same pair or onto the site itself
+        if (j != i) {
+            v = &(t->vectors[3 * e]);
+            __neighbor_workspace_offer(w, j, v[0] * v[0] + v[1] * v[1] + v[2] * v[2], v);
+        }
+    }
+}
+
+/* Number of sites of a cell, the k-th one is returned by __neighbor_list_site */
+static inline size_t __neighbor_list_cell_size(neighbor_list_t* nl, size_t cell) {
+    return nl->table ? nl->table->atoms : nl->cell_start[cell + 1] - nl->cell_start[cell];
+}
+
+static inline size_t __neighbor_list_site(neighbor_list_t* nl, size_t cell, size_t k) {
+    return nl->table ? k * nl->bins[0] + cell : nl->cell_sites[nl->cell_start[cell] + k];
+}
+
+static inline void __neighbor_list_gather_internal(neighbor_list_t* nl, size_t cell, size_t k, neighbor_workspace_t* w) {
+    if (nl->table) {
+        __neighbor_list_map_internal(nl, k, cell, w);
+    }
+    else {
+        __neighbor_list_search_internal(nl, __neighbor_list_site(nl, cell, k), w);
+    }
+}
+
+/* First pass, stores the number of pairs of every site of the cell in offsets[i + 1] */
+void neighbor_list_count(neighbor_list_t* nl, size_t cell, neighbor_workspace_t* w) {
+    for (size_t k = 0; k < __neighbor_list_cell_size(nl, cell); k++) {
+        __neighbor_list_gather_internal(nl, cell, k, w);
+        nl->offsets[__neighbor_list_site(nl, cell, k) + 1] = w->count;
+    }
+}
+
+/* Turns the counts into row offsets and allocates the pairs, must be called between the two passes */
+bool neighbor_list_allocate(neighbor_list_t* nl) {
+    for (size_t i = 0; i < nl->atoms; i++) {
+        nl->offsets[i + 1] += nl->offsets[i];
+    }
+    nl->pairs = nl->offsets[nl->atoms];
+    nl->indices = malloc(sizeof(size_t) * (nl->pairs > 0 ? nl->pairs : 1));
+    nl->distances = malloc(sizeof(double) * (nl->pairs > 0 ? nl->pairs : 1));
+    nl->vectors = malloc(sizeof(double) * 3 * (nl->pairs > 0 ? nl->pairs : 1));
+    return nl->indices && nl->distances && nl->vectors;
+}
+
+/* Second pass, the rows of different cells are disjoint thus cells may be filled concurrently */
+void neighbor_list_fill(neighbor_list_t* nl, size_t cell, neighbor_workspace_t* w) {
+    size_t i, j, p;
+    for (size_t s = 0; s < __neighbor_list_cell_size(nl, cell); s++) {
+        i = __neighbor_list_site(nl, cell, s);
+        __neighbor_list_gather_internal(nl, cell, s, w);
+        qsort(w->touched, w->count, sizeof(size_t), __neighbor_list_index_compare);
+        for (size_t k = 0; k < w->count; k++) {
+            j = w->touched[k];
+            p = nl->offsets[i] + k;
+            nl->indices[p] = j;
+            nl->distances[p] = sqrt(w->d2[j]);
+            memcpy(&(nl->vectors[3 * p]), &(w->vectors[3 * j]), sizeof(double) * 3);
+        }
+    }
+}
+
+static int __neighbor_list_pair_compare(const void* a, const void* b) {
+    const size_t* x = a;
+    const size_t* y = b;
+    return (x[0] > y[0]) - (x[0] < y[0]);
+}
+
+/*
+ * Relabels the sites, new site i is old site order[i] and rank is the inverse of order. The new list has only rows,
+ * sorted by the new indices as in a searched list
+ */
+neighbor_list_t* neighbor_list_reorder(neighbor_list_t* nl, size_t* order, size_t* rank) {
+    neighbor_list_t* r = calloc(1, sizeof(neighbor_list_t));
+    size_t largest = 0, n, old, p, q, *pairs;
+
+    if (!r) {
+        return NULL;
+    }
+    r->atoms = nl->atoms;
+    r->cutoff = nl->cutoff;
+    r->pairs = nl->pairs;
+    r->offsets = calloc(nl->atoms + 1, sizeof(size_t));
+    r->indices = malloc(sizeof(size_t) * (nl->pairs > 0 ? nl->pairs : 1));
+    r->distances = malloc(sizeof(double) * (nl->pairs > 0 ? nl->pairs : 1));
+    r->vectors = malloc(sizeof(double) * 3 * (nl->pairs > 0 ? nl->pairs : 1));
+    if (!r->offsets || !r->indices || !r->distances || !r->vectors) {
+        neighbor_list_destroy(r);
+        return NULL;
+    }
+    for (size_t i = 0; i < nl->atoms; i++) {
+        n = nl->offsets[order[i] + 1] - nl->offsets[order[i]];
+        r->offsets[i + 1] = r->offsets[i] + n;
+        largest = n > largest ? n : largest;
+    }
+    //Pairs of (new index, old pair) of one row
+    pairs = malloc(sizeof(size_t) * 2 * (largest > 0 ? largest : 1));
+    if (!pairs) {
+        neighbor_list_destroy(r);
+        return NULL;
+    }
+    for (size_t i = 0; i < nl->atoms; i++) {
+        old = order[i];
+        n = nl->offsets[old + 1] - nl->offsets[old];
+        for (size_t k = 0; k < n; k++) {
+            pairs[2 * k] = rank[nl->indices[nl->offsets[old] + k]];
+            pairs[2 * k + 1] = nl->offsets[old] + k;
+        }
+        qsort(pairs, n, sizeof(size_t) * 2, __neighbor_list_pair_compare);
+        for (size_t k = 0; k < n; k++) {
+            p = r->offsets[i] + k;
+            q = pairs[2 * k + 1];
+            r->indices[p] = pairs[2 * k];
+            r->distances[p] = nl->distances[q];
+            memcpy(&(r->vectors[3 * p]), &(nl->vectors[3 * q]), sizeof(double) * 3);
+        }
+    }
+    free(pairs);
+    return r;
+}
+
+void neighbor_list_destroy(neighbor_list_t* nl) {
+    if (nl) {
+        free(nl->frac);
+        free(nl->cell_start);
+        free(nl->cell_sites);
+        free(nl->offsets);
+        free(nl->indices);
+        free(nl->distances);
+        free(nl->vectors);
+        neighbor_table_destroy(nl->table);
+        free(nl);
+    }
+}
+
+neighbor_workspace_t* neighbor_workspace_init(size_t atoms) {
+    neighbor_workspace_t* w = calloc(1, sizeof(neighbor_workspace_t));
+    size_t n = atoms > 0 ? atoms : 1;
+    if (w) {
+        w->atoms = atoms;
+        w->stamps = calloc(n, sizeof(size_t));
+        w->touched = malloc(sizeof(size_t) * n);
+        w->d2 = malloc(sizeof(double) * n);
+        w->vectors = malloc(sizeof(double) * 3 * n);
+        if (!w->stamps || !w->touched || !w->d2 || !w->vectors) {
+            neighbor_workspace_destroy(w);
+            return NULL;
+        }
+    }
+    return w;
+}
+
+void neighbor_workspace_destroy(neighbor_workspace_t* w) {
+    if (w) {
+        free(w->stamps);
+        free(w->touched);
+        free(w->d2);
+        free(w->vectors);
+        free(w);
+    }
+}
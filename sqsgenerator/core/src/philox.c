@@ -0,0 +1,51 @@
+#include "philox.h"
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+void philox_init(philox_t* p, uint64_t seed, uint64_t stream) {
+    p->key[0] = (uint32_t) seed;
+    p->key[1] = (uint32_t) (seed >> 32);
+    p->counter[0] = p->counter[1] = p->counter[2] = p->counter[3] = 0;
+    philox_jump(p, 0, stream);
+}
+
+/* Advances the counter by blocks + streams * 2^64, every block holds four numbers. Unused numbers are dropped */
+void philox_jump(philox_t* p, uint64_t blocks, uint64_t streams) {
+    uint64_t low = ((uint64_t) p->counter[1] << 32 | p->counter[0]);
+    uint64_t high = ((uint64_t) p->counter[3] << 32 | p->counter[2]);
+    high += streams + (low + blocks < low ? 1 : 0);
+    low += blocks;
+    p->counter[0] = (uint32_t) low;
+    p->counter[1] = (uint32_t) (low >> 32);
+    p->counter[2] = (uint32_t) high;
+    p->counter[3] = (uint32_t) (high >> 32);
+    p->used = 4;
+}
+
+/* Encrypts the current counter into the output block and moves on to the next one */
+void philox_refill(philox_t* p) {
+    uint32_t c0 = p->counter[0], c1 = p->counter[1], c2 = p->counter[2], c3 = p->counter[3];
+    uint32_t k0 = p->key[0], k1 = p->key[1];
+    uint64_t product0, product1;
+
+    for (int round = 0; round < PHILOX_ROUNDS; round++) {
+        product0 = (uint64_t) PHILOX_M0 * c0;
+        product1 = (uint64_t) PHILOX_M1 * c2;
+        c0 = (uint32_t) (product1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t) product1;
+        c2 = (uint32_t) (product0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t) product0;
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    p->output[0] = c0;
+    p->output[1] = c1;
+    p->output[2] = c2;
+    p->output[3] = c3;
+    philox_jump(p, 1, 0);
+    p->used = 0;
+}
@@ -71,6 +71,183 @@ void permutation_count_mpz(mpz_t mi_result, uint8_t *configuration, size_t atoms
 }
 
 
+void mpz_set_u128(mpz_t result, uint128_t value) {
+    uint64_t words[2] = {(uint64_t) value, (uint64_t) (value >> 64)};
+    mpz_import(result, 2, -1, sizeof(uint64_t), 0, 0, words);
+}
+
+bool mpz_get_u128(uint128_t *result, mpz_t value) {
+    uint64_t words[2] = {0, 0};
+    if (mpz_sgn(value) < 0 || mpz_sizeinbase(value, 2) > 128) {
+        return false;
+    }
+    mpz_export(words, NULL, -1, sizeof(uint64_t), 0, 0, value);
+    *result = ((uint128_t) words[1] << 64) | words[0];
+    return true;
+}
+
+static uint128_t gcd_128(uint128_t a, uint128_t b) {
+    uint128_t t;
+    while (b != 0) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+/* Computes a * b / c where c is known to divide a * b. Returns false if the result does not fit into 128 bits */
+bool mul_div_exact_128(uint128_t *result, uint128_t a, uint128_t b, uint128_t c) {
+    uint128_t product, g;
+    if (!__builtin_mul_overflow(a, b, &product)) {
+        *result = product / c;
+        return true;
+    }
+    /* The intermediate product overflows, cancel the divisor first */
+    g = gcd_128(a, c);
+    if (__builtin_mul_overflow(a / g, b / (c / g), &product)) {
+        return false;
+    }
+    *result = product;
+    return true;
+}
+
+bool permutation_count_128(uint128_t *result, size_t atoms, size_t *hist, size_t species) {
+    uint128_t permutations = 1;
+    size_t n = 0;
+
+    /* Builds the multinomial coefficient species by species, every intermediate value is a multinomial itself */
+    for (size_t j = 0; j < species; j++) {
+        for (size_t k = 1; k <= hist[j]; k++) {
+            n++;
+            if (!mul_div_exact_128(&permutations, permutations, n, k)) {
+                return false;
+            }
+        }
+    }
+    *result = permutations;
+    return n == atoms;
+}
+
+void permutation_count_hist_mpz(mpz_t result, size_t atoms, size_t *hist, size_t species) {
+    uint128_t permutations;
+    mpz_t mi_species_permutations;
+
+    if (permutation_count_128(&permutations, atoms, hist, species)) {
+        mpz_set_u128(result, permutations);
+        return;
+    }
+    mpz_init(mi_species_permutations);
+    factorial_mpz(result, atoms);
+    for (size_t j = 0; j < species; j++) {
+        factorial_mpz(mi_species_permutations, hist[j]);
+        mpz_divexact(result, result, mi_species_permutations);
+    }
+    mpz_clear(mi_species_permutations);
+}
+
+bool rank_permutation_128(uint128_t *result, uint8_t *configuration, size_t atoms, size_t species) {
+    uint128_t rank = 1;
+    uint128_t suffix_permutations = 1;
+    uint128_t temp;
+    size_t _hist[species];
+    uint8_t _x;
+
+    for (size_t j = 0; j < species; j++) {
+        _hist[j] = 0;
+    }
+
+    for (size_t i = 0; i < atoms; i++) {
+        _x = configuration[((atoms - 1) - i)];
+        _hist[_x]++;
+        for (size_t j = 0; j < _x; j++) {
+            if (!mul_div_exact_128(&temp, suffix_permutations, _hist[j], _hist[_x])) {
+                return false;
+            }
+            if (__builtin_add_overflow(rank, temp, &rank)) {
+                return false;
+            }
+        }
+        if (!mul_div_exact_128(&suffix_permutations, suffix_permutations, i + 1, _hist[_x])) {
+            return false;
+        }
+    }
+    *result = rank;
+    return true;
+}
+
+void unrank_permutation_128(uint8_t *configuration, size_t atoms, size_t *hist, size_t species, uint128_t permutations, uint128_t rank) {
+    size_t _hist[species];
+    uint128_t suffix_count = 0;
+
+    /* Return if permutation rank is bigger than the number of perms */
+    if (permutations < rank) {
+        return;
+    }
+
+    for (size_t j = 0; j < species; j++) {
+        _hist[j] = hist[j];
+    }
+
+    for (size_t i = 0; i < atoms; i++) {
+        for (size_t j = 0; j < species; j++) {
+            /* suffix_count is the number of distinct permutations that begin with j, it never exceeds permutations */
+            mul_div_exact_128(&suffix_count, permutations, _hist[j], atoms - i);
+            if (rank <= suffix_count) {
+                configuration[i] = j;
+                permutations = suffix_count;
+                _hist[j]--;
+                break;
+            }
+            rank -= suffix_count;
+        }
+    }
+}
+
+/* Splits the exact range of distinct permutations into "chunks" contiguous slices, sets configuration to the first
+ * permutation of slice "index" and returns the length of the slice (saturated to 64 bits) */
+uint64_t permutation_partition(uint8_t *configuration, size_t atoms, size_t *hist, size_t species, uint64_t index, uint64_t chunks) {
+    uint128_t permutations, q, r, start, end;
+    uint64_t length;
+    mpz_t mi_permutations, mi_start, mi_end, mi_help;
+
+    if (permutation_count_128(&permutations, atoms, hist, species)) {
+        q = permutations / chunks;
+        r = permutations % chunks;
+        start = index * q + ((uint128_t) index * r) / chunks;
+        end = (index + 1) * q + ((uint128_t) (index + 1) * r) / chunks;
+        if (end > start) {
+            unrank_permutation_128(configuration, atoms, hist, species, permutations, start + 1);
+        }
+        return (end - start) > UINT64_MAX ? UINT64_MAX : (uint64_t) (end - start);
+    }
+
+    mpz_init(mi_permutations);
+    mpz_init(mi_start);
+    mpz_init(mi_end);
+    mpz_init(mi_help);
+    permutation_count_hist_mpz(mi_permutations, atoms, hist, species);
+
+    mpz_mul_ui(mi_start, mi_permutations, index);
+    mpz_fdiv_q_ui(mi_start, mi_start, chunks);
+    mpz_mul_ui(mi_end, mi_permutations, index + 1);
+    mpz_fdiv_q_ui(mi_end, mi_end, chunks);
+    mpz_sub(mi_help, mi_end, mi_start);
+    length = mpz_sizeinbase(mi_help, 2) > 64 ? UINT64_MAX : (uint64_t) mpz_get_ui(mi_help);
+
+    if (mpz_sgn(mi_help) > 0) {
+        mpz_add_ui(mi_start, mi_start, 1);
+        unrank_permutation_mpz(configuration, atoms, hist, species, mi_permutations, mi_start);
+    }
+
+    mpz_clear(mi_permutations);
+    mpz_clear(mi_start);
+    mpz_clear(mi_end);
+    mpz_clear(mi_help);
+    return length;
+}
+
+
 
 void rank_permutation_mpz(mpz_t result, uint8_t *configuration, size_t atoms, size_t species) {
     mpz_t mi_rank;
@@ -80,6 +257,13 @@ void rank_permutation_mpz(mpz_t result, uint8_t *configuration, size_t atoms, si
     unsigned long int _hist[species];
     size_t i, j;
     uint8_t _x;
+    uint128_t rank;
+
+    /* Small cells are ranked in native 128 bit arithmetic without touching GMP */
+    if (rank_permutation_128(&rank, configuration, atoms, species)) {
+        mpz_set_u128(result, rank);
+        return;
+    }
 
     for (i = 0; i < species; i++) {
         _hist[i] = 0;
@@ -129,6 +313,12 @@ void unrank_permutation_mpz(uint8_t *configuration, size_t atoms, size_t *hist,
     mpz_t _mi_permutations;
     mpz_t _mi_rank;
     mpz_t _mi_help;
+    uint128_t permutations, rank;
+
+    if (mpz_get_u128(&permutations, mi_permutations) && mpz_get_u128(&rank, mi_rank)) {
+        unrank_permutation_128(configuration, atoms, hist, species, permutations, rank);
+        return;
+    }
 
     /* Initialize helpers */
     mpz_init(_mi_suffixcount);
@@ -203,10 +393,10 @@ bool next_permutation_lex(uint8_t *configuration, size_t atoms) {
     uint8_t temporary;
 
     while (configuration[k] >= configuration[k + 1]) {
-        k -= 1;
-        if (k < 0) {
+        if (k == 0) {
             return false;
         }
+        k -= 1;
     }
 
     while (configuration[k] >= configuration[l]) l -= 1;
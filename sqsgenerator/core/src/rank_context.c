@@ -0,0 +1,286 @@
+#include <string.h>
+#include "rank_context.h"
+
+/*
+ * The multinomial coefficient of every histogram state h (remaining atoms per species) is tabulated at the mixed radix
+ * index sum_j h_j*strides[j]. Placing an atom of species j moves the state index down by strides[j], therefore ranking
+ * and unranking along a configuration reduces to table lookups, additions and subtractions.
+ */
+
+static void __rank_context_fill_internal(rank_context_t* ctx) {
+    size_t digits[ctx->species];
+    size_t n = 0, j;
+    size_t parent;
+
+    for (j = 0; j < ctx->species; j++) {
+        digits[j] = 0;
+    }
+    if (ctx->table) {
+        ctx->table[0] = 1;
+    }
+    else {
+        mpz_set_ui(ctx->table_mpz[0], 1);
+    }
+    for (size_t index = 1; index < ctx->states; index++) {
+        /* Advance the mixed radix counter to the histogram of this index */
+        for (j = 0; j < ctx->species; j++) {
+            if (digits[j] < ctx->hist[j]) {
+                digits[j]++;
+                n++;
+                break;
+            }
+            n -= digits[j];
+            digits[j] = 0;
+        }
+        /* M(h) = M(h - e_j) * |h| / h_j for any species j which is present */
+        for (j = 0; digits[j] == 0; j++);
+        parent = index - ctx->strides[j];
+        if (ctx->table) {
+            mul_div_exact_128(&(ctx->table[index]), ctx->table[parent], n, digits[j]);
+        }
+        else {
+            mpz_mul_ui(ctx->table_mpz[index], ctx->table_mpz[parent], n);
+            mpz_divexact_ui(ctx->table_mpz[index], ctx->table_mpz[index], digits[j]);
+        }
+    }
+}
+
+rank_context_t* rank_context_init(size_t atoms, size_t *hist, size_t species) {
+    rank_context_t* ctx = malloc(sizeof(rank_context_t));
+    size_t states = 1;
+    bool overflow = false;
+
+    if (!ctx) {
+        return NULL;
+    }
+    ctx->hist = malloc(sizeof(size_t) * species);
+    ctx->strides = malloc(sizeof(size_t) * species);
+    if (!ctx->hist || !ctx->strides) {
+        free(ctx->hist);
+        free(ctx->strides);
+        free(ctx);
+        return NULL;
+    }
+    for (size_t j = 0; j < species; j++) {
+        ctx->hist[j] = hist[j];
+        ctx->strides[j] = states;
+        overflow = overflow || __builtin_mul_overflow(states, hist[j] + 1, &states);
+    }
+    ctx->atoms = atoms;
+    ctx->species = species;
+    ctx->states = 0;
+    ctx->table = NULL;
+    ctx->table_mpz = NULL;
+    ctx->count = 0;
+    ctx->wide = !permutation_count_128(&(ctx->count), atoms, hist, species);
+    mpz_init(ctx->permutations);
+    permutation_count_hist_mpz(ctx->permutations, atoms, hist, species);
+
+    if (!overflow) {
+        if (!ctx->wide && states <= RANK_CONTEXT_MAX_STATES) {
+            ctx->table = malloc(sizeof(uint128_t) * states);
+        }
+        else if (ctx->wide && states <= RANK_CONTEXT_MAX_STATES_MPZ) {
+            ctx->table_mpz = malloc(sizeof(mpz_t) * states);
+            if (ctx->table_mpz) {
+                for (size_t i = 0; i < states; i++) {
+                    mpz_init(ctx->table_mpz[i]);
+                }
+            }
+        }
+    }
+    /* Without a table the context falls back to the direct rank functions */
+    if (ctx->table || ctx->table_mpz) {
+        ctx->states = states;
+        __rank_context_fill_internal(ctx);
+    }
+    return ctx;
+}
+
+rank_context_t* rank_context_from_configuration(uint8_t *configuration, size_t atoms) {
+    size_t species = 0;
+    rank_context_t* ctx;
+
+    for (size_t i = 0; i < atoms; i++) {
+        if ((size_t) configuration[i] + 1 > species) {
+            species = (size_t) configuration[i] + 1;
+        }
+    }
+    size_t hist[species];
+    memset(hist, 0, sizeof(size_t) * species);
+    for (size_t i = 0; i < atoms; i++) {
+        hist[configuration[i]]++;
+    }
+    ctx = rank_context_init(atoms, hist, species);
+    return ctx;
+}
+
+void rank_context_destroy(rank_context_t* ctx) {
+    if (ctx) {
+        if (ctx->table_mpz) {
+            for (size_t i = 0; i < ctx->states; i++) {
+                mpz_clear(ctx->table_mpz[i]);
+            }
+        }
+        mpz_clear(ctx->permutations);
+        free(ctx->table_mpz);
+        free(ctx->table);
+        free(ctx->strides);
+        free(ctx->hist);
+        free(ctx);
+    }
+}
+
+void rank_context_count_mpz(rank_context_t* ctx, mpz_t result) {
+    mpz_set(result, ctx->permutations);
+}
+
+static uint128_t __rank_context_rank_128_internal(rank_context_t* ctx, uint8_t *configuration) {
+    size_t _hist[ctx->species];
+    size_t index = ctx->states - 1;
+    uint128_t rank = 1;
+    uint8_t _x;
+
+    memcpy(_hist, ctx->hist, sizeof(size_t) * ctx->species);
+    for (size_t i = 0; i < ctx->atoms; i++) {
+        _x = configuration[i];
+        for (size_t j = 0; j < _x; j++) {
+            if (_hist[j]) {
+                rank += ctx->table[index - ctx->strides[j]];
+            }
+        }
+        _hist[_x]--;
+        index -= ctx->strides[_x];
+    }
+    return rank;
+}
+
+static void __rank_context_unrank_128_internal(rank_context_t* ctx, uint8_t *configuration, uint128_t rank) {
+    size_t _hist[ctx->species];
+    size_t index = ctx->states - 1;
+    uint128_t suffix_count;
+
+    if (rank > ctx->count) {
+        return;
+    }
+    memcpy(_hist, ctx->hist, sizeof(size_t) * ctx->species);
+    for (size_t i = 0; i < ctx->atoms; i++) {
+        for (size_t j = 0; j < ctx->species; j++) {
+            if (!_hist[j]) {
+                continue;
+            }
+            suffix_count = ctx->table[index - ctx->strides[j]];
+            if (rank <= suffix_count) {
+                configuration[i] = j;
+                _hist[j]--;
+                index -= ctx->strides[j];
+                break;
+            }
+            rank -= suffix_count;
+        }
+    }
+}
+
+void rank_context_rank_mpz(rank_context_t* ctx, mpz_t result, uint8_t *configuration) {
+    size_t _hist[ctx->species];
+    size_t index = ctx->states - 1;
+    uint8_t _x;
+
+    if (ctx->table) {
+        mpz_set_u128(result, __rank_context_rank_128_internal(ctx, configuration));
+    }
+    else if (ctx->table_mpz) {
+        memcpy(_hist, ctx->hist, sizeof(size_t) * ctx->species);
+        mpz_set_ui(result, 1);
+        for (size_t i = 0; i < ctx->atoms; i++) {
+            _x = configuration[i];
+            for (size_t j = 0; j < _x; j++) {
+                if (_hist[j]) {
+                    mpz_add(result, result, ctx->table_mpz[index - ctx->strides[j]]);
+                }
+            }
+            _hist[_x]--;
+            index -= ctx->strides[_x];
+        }
+    }
+    else {
+        rank_permutation_mpz(result, configuration, ctx->atoms, ctx->species);
+    }
+}
+
+void rank_context_unrank_mpz(rank_context_t* ctx, uint8_t *configuration, mpz_t rank) {
+    size_t _hist[ctx->species];
+    size_t index = ctx->states - 1;
+    uint128_t rank_128;
+    mpz_t mi_rank;
+
+    if (ctx->table) {
+        if (mpz_get_u128(&rank_128, rank)) {
+            __rank_context_unrank_128_internal(ctx, configuration, rank_128);
+        }
+    }
+    else if (ctx->table_mpz) {
+        if (mpz_cmp(rank, ctx->permutations) > 0) {
+            return;
+        }
+        mpz_init_set(mi_rank, rank);
+        memcpy(_hist, ctx->hist, sizeof(size_t) * ctx->species);
+        for (size_t i = 0; i < ctx->atoms; i++) {
+            for (size_t j = 0; j < ctx->species; j++) {
+                if (!_hist[j]) {
+                    continue;
+                }
+                if (mpz_cmp(mi_rank, ctx->table_mpz[index - ctx->strides[j]]) <= 0) {
+                    configuration[i] = j;
+                    _hist[j]--;
+                    index -= ctx->strides[j];
+                    break;
+                }
+                mpz_sub(mi_rank, mi_rank, ctx->table_mpz[index - ctx->strides[j]]);
+            }
+        }
+        mpz_clear(mi_rank);
+    }
+    else {
+        unrank_permutation_mpz(configuration, ctx->atoms, ctx->hist, ctx->species, ctx->permutations, rank);
+    }
+}
+
+/* Same slicing as permutation_partition, but the multinomials are looked up instead of recomputed */
+uint64_t rank_context_partition(rank_context_t* ctx, uint8_t *configuration, uint64_t index, uint64_t chunks) {
+    uint128_t q, r, start, end;
+    uint64_t length;
+    mpz_t mi_start, mi_end;
+
+    if (!ctx->wide) {
+        q = ctx->count / chunks;
+        r = ctx->count % chunks;
+        start = index * q + ((uint128_t) index * r) / chunks;
+        end = (index + 1) * q + ((uint128_t) (index + 1) * r) / chunks;
+        if (end > start) {
+            if (ctx->table) {
+                __rank_context_unrank_128_internal(ctx, configuration, start + 1);
+            }
+            else {
+                unrank_permutation_128(configuration, ctx->atoms, ctx->hist, ctx->species, ctx->count, start + 1);
+            }
+        }
+        return (end - start) > UINT64_MAX ? UINT64_MAX : (uint64_t) (end - start);
+    }
+
+    mpz_init(mi_start);
+    mpz_init(mi_end);
+    mpz_mul_ui(mi_start, ctx->permutations, index);
+    mpz_fdiv_q_ui(mi_start, mi_start, chunks);
+    mpz_mul_ui(mi_end, ctx->permutations, index + 1);
+    mpz_fdiv_q_ui(mi_end, mi_end, chunks);
+    mpz_sub(mi_end, mi_end, mi_start);
+    length = mpz_sizeinbase(mi_end, 2) > 64 ? UINT64_MAX : (uint64_t) mpz_get_ui(mi_end);
+    if (mpz_sgn(mi_end) > 0) {
+        mpz_add_ui(mi_start, mi_start, 1);
+        rank_context_unrank_mpz(ctx, configuration, mi_start);
+    }
+    mpz_clear(mi_start);
+    mpz_clear(mi_end);
+    return length;
+}
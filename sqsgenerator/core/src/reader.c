@@ -0,0 +1,379 @@
+/* getline and strtok_r are POSIX, the extensions are compiled in strict C mode */
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include "reader.h"
+
+#define READER_MAX_TOKENS 64
+
+/* Splits line in place at whitespace, returns the number of tokens */
+static size_t __reader_tokens(char* line, char** tokens, size_t max_tokens) {
+    size_t count = 0;
+    char* state = NULL;
+    for (char* t = strtok_r(line, " \t\r\n", &state); t && count < max_tokens; t = strtok_r(NULL, " \t\r\n", &state)) {
+        tokens[count++] = t;
+    }
+    return count;
+}
+
+static int __reader_double(const char* token, double* value) {
+    char* end;
+    *value = strtod(token, &end);
+    return end != token && *end == '\0';
+}
+
+static int __reader_size(const char* token, size_t* value) {
+    char* end;
+    unsigned long long v = strtoull(token, &end, 10);
+    *value = (size_t) v;
+    return end != token && *end == '\0' && token[0] != '-';
+}
+
+/* Index of a species, it is added if it was not seen yet. Returns -1 if there are too many species */
+static int __reader_species(reader_structure_t* s, const char* symbol) {
+    char name[READER_SYMBOL_LENGTH];
+    size_t length = 0;
+    //POSCAR files of some tools append a suffix to the element, e.g. "Fe_pv" or "Fe/"
+    while (symbol[length] && length < READER_SYMBOL_LENGTH - 1 && isalpha((unsigned char) symbol[length])) {
+        name[length] = symbol[length];
+        length++;
+    }
+    if (length == 0) {
+        return -1;
+    }
+    name[length] = '\0';
+    for (size_t k = 0; k < s->species; k++) {
+        if (strcmp(s->symbols[k], name) == 0) {
+            return (int) k;
+        }
+    }
+    if (s->species == READER_MAX_SPECIES) {
+        return -1;
+    }
+    strcpy(s->symbols[s->species], name);
+    return (int) s->species++;
+}
+
+static reader_structure_t* __reader_structure_alloc(size_t atoms) {
+    reader_structure_t* s = calloc(1, sizeof(reader_structure_t));
+    if (!s) {
+        return NULL;
+    }
+    s->atoms = atoms;
+    s->frac_coords = malloc(sizeof(double) * 3 * (atoms > 0 ? atoms : 1));
+    s->site_species = malloc(sizeof(uint8_t) * (atoms > 0 ? atoms : 1));
+    if (!s->frac_coords || !s->site_species) {
+        reader_structure_destroy(s);
+        return NULL;
+    }
+    return s;
+}
+
+/* Rows of the inverse lattice, a cartesian vector times it gives fractional coordinates. Returns 0 if singular */
+static int __reader_inverse(double* m, double* inverse) {
+    double det = m[0] * (m[4] * m[8] - m[5] * m[7]) - m[1] * (m[3] * m[8] - m[5] * m[6]) + m[2] * (m[3] * m[7] - m[4] * m[6]);
+    if (fabs(det) < 1e-12) {
+        return 0;
+    }
+    inverse[0] = (m[4] * m[8] - m[5] * m[7]) / det;
+    inverse[1] = (m[2] * m[7] - m[1] * m[8]) / det;
+    inverse[2] = (m[1] * m[5] - m[2] * m[4]) / det;
+    inverse[3] = (m[5] * m[6] - m[3] * m[8]) / det;
+    inverse[4] = (m[0] * m[8] - m[2] * m[6]) / det;
+    inverse[5] = (m[2] * m[3] - m[0] * m[5]) / det;
+    inverse[6] = (m[3] * m[7] - m[4] * m[6]) / det;
+    inverse[7] = (m[1] * m[6] - m[0] * m[7]) / det;
+    inverse[8] = (m[0] * m[4] - m[1] * m[3]) / det;
+    return 1;
+}
+
+static void __reader_fractional(double* inverse, double* cartesian, double* frac) {
+    for (size_t k = 0; k < 3; k++) {
+        frac[k] = cartesian[0] * inverse[k] + cartesian[1] * inverse[3 + k] + cartesian[2] * inverse[6 + k];
+    }
+}
+
+static void __reader_fail(FILE* f, char* line, reader_structure_t* s) {
+    free(line);
+    fclose(f);
+    reader_structure_destroy(s);
+}
+
+/* VASP 4 and 5 POSCAR files. VASP 4 files take the species from the comment line. NULL if the file cannot be read */
+reader_structure_t* reader_read_poscar(const char* path) {
+    FILE* f = fopen(path, "r");
+    char *line = NULL, *tokens[READER_MAX_TOKENS], comment[1024];
+    char names[READER_MAX_TOKENS][READER_SYMBOL_LENGTH];
+    size_t capacity = 0, n, counts[READER_MAX_TOKENS], groups = 0, atoms = 0, site = 0;
+    double scale, lattice[9], inverse[9], position[3], det;
+    int cartesian, species;
+    reader_structure_t* s = NULL;
+
+    if (!f) {
+        return NULL;
+    }
+    if (getline(&line, &capacity, f) < 0) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    strncpy(comment, line, sizeof(comment) - 1);
+    comment[sizeof(comment) - 1] = '\0';
+    if (getline(&line, &capacity, f) < 0 || __reader_tokens(line, tokens, READER_MAX_TOKENS) < 1 || !__reader_double(tokens[0], &scale)) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    for (size_t r = 0; r < 3; r++) {
+        if (getline(&line, &capacity, f) < 0 || __reader_tokens(line, tokens, READER_MAX_TOKENS) < 3) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+        for (size_t c = 0; c < 3; c++) {
+            if (!__reader_double(tokens[c], &lattice[3 * r + c])) {
+                __reader_fail(f, line, s);
+                return NULL;
+            }
+        }
+    }
+    //Species names (VASP 5) or the counts right away (VASP 4)
+    if (getline(&line, &capacity, f) < 0 || (n = __reader_tokens(line, tokens, READER_MAX_TOKENS)) < 1) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    if (__reader_size(tokens[0], &counts[0])) {
+        groups = n;
+        for (size_t k = 0; k < n; k++) {
+            if (!__reader_size(tokens[k], &counts[k])) {
+                __reader_fail(f, line, s);
+                return NULL;
+            }
+        }
+        if (__reader_tokens(comment, tokens, READER_MAX_TOKENS) < groups) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+        for (size_t k = 0; k < groups; k++) {
+            strncpy(names[k], tokens[k], READER_SYMBOL_LENGTH - 1);
+            names[k][READER_SYMBOL_LENGTH - 1] = '\0';
+        }
+    }
+    else {
+        groups = n;
+        for (size_t k = 0; k < n; k++) {
+            strncpy(names[k], tokens[k], READER_SYMBOL_LENGTH - 1);
+            names[k][READER_SYMBOL_LENGTH - 1] = '\0';
+        }
+        if (getline(&line, &capacity, f) < 0 || __reader_tokens(line, tokens, READER_MAX_TOKENS) != groups) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+        for (size_t k = 0; k < groups; k++) {
+            if (!__reader_size(tokens[k], &counts[k])) {
+                __reader_fail(f, line, s);
+                return NULL;
+            }
+        }
+    }
+    for (size_t k = 0; k < groups; k++) {
+        atoms += counts[k];
+    }
+    //Optional selective dynamics, then the coordinate mode
+    if (getline(&line, &capacity, f) < 0 || __reader_tokens(line, tokens, READER_MAX_TOKENS) < 1) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    if (tokens[0][0] == 's' || tokens[0][0] == 'S') {
+        if (getline(&line, &capacity, f) < 0 || __reader_tokens(line, tokens, READER_MAX_TOKENS) < 1) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+    }
+    cartesian = strchr("cCkK", tokens[0][0]) != NULL;
+
+    det = lattice[0] * (lattice[4] * lattice[8] - lattice[5] * lattice[7]) - lattice[1] * (lattice[3] * lattice[8] - lattice[5] * lattice[6])
+          + lattice[2] * (lattice[3] * lattice[7] - lattice[4] * lattice[6]);
+    //A negative scale is the volume of the cell
+    if (scale < 0.0) {
+        scale = cbrt(-scale / fabs(det));
+    }
+    s = __reader_structure_alloc(atoms);
+    if (!s) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    for (size_t k = 0; k < 9; k++) {
+        s->lattice[k] = lattice[k] * scale;
+    }
+    if (!__reader_inverse(s->lattice, inverse)) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    for (size_t k = 0; k < groups; k++) {
+        if ((species = __reader_species(s, names[k])) < 0) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+        for (size_t c = 0; c < counts[k]; c++, site++) {
+            if (getline(&line, &capacity, f) < 0 || __reader_tokens(line, tokens, READER_MAX_TOKENS) < 3) {
+                __reader_fail(f, line, s);
+                return NULL;
+            }
+            for (size_t d = 0; d < 3; d++) {
+                if (!__reader_double(tokens[d], &position[d])) {
+                    __reader_fail(f, line, s);
+                    return NULL;
+                }
+            }
+            if (cartesian) {
+                for (size_t d = 0; d < 3; d++) {
+                    position[d] *= scale;
+                }
+                __reader_fractional(inverse, position, &(s->frac_coords[3 * site]));
+            }
+            else {
+                memcpy(&(s->frac_coords[3 * site]), position, sizeof(double) * 3);
+            }
+            s->site_species[site] = (uint8_t) species;
+        }
+    }
+    free(line);
+    fclose(f);
+    return s;
+}
+
+/* Value of key="..." or key=... in the comment line of an extended XYZ file, copied into value. Keys are matched
+ * regardless of their case, lattice= is as good as Lattice= */
+static int __reader_xyz_value(const char* comment, const char* key, char* value, size_t size) {
+    size_t length = strlen(key), k = 0;
+    const char* p;
+    char end;
+    for (p = comment; *p; p++) {
+        if ((p == comment || isspace((unsigned char) p[-1])) && strncasecmp(p, key, length) == 0 && p[length] == '=') {
+            p += length + 1;
+            end = (*p == '"') ? '"' : ' ';
+            p += (*p == '"');
+            while (*p && *p != end && *p != '\n' && k < size - 1) {
+                value[k++] = *p++;
+            }
+            value[k] = '\0';
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Extended XYZ files with a Lattice entry, the positions are cartesian. NULL if the file cannot be read */
+reader_structure_t* reader_read_xyz(const char* path) {
+    FILE* f = fopen(path, "r");
+    char *line = NULL, *tokens[READER_MAX_TOKENS], *fields[3 * READER_MAX_TOKENS], *state = NULL;
+    char value[4096];
+    size_t capacity = 0, atoms, n, column = 0, species_column = 0, position_column = 1, count;
+    double inverse[9], position[3];
+    int species;
+    reader_structure_t* s = NULL;
+
+    if (!f) {
+        return NULL;
+    }
+    if (getline(&line, &capacity, f) < 0 || __reader_tokens(line, tokens, READER_MAX_TOKENS) != 1 || !__reader_size(tokens[0], &atoms)) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    s = __reader_structure_alloc(atoms);
+    if (!s || getline(&line, &capacity, f) < 0 || !__reader_xyz_value(line, "Lattice", value, sizeof(value))) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    if (__reader_tokens(value, tokens, READER_MAX_TOKENS) != 9) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    for (size_t k = 0; k < 9; k++) {
+        if (!__reader_double(tokens[k], &(s->lattice[k]))) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+    }
+    //Properties=name:type:columns:... gives the columns of the species and of the positions
+    if (__reader_xyz_value(line, "Properties", value, sizeof(value))) {
+        n = 0;
+        for (char* t = strtok_r(value, ":", &state); t && n < 3 * READER_MAX_TOKENS; t = strtok_r(NULL, ":", &state)) {
+            fields[n++] = t;
+        }
+        species_column = position_column = (size_t) -1;
+        for (size_t k = 0; k + 2 < n; k += 3) {
+            if (!__reader_size(fields[k + 2], &count)) {
+                __reader_fail(f, line, s);
+                return NULL;
+            }
+            if (strcmp(fields[k], "species") == 0) {
+                species_column = column;
+            }
+            else if (strcmp(fields[k], "pos") == 0 && count == 3) {
+                position_column = column;
+            }
+            column += count;
+        }
+        if (species_column == (size_t) -1 || position_column == (size_t) -1) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+    }
+    if (!__reader_inverse(s->lattice, inverse)) {
+        __reader_fail(f, line, s);
+        return NULL;
+    }
+    for (size_t i = 0; i < atoms; i++) {
+        if (getline(&line, &capacity, f) < 0) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+        n = __reader_tokens(line, tokens, READER_MAX_TOKENS);
+        if (n <= species_column || n < position_column + 3 || (species = __reader_species(s, tokens[species_column])) < 0) {
+            __reader_fail(f, line, s);
+            return NULL;
+        }
+        for (size_t d = 0; d < 3; d++) {
+            if (!__reader_double(tokens[position_column + d], &position[d])) {
+                __reader_fail(f, line, s);
+                return NULL;
+            }
+        }
+        __reader_fractional(inverse, position, &(s->frac_coords[3 * i]));
+        s->site_species[i] = (uint8_t) species;
+    }
+    free(line);
+    fclose(f);
+    return s;
+}
+
+/*
+ * Fractional coordinates of the supercell in the order of make_supercell, site s of translation (a, b, c) is written
+ * to s * cells + (a * multiples[1] + b) * multiples[2] + c. result holds 3 * atoms * cells values
+ */
+void reader_expand(double* frac_coords, size_t atoms, size_t* multiples, double* result) {
+    size_t cells = multiples[0] * multiples[1] * multiples[2], t[3], c;
+    double* out;
+    for (size_t s = 0; s < atoms; s++) {
+        for (c = 0; c < cells; c++) {
+            t[0] = c / (multiples[1] * multiples[2]);
+            t[1] = (c / multiples[2]) % multiples[1];
+            t[2] = c % multiples[2];
+            out = &result[3 * (s * cells + c)];
+            for (size_t k = 0; k < 3; k++) {
+                out[k] = (frac_coords[3 * s + k] + (double) t[k]) / (double) multiples[k];
+            }
+        }
+    }
+}
+
+void reader_structure_destroy(reader_structure_t* s) {
+    if (s) {
+        free(s->frac_coords);
+        free(s->site_species);
+        free(s);
+    }
+}
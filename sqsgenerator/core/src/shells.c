@@ -0,0 +1,106 @@
+#include <math.h>
+#include <string.h>
+#include "shells.h"
+
+static int __shell_table_distance_compare(const void* a, const void* b) {
+    double x = *(const double*) a, y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+static inline bool __shell_table_close(double a, double b, double rel_tol) {
+    return fabs(a - b) <= rel_tol * fmax(fabs(a), fabs(b));
+}
+
+shell_table_t* shell_table_init(neighbor_list_t* nl, size_t* rows, size_t nrows, double rel_tol) {
+    shell_table_t* st = calloc(1, sizeof(shell_table_t));
+    size_t total = 0, n = 0;
+    double* distances;
+
+    if (!st) {
+        return NULL;
+    }
+    st->rel_tol = rel_tol;
+    for (size_t r = 0; r < nrows; r++) {
+        total += nl->offsets[rows[r] + 1] - nl->offsets[rows[r]];
+    }
+    distances = malloc(sizeof(double) * (total > 0 ? total : 1));
+    if (!distances) {
+        free(st);
+        return NULL;
+    }
+    for (size_t r = 0; r < nrows; r++) {
+        memcpy(&distances[n], &(nl->distances[nl->offsets[rows[r]]]), sizeof(double) * (nl->offsets[rows[r] + 1] - nl->offsets[rows[r]]));
+        n += nl->offsets[rows[r] + 1] - nl->offsets[rows[r]];
+    }
+    qsort(distances, total, sizeof(double), __shell_table_distance_compare);
+    //The radii are compacted in place, there are never more shells than distances
+    for (size_t k = 0; k < total; k++) {
+        if (st->count == 0 || !__shell_table_close(distances[st->count - 1], distances[k], rel_tol)) {
+            distances[st->count++] = distances[k];
+        }
+    }
+    st->radii = distances;
+    return st;
+}
+
+/* Drops the shells beyond count, their pairs are classified as shell 0 */
+void shell_table_truncate(shell_table_t* st, size_t count) {
+    if (count < st->count) {
+        st->count = count;
+    }
+}
+
+/* Shell id of a distance, the candidate is the largest radius not above it */
+uint8_t shell_table_find(shell_table_t* st, double distance) {
+    size_t low = 0, high = st->count, mid;
+    while (low < high) {
+        mid = (low + high) / 2;
+        if (st->radii[mid] <= distance) {
+            low = mid + 1;
+        }
+        else {
+            high = mid;
+        }
+    }
+    //A distance slightly below the smallest member still belongs to the next shell
+    if (low < st->count && __shell_table_close(st->radii[low], distance, st->rel_tol)) {
+        return (uint8_t) (low + 1);
+    }
+    if (low > 0 && __shell_table_close(st->radii[low - 1], distance, st->rel_tol)) {
+        return (uint8_t) low;
+    }
+    return 0;
+}
+
+/* Writes the shell of every neighbor of site i into row and counts them per shell, rows may be classified concurrently */
+void shell_table_classify(shell_table_t* st, neighbor_list_t* nl, size_t i, uint8_t* row, size_t* counts) {
+    uint8_t shell;
+    memset(counts, 0, sizeof(size_t) * st->count);
+    for (size_t p = nl->offsets[i]; p < nl->offsets[i + 1]; p++) {
+        shell = shell_table_find(st, nl->distances[p]);
+        row[nl->indices[p]] = shell;
+        if (shell > 0) {
+            counts[shell - 1]++;
+        }
+    }
+}
+
+/* Like shell_table_classify, but the shell of pair p of the row is written to shells[p], no dense row is needed */
+void shell_table_classify_pairs(shell_table_t* st, neighbor_list_t* nl, size_t i, uint8_t* shells, size_t* counts) {
+    uint8_t shell;
+    memset(counts, 0, sizeof(size_t) * st->count);
+    for (size_t p = nl->offsets[i]; p < nl->offsets[i + 1]; p++) {
+        shell = shell_table_find(st, nl->distances[p]);
+        shells[p] = shell;
+        if (shell > 0) {
+            counts[shell - 1]++;
+        }
+    }
+}
+
+void shell_table_destroy(shell_table_t* st) {
+    if (st) {
+        free(st->radii);
+        free(st);
+    }
+}
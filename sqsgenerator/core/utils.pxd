@@ -4,22 +4,129 @@ from libc.stdint cimport uint8_t, uint32_t, uint64_t
 cdef extern from "<gmp.h>" nogil:
     ctypedef struct mpz_t
 
+cdef extern from "include/philox.h" nogil:
+    ctypedef struct philox_t:
+        uint32_t counter[4]
+        uint32_t key[2]
+
+    cdef void philox_init(philox_t* p, uint64_t seed, uint64_t stream) nogil
+    cdef void philox_jump(philox_t* p, uint64_t blocks, uint64_t streams) nogil
+    cdef uint32_t philox_next(philox_t* p) nogil
+    cdef uint32_t philox_bounded(philox_t* p, uint32_t n) nogil
+
 cdef extern from "include/utils.h" nogil:
     cdef void factorial_mpz(mpz_t mi_result, uint64_t n) nogil
-    cdef inline uint32_t xor32() nogil
-    cdef inline uint32_t xor64() nogil
-    cdef inline uint32_t xor96() nogil
-    cdef inline uint32_t xor128() nogil
-    cdef inline uint32_t xor160() nogil
-    cdef inline uint32_t xorwow() nogil
-    cdef inline uint32_t rand_int(uint32_t n) nogil
-    cdef void reseed_xor() nogil
-    cdef bint knuth_fisher_yates_shuffle(uint8_t *configuration, size_t atoms) nogil
+    cdef bint knuth_fisher_yates_shuffle(philox_t* rng, uint8_t *configuration, size_t atoms) nogil
 
 cdef extern from "include/rank.h" nogil:
+    # The exact width is only known to the C compiler
+    ctypedef unsigned long long uint128_t
+
     cdef void permutation_count_mpz(mpz_t mi_result, uint8_t *configuration, size_t atoms) nogil
     cdef uint64_t rank_permutation(uint8_t *configuration, size_t atoms, size_t species) nogil
     cdef void rank_permutation_mpz(mpz_t result, uint8_t *configuration, size_t atoms, size_t species) nogil
     cdef void unrank_permutation_mpz(uint8_t *configuration, size_t atoms, size_t *hist, size_t species, mpz_t mi_permutations, mpz_t mi_rank) nogil
     cdef void unrank_permutation(uint8_t *configuration, size_t atoms, size_t *hist, size_t species, uint64_t permutations, uint64_t rank) nogil
     cdef bint next_permutation_lex(uint8_t *configuration, size_t atoms) nogil
+    cdef uint64_t permutation_partition(uint8_t *configuration, size_t atoms, size_t *hist, size_t species, uint64_t index, uint64_t chunks) nogil
+
+cdef extern from "include/rank_context.h" nogil:
+    ctypedef struct rank_context_t:
+        size_t atoms
+        size_t species
+        bint wide
+
+    cdef rank_context_t* rank_context_init(size_t atoms, size_t *hist, size_t species) nogil
+    cdef void rank_context_destroy(rank_context_t* ctx) nogil
+    cdef void rank_context_rank_mpz(rank_context_t* ctx, mpz_t result, uint8_t *configuration) nogil
+    cdef void rank_context_unrank_mpz(rank_context_t* ctx, uint8_t *configuration, mpz_t rank) nogil
+    cdef uint64_t rank_context_partition(rank_context_t* ctx, uint8_t *configuration, uint64_t index, uint64_t chunks) nogil
+
+cdef extern from "include/binary.h" nogil:
+    cdef size_t BINARY_MAX_ATOMS
+
+    ctypedef struct binary_sqs_t:
+        size_t atoms
+        size_t ones
+        size_t shell_count
+
+    cdef binary_sqs_t* binary_sqs_init(size_t atoms, size_t ones, size_t shell_count, uint8_t *shell_matrix, double *shell_factors, double *shell_targets) nogil
+    cdef void binary_sqs_destroy(binary_sqs_t* b) nogil
+    cdef double binary_sqs_objective(binary_sqs_t* b, uint128_t mask, double *decomposition) nogil
+    cdef uint128_t binary_random_mask(binary_sqs_t* b, philox_t* rng) nogil
+    cdef bint binary_next_mask(binary_sqs_t* b, uint128_t *mask) nogil
+    cdef uint64_t binary_partition(binary_sqs_t* b, uint128_t *mask, uint64_t index, uint64_t chunks) nogil
+    cdef void binary_mask_to_configuration(binary_sqs_t* b, uint128_t mask, uint8_t *configuration) nogil
+
+cdef extern from "include/arena.h" nogil:
+    cdef size_t ARENA_ALIGNMENT
+
+    ctypedef struct arena_t:
+        size_t capacity
+        size_t offset
+
+    cdef arena_t* arena_init(size_t capacity) nogil
+    cdef void* arena_alloc(arena_t* a, size_t size) nogil
+    cdef void arena_reset(arena_t* a) nogil
+    cdef void arena_destroy(arena_t* a) nogil
+cdef extern from "include/neighbors.h" nogil:
+    ctypedef struct neighbor_list_t:
+        size_t atoms
+        double cutoff
+        size_t pairs
+        size_t *offsets
+        size_t *indices
+        double *distances
+        double *vectors
+
+    ctypedef struct neighbor_workspace_t:
+        size_t atoms
+
+    ctypedef struct neighbor_table_t:
+        size_t atoms
+        size_t entries
+
+    cdef neighbor_table_t* neighbor_table_init(double *lattice, double *frac_coords, size_t atoms, double cutoff) nogil
+    cdef void neighbor_table_destroy(neighbor_table_t* t) nogil
+
+    cdef neighbor_list_t* neighbor_list_init(double *lattice, double *frac_coords, size_t atoms, double cutoff) nogil
+    cdef neighbor_list_t* neighbor_list_supercell(neighbor_table_t* table, size_t *multiples) nogil
+    cdef size_t neighbor_list_cells(neighbor_list_t* nl) nogil
+    cdef void neighbor_list_count(neighbor_list_t* nl, size_t cell, neighbor_workspace_t* w) nogil
+    cdef bint neighbor_list_allocate(neighbor_list_t* nl) nogil
+    cdef void neighbor_list_fill(neighbor_list_t* nl, size_t cell, neighbor_workspace_t* w) nogil
+    cdef neighbor_list_t* neighbor_list_reorder(neighbor_list_t* nl, size_t *order, size_t *rank) nogil
+    cdef void neighbor_list_destroy(neighbor_list_t* nl) nogil
+    cdef neighbor_workspace_t* neighbor_workspace_init(size_t atoms) nogil
+    cdef void neighbor_workspace_destroy(neighbor_workspace_t* w) nogil
+
+cdef extern from "include/morton.h" nogil:
+    cdef uint64_t morton_key(double *frac) nogil
+    cdef void morton_order(double *frac_coords, size_t atoms, size_t *order) nogil
+
+cdef extern from "include/shells.h" nogil:
+    ctypedef struct shell_table_t:
+        size_t count
+        double rel_tol
+        double *radii
+
+    cdef shell_table_t* shell_table_init(neighbor_list_t* nl, size_t *rows, size_t nrows, double rel_tol) nogil
+    cdef void shell_table_truncate(shell_table_t* st, size_t count) nogil
+    cdef uint8_t shell_table_find(shell_table_t* st, double distance) nogil
+    cdef void shell_table_classify(shell_table_t* st, neighbor_list_t* nl, size_t i, uint8_t *row, size_t *counts) nogil
+    cdef void shell_table_classify_pairs(shell_table_t* st, neighbor_list_t* nl, size_t i, uint8_t *shells, size_t *counts) nogil
+    cdef void shell_table_destroy(shell_table_t* st) nogil
+
+cdef extern from "include/reader.h" nogil:
+    ctypedef struct reader_structure_t:
+        size_t atoms
+        size_t species
+        double lattice[9]
+        double *frac_coords
+        uint8_t *site_species
+        char symbols[255][8]
+
+    cdef reader_structure_t* reader_read_poscar(const char *path) nogil
+    cdef reader_structure_t* reader_read_xyz(const char *path) nogil
+    cdef void reader_expand(double *frac_coords, size_t atoms, size_t *multiples, double *result) nogil
+    cdef void reader_structure_destroy(reader_structure_t* s) nogil
@@ -1,8 +1,8 @@
-from .utils import write_message, full_name, ERROR, WARNING, parse_separated_string, parse_float, all_subclasses
-from pymatgen.core.periodic_table import Element
+from .utils import write_message, full_name, ERROR, WARNING, parse_separated_string, parse_float, all_subclasses, \
+    is_valid_symbol, symbol_from_z
+from os import makedirs
 from os.path import exists, isfile, basename
 from math import isclose
-from pymatgen import Structure
 
 
 def parse_options(docopt_options):
@@ -102,8 +102,8 @@ class CompositionalArgument(ArgumentBase):
                     if ':' not in species_comp:
                         if species_comp == '0':
                             _species = species_comp
-                        elif not Element.is_valid_symbol(species_comp):
-                            _species = Element.from_Z(dummy_z).symbol
+                        elif not is_valid_symbol(species_comp):
+                            _species = symbol_from_z(dummy_z)
                             dummy_species.append(_species)
                             dummy_z += 1
                             mole_fraction = species_comp
@@ -177,8 +177,9 @@ class LatticeOption(CompositionalArgument):
         super(LatticeOption, self).__init__(options, 'lattice', option=True)
 
     def parse(self, options, *args, **kwargs):
+        from sqsgenerator.core.reader import site_symbols
         structure = StructureFileArgument(options)()
-        species = list(set([element.symbol for element in structure.species]))
+        species = list(set(site_symbols(structure)))
         sublattice_composition = {}
         sublattice_mapping = self.raw_value
         for mapping in sublattice_mapping:
@@ -194,17 +195,17 @@ class LatticeOption(CompositionalArgument):
                 try:
                     _species, mole_fraction = sublattice_composition_string.split(':')
                 except ValueError:
-                    if Element.is_valid_symbol(
+                    if is_valid_symbol(
                             sublattice_composition_string) or sublattice_composition_string.startswith(
                         '0'):
                         _species = sublattice_composition_string
                     else:
-                        _species = Element.from_Z(dummy_z).symbol
+                        _species = symbol_from_z(dummy_z)
                         dummy_z += 1
                 sublattice_species.append(_species)
 
             for _species in sublattice_species:
-                if not Element.is_valid_symbol(_species) and not _species == '0':
+                if not is_valid_symbol(_species) and not _species == '0':
                     self.write_message(
                         'Element "{0}" is not a valid symbol in the periodic table. To get a list of all symbols you may have a look at pymatgen.core.periodic_table'.format(
                             _species))
@@ -227,7 +228,8 @@ class LatticeOption(CompositionalArgument):
         return sublattice_composition
 
     def get_atom_number_on_sublattice(self, species, structure):
-        return len(list(filter(lambda site: site.specie.symbol == species, structure.sites)))
+        from sqsgenerator.core.reader import site_symbols
+        return site_symbols(structure).count(species)
 
 
 class WeightsOption(ArgumentBase):
@@ -300,6 +302,105 @@ class ParallelOption(ArgumentBase):
         super(ParallelOption, self).__init__(options, key='parallel', option=True)
 
 
+class DegeneracyOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(DegeneracyOption, self).__init__(options, key='degeneracy', option=True)
+
+    def parse(self, options, *args, **kwargs):
+        if self.raw_value and str(options['--iterations']).lower() != 'all':
+            self.write_message('The degeneracy can only be counted if all configurations are checked ("-I all")')
+            raise InvalidOption
+        return self.raw_value
+
+
+class RankedOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(RankedOption, self).__init__(options, key='ranked', option=True)
+
+    def parse(self, options, *args, **kwargs):
+        if self.raw_value and str(options['--output']).lower() == 'all':
+            self.write_message('Only a finite number of structures can be ranked ("-O all" is not allowed)')
+            raise InvalidOption
+        if self.raw_value and options['--degeneracy']:
+            self.write_message('The degeneracy cannot be counted if the structures are ranked')
+            raise InvalidOption
+        return self.raw_value
+
+
+class MemoryOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(MemoryOption, self).__init__(options, key='memory', option=True)
+
+    def parse(self, options, *args, **kwargs):
+        try:
+            memory = int(parse_float(self.raw_value, raise_exc=True) * 1024 ** 2)
+        except ValueError:
+            self.write_message('Could not parse the memory budget')
+            raise InvalidOption
+        if memory <= 0:
+            self.write_message('The memory budget must be positive')
+            raise InvalidOption
+        return memory
+
+
+class SeedOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(SeedOption, self).__init__(options, key='seed', option=True)
+
+    def parse(self, options, *args, **kwargs):
+        try:
+            seed = int(self.raw_value)
+        except ValueError:
+            self.write_message('The seed must be an integer')
+            raise InvalidOption
+        if seed < 0:
+            self.write_message('The seed must not be negative')
+            raise InvalidOption
+        return seed
+
+
+class ReorderOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(ReorderOption, self).__init__(options, key='reorder', option=True)
+
+
+class LowMemoryOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(LowMemoryOption, self).__init__(options, key='low-memory', option=True)
+
+
+class PlanOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(PlanOption, self).__init__(options, key='plan', option=True)
+
+
+class TimingOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(TimingOption, self).__init__(options, key='timing', option=True)
+
+
+class CacheOption(ArgumentBase):
+
+    def __init__(self, options):
+        super(CacheOption, self).__init__(options, key='cache', option=True)
+
+    def parse(self, options, *args, **kwargs):
+        try:
+            makedirs(self.raw_value, exist_ok=True)
+        except OSError:
+            self.write_message('Could not create the cache directory "{0}"'.format(self.raw_value))
+            raise InvalidOption
+        return self.raw_value
+
+
 class VerbosityOption(ArgumentBase):
 
     def __init__(self, options):
@@ -389,27 +490,30 @@ class VersionOption(ArgumentBase):
 
 class FormatOption(ArgumentBase):
 
+    # Only the writer of the chosen format is imported, each pymatgen io module adds to the startup time
+    _writers = {
+        'vasp': ('pymatgen.io.vasp', 'Poscar'),
+        'lammps': ('pymatgen.io.lammps.inputs', 'LammpsData'),
+        'cssr': ('pymatgen.io.cssr', 'Cssr'),
+        'cif': ('pymatgen.io.cif', 'CifWriter')
+    }
+
     def __init__(self, options):
         super(FormatOption, self).__init__(options, key='format', option=True)
-        from pymatgen.io.vasp import Poscar
-        from pymatgen.io.cif import CifWriter
-        from pymatgen.io.cssr import Cssr
-        from pymatgen.io.lammps.inputs import LammpsData
-
-        def _lammps_wrapper(structure):
-            return LammpsData.from_structure(structure, atom_style='atomic')
-
-        self._class_mapping = {
-            'vasp': Poscar,
-            'lammps': _lammps_wrapper,
-            'cssr': Cssr,
-            'cif': CifWriter
-        }
 
     def parse(self, options, *args, **kwargs):
-        if self.raw_value not in self._class_mapping:
-            raise InvalidOption('Output format must be in {}'.format(self._options))
-        return self.raw_value, self._class_mapping[self.raw_value]
+        if self.raw_value not in self._writers:
+            self.write_message('Output format must be in {}'.format(list(self._writers.keys())))
+            raise InvalidOption
+        from importlib import import_module
+        module, name = self._writers[self.raw_value]
+        writer = getattr(import_module(module), name)
+        if self.raw_value == 'lammps':
+            lammps_data = writer
+
+            def writer(structure):
+                return lammps_data.from_structure(structure, atom_style='atomic')
+        return self.raw_value, writer
 
 class StructureFileArgument(ArgumentBase):
 
@@ -420,8 +524,16 @@ class StructureFileArgument(ArgumentBase):
         path = self.raw_value
         if exists(path):
             if isfile(path):
+                from sqsgenerator.core.reader import read_structure, XYZ_EXTENSIONS
+                # POSCAR and extended XYZ files are streamed into flat arrays, pymatgen reads everything else
+                result = read_structure(path)
+                if result is not None:
+                    return result
                 filename = basename(path)
-                if filename.lower().endswith('.cif'):
+                if filename.lower().endswith(XYZ_EXTENSIONS):
+                    self.write_message('Could not parse extended XYZ file: "{0}"'.format(path))
+                    raise InvalidOption
+                elif filename.lower().endswith('.cif'):
                     from pymatgen.io.cif import CifParser
                     try:
                         result = CifParser(path).get_structures()[0]
@@ -464,10 +576,11 @@ class CompositionArgument(CompositionalArgument):
         super(CompositionArgument, self).__init__(options, key='composition')
 
     def parse(self, options, *args, **kwargs):
+        from sqsgenerator.core.reader import site_symbols
         structure = StructureFileArgument(options)()
-        species = list(set([element.symbol for element in structure.species]))
+        species = list(set(site_symbols(structure)))
         # Parse the given composition
-        mole_fractions = self.parse_composition(self.raw_value, species, len(structure.sites))
+        mole_fractions = self.parse_composition(self.raw_value, species, len(structure))
         vacancy_parser = VacancyOption(options)
         if vacancy_parser.format_key() in options and options[vacancy_parser.format_key()]:
             mole_fraction_vacancy = vacancy_parser()
@@ -542,8 +655,10 @@ class SublatticeOption(ArgumentBase):
         super(SublatticeOption, self).__init__(options, key='sublattice', option=True)
 
     def parse(self, options, *args, **kwargs):
-        from pymatgen.core.periodic_table import Element
-        calculation_structure = StructureFileArgument(options)()
+        from pymatgen import Structure
+        from sqsgenerator.core.reader import as_structure
+        # The site matching below needs pymatgen sites
+        calculation_structure = as_structure(StructureFileArgument(options)())
         if not self.raw_value:
             return [calculation_structure]
 
@@ -567,14 +682,12 @@ class SublatticeOption(ArgumentBase):
             species_list = [s for s in species.split(':') if s != '']
             # Check if given elements are valid chmical symbols
             for specie in species_list:
-                try:
-                    Element(specie)
-                except ValueError:
+                if not is_valid_symbol(specie):
                     write_message('"{0}" is not a valid specifier for a chemical element.'.format(species))
                     raise InvalidOption
 
             # Load structure to compare
-            selection_structure = StructureFileArgument({'<structure>': structure_file_name})()
+            selection_structure = as_structure(StructureFileArgument({'<structure>': structure_file_name})())
             selection_species = list(set([s.specie.symbol for s in selection_structure.sites]))
 
             # Check if species are present
@@ -1,6 +1,9 @@
 import sys
 import unicodedata
 import logging
+from time import perf_counter
+from contextlib import contextmanager
+from collections import OrderedDict
 from .termcolor import colored
 
 try:
@@ -80,4 +83,55 @@ def full_name(thing):
 
 
 def all_subclasses(cls):
-    return cls.__subclasses__() + [g for s in cls.__subclasses__() for g in all_subclasses(s)]
\ No newline at end of file
+    return cls.__subclasses__() + [g for s in cls.__subclasses__() for g in all_subclasses(s)]
+
+
+# Symbols by atomic number, checking a composition must not import pymatgen
+ELEMENT_SYMBOLS = (
+    'H', 'He', 'Li', 'Be', 'B', 'C', 'N', 'O', 'F', 'Ne', 'Na', 'Mg', 'Al', 'Si', 'P', 'S', 'Cl', 'Ar', 'K', 'Ca', 'Sc',
+    'Ti', 'V', 'Cr', 'Mn', 'Fe', 'Co', 'Ni', 'Cu', 'Zn', 'Ga', 'Ge', 'As', 'Se', 'Br', 'Kr', 'Rb', 'Sr', 'Y', 'Zr', 'Nb',
+    'Mo', 'Tc', 'Ru', 'Rh', 'Pd', 'Ag', 'Cd', 'In', 'Sn', 'Sb', 'Te', 'I', 'Xe', 'Cs', 'Ba', 'La', 'Ce', 'Pr', 'Nd',
+    'Pm', 'Sm', 'Eu', 'Gd', 'Tb', 'Dy', 'Ho', 'Er', 'Tm', 'Yb', 'Lu', 'Hf', 'Ta', 'W', 'Re', 'Os', 'Ir', 'Pt', 'Au',
+    'Hg', 'Tl', 'Pb', 'Bi', 'Po', 'At', 'Rn', 'Fr', 'Ra', 'Ac', 'Th', 'Pa', 'U', 'Np', 'Pu', 'Am', 'Cm', 'Bk', 'Cf',
+    'Es', 'Fm', 'Md', 'No', 'Lr', 'Rf', 'Db', 'Sg', 'Bh', 'Hs', 'Mt', 'Ds', 'Rg', 'Cn', 'Nh', 'Fl', 'Mc', 'Lv', 'Ts',
+    'Og'
+)
+
+
+def is_valid_symbol(symbol):
+    return symbol in ELEMENT_SYMBOLS
+
+
+def symbol_from_z(z):
+    return ELEMENT_SYMBOLS[z - 1]
+
+
+class Timing(object):
+    """
+    Wall time of the phases of a run, printed with the --timing switch. Repeated phases, e.g. the setup of every
+    sublattice, are summed up
+    """
+
+    def __init__(self):
+        self.phases = OrderedDict()
+
+    def record(self, name, seconds):
+        self.phases[name] = self.phases.get(name, 0.0) + seconds
+
+    @contextmanager
+    def phase(self, name):
+        start = perf_counter()
+        try:
+            yield
+        finally:
+            self.record(name, perf_counter() - start)
+
+    def report(self):
+        total = sum(self.phases.values())
+        width = max([len(name) for name in self.phases] + [len('total')])
+        lines = ['{0:<{1}}  {2:9.4f} s'.format(name, width, seconds) for name, seconds in self.phases.items()]
+        lines.append('{0:<{1}}  {2:9.4f} s'.format('total', width, total))
+        return '\n'.join(lines)
+
+
+TIMING = Timing()
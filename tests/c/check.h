@@ -0,0 +1,18 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+/* Minimal assertions for the tests of the C modules, a failed check is reported and the program exits with 1 */
+static int __check_failures = 0;
+
+#define CHECK(condition) do { \
+    if (!(condition)) { \
+        fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+        __check_failures++; \
+    } \
+} while (0)
+
+#define CHECK_RESULT() (__check_failures ? 1 : 0)
+
+#endif
@@ -0,0 +1,58 @@
+#include <string.h>
+#include "check.h"
+#include "conf_counter.h"
+
+#define ATOMS 4
+#define SAMPLES 3
+#define DECOMP 1
+
+static void add(conf_counter_t* c, double objective, uint8_t first) {
+    uint8_t conf[ATOMS] = {first, 0, 1, 1};
+    double decomp[DECOMP] = {(double) first};
+    conf_counter_add(c, objective, conf, decomp);
+}
+
+/* The samples are the smallest configurations attaining the best objective, first holds their first sites */
+static void check_snapshot(conf_snapshot_t* s, double objective, size_t size, const uint8_t* first) {
+    CHECK(s && s->size == size && s->best_objective == objective);
+    for (size_t i = 0; s && i < s->size; i++) {
+        CHECK(conf_snapshot_get_objective(s, i) == objective);
+        CHECK(conf_snapshot_get_conf(s, i)[0] == first[i]);
+        CHECK(conf_snapshot_get_decomp(s, i)[0] == (double) first[i]);
+    }
+    conf_snapshot_release(s);
+}
+
+int main(void) {
+    const uint8_t expected[SAMPLES] = {1, 2, 4};
+    conf_counter_t *a = conf_counter_init(SAMPLES, ATOMS, DECOMP), *b = conf_counter_init(SAMPLES, ATOMS, DECOMP);
+    conf_counter_t* threads[2] = {a, b};
+    conf_snapshot_t *first, *second;
+    char* count;
+
+    add(a, 2.0, 9);
+    add(a, 1.0, 7);
+    add(a, 1.0, 2);
+    add(b, 1.0, 4);
+    add(b, 1.0, 1);
+    add(b, 1.0, 8);
+
+    /* A snapshot is shared until the counter changes */
+    first = conf_counter_snapshot(a);
+    second = conf_counter_snapshot(a);
+    CHECK(first == second);
+    conf_snapshot_release(second);
+    check_snapshot(first, 1.0, 2, (const uint8_t[]) {2, 7});
+
+    /* The counters of the threads are combined like a merge does */
+    check_snapshot(conf_counters_snapshot(threads, 2), 1.0, SAMPLES, expected);
+    conf_counter_merge(a, b);
+    check_snapshot(conf_counter_snapshot(a), 1.0, SAMPLES, expected);
+    count = conf_counter_get_count_str(a);
+    CHECK(strcmp(count, "5") == 0);
+    free(count);
+
+    conf_counter_destroy(a);
+    conf_counter_destroy(b);
+    return CHECK_RESULT();
+}
@@ -0,0 +1,98 @@
+#include <string.h>
+#include "check.h"
+#include "conf_hash.h"
+#include "philox.h"
+#include "utils.h"
+
+#define ATOMS 16
+#define ENTRIES 1000
+
+static uint8_t records[ENTRIES][ATOMS];
+
+static uint8_t* get_record(void* owner, size_t index) {
+    return ((uint8_t (*)[ATOMS]) owner)[index];
+}
+
+/* Entries with the same home slot form one probe chain, removing one in the middle must not cut off the others */
+static void check_probe_chain(void) {
+    conf_hash_set_t* s = conf_hash_set_init(ATOMS, ATOMS, records, get_record);
+    uint128_t hashes[] = {3, 67, 131, 4, 195};
+
+    for (size_t i = 0; i < 5; i++) {
+        memset(records[i], (int) i, ATOMS);
+        CHECK(conf_hash_set_insert(s, hashes[i], i));
+    }
+    CHECK(conf_hash_set_remove(s, hashes[1], 1));
+    CHECK(!conf_hash_set_remove(s, hashes[1], 1));
+    CHECK(!conf_hash_set_contains(s, hashes[1], records[1]));
+    for (size_t i = 0; i < 5; i++) {
+        if (i != 1) {
+            CHECK(conf_hash_set_contains(s, hashes[i], records[i]));
+        }
+    }
+    CHECK(conf_hash_set_insert(s, hashes[1], 1));
+    for (size_t i = 0; i < 5; i++) {
+        CHECK(conf_hash_set_contains(s, hashes[i], records[i]));
+    }
+    CHECK(s->size == 5);
+    conf_hash_set_destroy(s);
+}
+
+/* Zobrist hashes of shuffled configurations, every other one is deleted and put back while the table grows */
+static void check_delete_reinsert(void) {
+    conf_hash_set_t* s = conf_hash_set_init(ATOMS, ATOMS, records, get_record);
+    uint128_t hashes[ENTRIES];
+    uint8_t other[ATOMS];
+    philox_t rng;
+    size_t i;
+
+    philox_init(&rng, 7, 0);
+    for (i = 0; i < ATOMS; i++) {
+        other[i] = (uint8_t) (i % 3);
+    }
+    for (i = 0; i < ENTRIES; i++) {
+        /* A configuration drawn twice is found under the same hash and drawn again */
+        do {
+            knuth_fisher_yates_shuffle(&rng, other, ATOMS);
+            memcpy(records[i], other, ATOMS);
+            hashes[i] = conf_hash_compute(s, records[i]);
+        } while (conf_hash_set_contains(s, hashes[i], records[i]));
+        CHECK(conf_hash_set_insert(s, hashes[i], i));
+    }
+    CHECK(s->size == ENTRIES);
+    for (i = 0; i < ENTRIES; i += 2) {
+        CHECK(conf_hash_set_remove(s, hashes[i], i));
+    }
+    CHECK(s->size == ENTRIES / 2);
+    for (i = 0; i < ENTRIES; i++) {
+        CHECK(conf_hash_set_contains(s, hashes[i], records[i]) == (i % 2 == 1));
+    }
+    for (i = 0; i < ENTRIES; i += 2) {
+        CHECK(conf_hash_set_insert(s, hashes[i], i));
+    }
+    for (i = 0; i < ENTRIES; i++) {
+        CHECK(conf_hash_set_contains(s, hashes[i], records[i]));
+    }
+
+    /* Swapping two different species changes the hash, the same configuration always hashes the same */
+    memcpy(other, records[0], ATOMS);
+    for (i = 1; other[i] == other[0]; i++);
+    other[0] ^= other[i];
+    other[i] ^= other[0];
+    other[0] ^= other[i];
+    CHECK(conf_hash_compute(s, other) != hashes[0]);
+    CHECK(conf_hash_compute(s, records[0]) == hashes[0]);
+
+    conf_hash_set_clear(s);
+    CHECK(s->size == 0);
+    for (i = 0; i < ENTRIES; i++) {
+        CHECK(!conf_hash_set_contains(s, hashes[i], records[i]));
+    }
+    conf_hash_set_destroy(s);
+}
+
+int main(void) {
+    check_probe_chain();
+    check_delete_reinsert();
+    return CHECK_RESULT();
+}
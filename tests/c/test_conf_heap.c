@@ -0,0 +1,119 @@
+#include <string.h>
+#include "check.h"
+#include "conf_heap.h"
+#include "rank.h"
+
+#define ATOMS 8
+#define ENTRIES 500
+#define KEEP 20
+#define DECOMP 2
+
+typedef struct {
+    double objective;
+    uint8_t conf[ATOMS];
+} entry_t;
+
+static entry_t entries[ENTRIES];
+
+static int compare_entries(const void* a, const void* b) {
+    const entry_t* x = a;
+    const entry_t* y = b;
+    if (x->objective != y->objective) {
+        return x->objective < y->objective ? -1 : 1;
+    }
+    return memcmp(x->conf, y->conf, ATOMS);
+}
+
+/*
+ * Distinct configurations of one composition like those of an iteration, many of them share an objective so the ties
+ * are broken by the configuration
+ */
+static void make_entries(void) {
+    uint8_t conf[ATOMS] = {0, 0, 1, 1, 2, 2, 3, 3};
+    for (size_t i = 0; i < ENTRIES; i++) {
+        memcpy(entries[i].conf, conf, ATOMS);
+        entries[i].objective = (double) ((i * 31) % 37);
+        for (size_t k = 0; k < 5; k++) {
+            next_permutation_lex(conf, ATOMS);
+        }
+    }
+}
+
+static void add_entry(conf_heap_t* h, size_t i) {
+    double decomp[DECOMP] = {entries[i].objective, (double) i};
+    conf_heap_add(h, entries[i].objective, entries[i].conf, decomp);
+}
+
+/* The heap holds the KEEP smallest entries in ascending order, each with its own decomposition */
+static void check_top(conf_heap_t* h, entry_t* expected) {
+    CHECK(h->size == KEEP);
+    for (size_t i = 0; i < KEEP; i++) {
+        CHECK(conf_heap_get_objective(h, i) == expected[i].objective);
+        CHECK(memcmp(conf_heap_get_conf(h, i), expected[i].conf, ATOMS) == 0);
+        CHECK(conf_heap_get_decomp(h, i)[0] == expected[i].objective);
+    }
+    CHECK(conf_heap_get_conf(h, KEEP) == NULL);
+}
+
+static void check_snapshot(conf_snapshot_t* s, entry_t* expected) {
+    CHECK(s && s->size == KEEP && s->best_objective == expected[0].objective);
+    for (size_t i = 0; s && i < KEEP; i++) {
+        CHECK(conf_snapshot_get_objective(s, i) == expected[i].objective);
+        CHECK(memcmp(conf_snapshot_get_conf(s, i), expected[i].conf, ATOMS) == 0);
+        CHECK(conf_snapshot_get_decomp(s, i)[0] == expected[i].objective);
+    }
+    conf_snapshot_release(s);
+}
+
+int main(void) {
+    entry_t sorted[ENTRIES];
+    conf_heap_t *forward, *backward, *merged, *part;
+    conf_heap_t* threads[2];
+    conf_snapshot_t *first, *second;
+    size_t i;
+
+    make_entries();
+    memcpy(sorted, entries, sizeof(entries));
+    qsort(sorted, ENTRIES, sizeof(entry_t), compare_entries);
+    for (i = 1; i < ENTRIES; i++) {
+        CHECK(compare_entries(&sorted[i - 1], &sorted[i]) < 0);
+    }
+
+    /* The kept set does not depend on the order of insertion, a configuration is only kept once */
+    forward = conf_heap_init(KEEP, ATOMS, DECOMP);
+    backward = conf_heap_init(KEEP, ATOMS, DECOMP);
+    for (i = 0; i < ENTRIES; i++) {
+        add_entry(forward, i);
+        add_entry(forward, i);
+        add_entry(backward, ENTRIES - 1 - i);
+    }
+    CHECK(forward->threshold == sorted[KEEP - 1].objective);
+
+    /* A snapshot is sorted without touching the heap, it is shared until the heap changes */
+    first = conf_heap_snapshot(forward);
+    second = conf_heap_snapshot(forward);
+    CHECK(first == second && !forward->sorted);
+    conf_snapshot_release(second);
+    check_snapshot(first, sorted);
+    check_top(forward, sorted);
+    check_snapshot(conf_heap_snapshot(forward), sorted);
+    check_top(backward, sorted);
+
+    /* Heaps filled by different threads merge into the same result */
+    merged = conf_heap_init(KEEP, ATOMS, DECOMP);
+    part = conf_heap_init(KEEP, ATOMS, DECOMP);
+    for (i = 0; i < ENTRIES; i++) {
+        add_entry(i % 3 ? merged : part, i);
+    }
+    threads[0] = merged;
+    threads[1] = part;
+    check_snapshot(conf_heaps_snapshot(threads, 2), sorted);
+    conf_heap_merge(merged, part);
+    check_top(merged, sorted);
+
+    conf_heap_destroy(forward);
+    conf_heap_destroy(backward);
+    conf_heap_destroy(merged);
+    conf_heap_destroy(part);
+    return CHECK_RESULT();
+}
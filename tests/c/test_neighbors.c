@@ -0,0 +1,159 @@
+#include <math.h>
+#include <string.h>
+#include "check.h"
+#include "neighbors.h"
+#include "philox.h"
+
+#define TOLERANCE 1e-9
+
+/* Both passes over all cells on a single thread, as the geometry does it with one workspace per thread */
+static neighbor_list_t* fill(neighbor_list_t* nl) {
+    neighbor_workspace_t* w = neighbor_workspace_init(nl->atoms);
+    size_t cells = neighbor_list_cells(nl);
+    bool allocated;
+
+    for (size_t c = 0; c < cells; c++) {
+        neighbor_list_count(nl, c, w);
+    }
+    allocated = neighbor_list_allocate(nl);
+    CHECK(allocated);
+    for (size_t c = 0; allocated && c < cells; c++) {
+        neighbor_list_fill(nl, c, w);
+    }
+    neighbor_workspace_destroy(w);
+    return nl;
+}
+
+/* Shortest distance of every pair over all translations up to reach in each direction, -1 for the site itself */
+static double brute_force(double* lattice, double* frac_coords, size_t i, size_t j, int reach) {
+    double best = -1.0, diff[3], v[3], d;
+    if (i == j) {
+        return best;
+    }
+    for (int a = -reach; a <= reach; a++) {
+        for (int b = -reach; b <= reach; b++) {
+            for (int c = -reach; c <= reach; c++) {
+                diff[0] = frac_coords[3 * j] - frac_coords[3 * i] + a;
+                diff[1] = frac_coords[3 * j + 1] - frac_coords[3 * i + 1] + b;
+                diff[2] = frac_coords[3 * j + 2] - frac_coords[3 * i + 2] + c;
+                for (size_t k = 0; k < 3; k++) {
+                    v[k] = diff[0] * lattice[k] + diff[1] * lattice[3 + k] + diff[2] * lattice[6 + k];
+                }
+                d = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+                if (best < 0.0 || d < best) {
+                    best = d;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+/* Fractional coordinates of a vector, the rows of the lattice are inverted by Cramer's rule */
+static void to_fractional(double* lattice, double* v, double* f) {
+    double* a = lattice;
+    double* b = &lattice[3];
+    double* c = &lattice[6];
+    double bc[3] = {b[1] * c[2] - b[2] * c[1], b[2] * c[0] - b[0] * c[2], b[0] * c[1] - b[1] * c[0]};
+    double ca[3] = {c[1] * a[2] - c[2] * a[1], c[2] * a[0] - c[0] * a[2], c[0] * a[1] - c[1] * a[0]};
+    double ab[3] = {a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]};
+    double volume = a[0] * bc[0] + a[1] * bc[1] + a[2] * bc[2];
+    f[0] = (v[0] * bc[0] + v[1] * bc[1] + v[2] * bc[2]) / volume;
+    f[1] = (v[0] * ca[0] + v[1] * ca[1] + v[2] * ca[2]) / volume;
+    f[2] = (v[0] * ab[0] + v[1] * ab[1] + v[2] * ab[2]) / volume;
+}
+
+/*
+ * Every row holds exactly the sites whose shortest image lies within the cutoff, sorted by index. The distance is the
+ * one of the shortest image and the vector points to an image of the second site
+ */
+static void check_against_brute_force(neighbor_list_t* nl, double* lattice, double* frac_coords, int reach) {
+    double d, f[3], shift;
+    size_t p, expected = 0;
+
+    for (size_t i = 0; i < nl->atoms; i++) {
+        p = nl->offsets[i];
+        for (size_t j = 0; j < nl->atoms; j++) {
+            d = brute_force(lattice, frac_coords, i, j, reach);
+            if (d < 0.0 || d > nl->cutoff * (1.0 + TOLERANCE)) {
+                continue;
+            }
+            expected++;
+            CHECK(p < nl->offsets[i + 1] && nl->indices[p] == j);
+            if (p >= nl->offsets[i + 1] || nl->indices[p] != j) {
+                return;
+            }
+            CHECK(fabs(nl->distances[p] - d) < TOLERANCE * (1.0 + d));
+            CHECK(fabs(sqrt(nl->vectors[3 * p] * nl->vectors[3 * p] + nl->vectors[3 * p + 1] * nl->vectors[3 * p + 1]
+                            + nl->vectors[3 * p + 2] * nl->vectors[3 * p + 2]) - d) < TOLERANCE * (1.0 + d));
+            to_fractional(lattice, &(nl->vectors[3 * p]), f);
+            for (size_t k = 0; k < 3; k++) {
+                shift = f[k] - (frac_coords[3 * j + k] - frac_coords[3 * i + k]);
+                CHECK(fabs(shift - round(shift)) < 1e-6);
+            }
+            p++;
+        }
+        CHECK(p == nl->offsets[i + 1]);
+    }
+    CHECK(expected == nl->pairs);
+}
+
+/* Random sites in a skewed cell, with a short cutoff (many bins) and one beyond the width of the cell (reach > 1) */
+static void check_cell_list(double cutoff, int reach) {
+    double lattice[9] = {7.0, 0.0, 0.0, 1.5, 6.0, 0.0, -1.0, 0.8, 8.0};
+    double frac_coords[3 * 60];
+    philox_t rng;
+    neighbor_list_t* nl;
+
+    philox_init(&rng, 11, 0);
+    for (size_t i = 0; i < 3 * 60; i++) {
+        frac_coords[i] = philox_next(&rng) / 4294967296.0;
+    }
+    nl = fill(neighbor_list_init(lattice, frac_coords, 60, cutoff));
+    check_against_brute_force(nl, lattice, frac_coords, reach);
+    neighbor_list_destroy(nl);
+}
+
+/* A supercell mapped from the table of its unit cell, site s of translation (a, b, c) is s * cells + (a*m1+b)*m2+c */
+static void check_supercell(size_t* multiples, double cutoff, int reach) {
+    double unit[9] = {3.6, 0.0, 0.0, 0.0, 3.6, 0.0, 0.3, 0.0, 3.5};
+    double unit_frac[12] = {0.0, 0.0, 0.0, 0.0, 0.5, 0.5, 0.5, 0.0, 0.5, 0.5, 0.5, 0.0};
+    size_t cells = multiples[0] * multiples[1] * multiples[2], atoms = 4 * cells, i;
+    double lattice[9], frac_coords[3 * atoms];
+    neighbor_list_t* nl;
+
+    for (size_t k = 0; k < 9; k++) {
+        lattice[k] = unit[k] * multiples[k / 3];
+    }
+    for (size_t s = 0; s < 4; s++) {
+        for (size_t a = 0; a < multiples[0]; a++) {
+            for (size_t b = 0; b < multiples[1]; b++) {
+                for (size_t c = 0; c < multiples[2]; c++) {
+                    i = s * cells + (a * multiples[1] + b) * multiples[2] + c;
+                    frac_coords[3 * i] = (unit_frac[3 * s] + a) / multiples[0];
+                    frac_coords[3 * i + 1] = (unit_frac[3 * s + 1] + b) / multiples[1];
+                    frac_coords[3 * i + 2] = (unit_frac[3 * s + 2] + c) / multiples[2];
+                }
+            }
+        }
+    }
+    nl = fill(neighbor_list_supercell(neighbor_table_init(unit, unit_frac, 4, cutoff), multiples));
+    check_against_brute_force(nl, lattice, frac_coords, reach);
+    neighbor_list_destroy(nl);
+
+    /* The cell list of the same supercell finds the same pairs */
+    nl = fill(neighbor_list_init(lattice, frac_coords, atoms, cutoff));
+    check_against_brute_force(nl, lattice, frac_coords, reach);
+    neighbor_list_destroy(nl);
+}
+
+int main(void) {
+    size_t large[3] = {3, 2, 4}, small[3] = {1, 2, 1};
+
+    check_cell_list(2.5, 2);
+    check_cell_list(9.0, 3);
+    check_supercell(large, 4.2, 2);
+    /* A supercell smaller than the cutoff maps several images onto one pair */
+    check_supercell(small, 5.5, 4);
+    return CHECK_RESULT();
+}
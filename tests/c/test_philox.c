@@ -0,0 +1,72 @@
+#include <string.h>
+#include "check.h"
+#include "philox.h"
+
+/* Known answers of Philox4x32-10 from the Random123 distribution: counter, key and the encrypted block */
+static const uint32_t vectors[3][10] = {
+    {0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+     0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+    {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff,
+     0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+    {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344, 0xa4093822, 0x299f31d0,
+     0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1},
+};
+
+static void check_known_answers(void) {
+    philox_t p;
+    for (size_t v = 0; v < 3; v++) {
+        memcpy(p.counter, vectors[v], sizeof(p.counter));
+        memcpy(p.key, &vectors[v][4], sizeof(p.key));
+        philox_refill(&p);
+        for (size_t i = 0; i < 4; i++) {
+            CHECK(p.output[i] == vectors[v][6 + i]);
+        }
+    }
+}
+
+/* The seed is the key and the stream the upper half of the counter */
+static void check_seed(void) {
+    philox_t a, b;
+    uint32_t first[64];
+    size_t i, equal = 0;
+
+    philox_init(&a, 0x299f31d0a4093822ULL, 0);
+    CHECK(a.key[0] == 0xa4093822 && a.key[1] == 0x299f31d0);
+    philox_init(&a, 1234, 5);
+    CHECK(a.counter[0] == 0 && a.counter[1] == 0 && a.counter[2] == 5 && a.counter[3] == 0);
+
+    /* The same seed and stream draw the same numbers */
+    philox_init(&a, 1234, 5);
+    philox_init(&b, 1234, 5);
+    for (i = 0; i < 64; i++) {
+        first[i] = philox_next(&a);
+        CHECK(first[i] == philox_next(&b));
+    }
+
+    /* Jumping over blocks lands where drawing them does */
+    philox_init(&b, 1234, 5);
+    philox_jump(&b, 8, 0);
+    for (i = 32; i < 64; i++) {
+        CHECK(philox_next(&b) == first[i]);
+    }
+
+    /* Another stream or another seed gives other numbers */
+    philox_init(&a, 1234, 6);
+    philox_init(&b, 1235, 5);
+    for (i = 0; i < 64; i++) {
+        uint32_t x = philox_next(&a), y = philox_next(&b);
+        equal += (x == first[i]) + (y == first[i]);
+    }
+    CHECK(equal < 2);
+
+    /* The bounded draws stay in range */
+    for (i = 0; i < 1000; i++) {
+        CHECK(philox_bounded(&a, 7) < 7);
+    }
+}
+
+int main(void) {
+    check_known_answers();
+    check_seed();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,128 @@
+#include <string.h>
+#include "check.h"
+#include "philox.h"
+#include "rank_context.h"
+#include "utils.h"
+
+static size_t make_configuration(uint8_t* configuration, size_t* hist, size_t species) {
+    size_t atoms = 0;
+    for (size_t j = 0; j < species; j++) {
+        for (size_t i = 0; i < hist[j]; i++) {
+            configuration[atoms++] = (uint8_t) j;
+        }
+    }
+    return atoms;
+}
+
+/* Every configuration of a small composition is visited in lexicographical order, its rank is its position */
+static void check_enumeration(size_t* hist, size_t species) {
+    uint8_t configuration[64], other[64];
+    size_t atoms = make_configuration(configuration, hist, species);
+    rank_context_t* ctx = rank_context_init(atoms, hist, species);
+    mpz_t rank, expected, count;
+
+    mpz_inits(rank, expected, count, NULL);
+    mpz_set_ui(expected, 1);
+    do {
+        rank_context_rank_mpz(ctx, rank, configuration);
+        CHECK(mpz_cmp(rank, expected) == 0);
+        CHECK(rank_permutation(configuration, atoms, species) == mpz_get_ui(expected));
+        memset(other, 0xFF, atoms);
+        rank_context_unrank_mpz(ctx, other, rank);
+        CHECK(memcmp(other, configuration, atoms) == 0);
+        mpz_add_ui(expected, expected, 1);
+    } while (next_permutation_lex(configuration, atoms));
+    rank_context_count_mpz(ctx, count);
+    mpz_sub_ui(expected, expected, 1);
+    CHECK(mpz_cmp(count, expected) == 0);
+    mpz_clears(rank, expected, count, NULL);
+    rank_context_destroy(ctx);
+}
+
+/* Random configurations of a large composition, the tables agree with the direct multinomial sums */
+static void check_round_trip(size_t* hist, size_t species, size_t samples) {
+    uint8_t configuration[256], other[256];
+    size_t atoms = make_configuration(configuration, hist, species);
+    rank_context_t* ctx = rank_context_init(atoms, hist, species);
+    philox_t rng;
+    mpz_t rank, direct;
+
+    CHECK(ctx->table || ctx->table_mpz);
+    mpz_inits(rank, direct, NULL);
+    philox_init(&rng, 42, 0);
+    for (size_t s = 0; s < samples; s++) {
+        knuth_fisher_yates_shuffle(&rng, configuration, atoms);
+        rank_context_rank_mpz(ctx, rank, configuration);
+        rank_permutation_mpz(direct, configuration, atoms, species);
+        CHECK(mpz_cmp(rank, direct) == 0);
+        rank_context_unrank_mpz(ctx, other, rank);
+        CHECK(memcmp(other, configuration, atoms) == 0);
+    }
+    mpz_clears(rank, direct, NULL);
+    rank_context_destroy(ctx);
+}
+
+/*
+ * The chunks start at consecutive ranks without gaps or overlaps, their sizes differ by at most one and the last one
+ * ends at the number of configurations. A chunk reports its size unless it exceeds 64 bits
+ */
+static void check_partition(size_t* hist, size_t species, uint64_t chunks, int min_bits) {
+    uint8_t configuration[256];
+    size_t atoms = make_configuration(configuration, hist, species);
+    rank_context_t* ctx = rank_context_init(atoms, hist, species);
+    uint64_t lengths[chunks];
+    mpz_t starts[chunks + 1], size, smallest, largest, count;
+
+    mpz_inits(size, smallest, largest, count, NULL);
+    rank_context_count_mpz(ctx, count);
+    CHECK(mpz_sizeinbase(count, 2) > (size_t) min_bits);
+    for (uint64_t i = 0; i < chunks; i++) {
+        mpz_init(starts[i]);
+        lengths[i] = rank_context_partition(ctx, configuration, i, chunks);
+        rank_context_rank_mpz(ctx, starts[i], configuration);
+    }
+    mpz_init_set(starts[chunks], count);
+    mpz_add_ui(starts[chunks], starts[chunks], 1);
+
+    CHECK(mpz_cmp_ui(starts[0], 1) == 0);
+    for (uint64_t i = 0; i < chunks; i++) {
+        mpz_sub(size, starts[i + 1], starts[i]);
+        CHECK(mpz_sgn(size) > 0);
+        CHECK(mpz_sizeinbase(size, 2) > 64 ? lengths[i] == UINT64_MAX : lengths[i] == mpz_get_ui(size));
+        if (i == 0 || mpz_cmp(size, smallest) < 0) {
+            mpz_set(smallest, size);
+        }
+        if (i == 0 || mpz_cmp(size, largest) > 0) {
+            mpz_set(largest, size);
+        }
+    }
+    mpz_sub(size, largest, smallest);
+    CHECK(mpz_cmp_ui(size, 1) <= 0);
+
+    for (uint64_t i = 0; i <= chunks; i++) {
+        mpz_clear(starts[i]);
+    }
+    mpz_clears(size, smallest, largest, count, NULL);
+    rank_context_destroy(ctx);
+}
+
+int main(void) {
+    size_t binary[] = {4, 4}, ternary[] = {3, 2, 3}, quaternary[] = {2, 1, 2, 2};
+    size_t medium[] = {16, 16, 16}, large[] = {30, 30, 30}, skewed[] = {100, 1, 27};
+
+    check_enumeration(binary, 2);
+    check_enumeration(ternary, 3);
+    check_enumeration(quaternary, 4);
+
+    /* 2^70 configurations use the 128 bit table, 2^136 the GMP one */
+    check_round_trip(medium, 3, 200);
+    check_round_trip(large, 3, 200);
+    check_round_trip(skewed, 3, 200);
+
+    check_partition(binary, 2, 7, 0);
+    check_partition(medium, 3, 1000, 64);
+    check_partition(large, 3, 1000, 128);
+    check_partition(large, 3, 3, 128);
+
+    return CHECK_RESULT();
+}
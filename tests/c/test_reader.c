@@ -0,0 +1,115 @@
+#include <math.h>
+#include <string.h>
+#include "check.h"
+#include "reader.h"
+
+#define TOLERANCE 1e-9
+
+static char path[4096];
+
+/* The fixtures are in the directory passed as the first argument */
+static const char* fixture(const char* directory, const char* name) {
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    return path;
+}
+
+static void check_sites(reader_structure_t* s, const double* frac_coords, const uint8_t* species) {
+    for (size_t i = 0; i < s->atoms; i++) {
+        for (size_t k = 0; k < 3; k++) {
+            CHECK(fabs(s->frac_coords[3 * i + k] - frac_coords[3 * i + k]) < TOLERANCE);
+        }
+        CHECK(s->site_species[i] == species[i]);
+    }
+}
+
+static void check_diagonal(reader_structure_t* s, double length) {
+    for (size_t k = 0; k < 9; k++) {
+        CHECK(fabs(s->lattice[k] - (k % 4 == 0 ? length : 0.0)) < TOLERANCE);
+    }
+}
+
+/* VASP 5 with potential suffixes, a volume as scale, selective dynamics and Cartesian coordinates */
+static void check_poscar(const char* directory) {
+    const double frac_coords[12] = {0.0, 0.0, 0.0, 0.5, 0.5, 0.0, 0.5, 0.0, 0.0, 0.0, 0.5, 0.0};
+    const uint8_t species[4] = {0, 0, 1, 1};
+    reader_structure_t* s = reader_read_poscar(fixture(directory, "POSCAR_TiN"));
+
+    CHECK(s != NULL);
+    if (s) {
+        CHECK(s->atoms == 4 && s->species == 2);
+        CHECK(strcmp(s->symbols[0], "Ti") == 0 && strcmp(s->symbols[1], "N") == 0);
+        check_diagonal(s, 4.0 * cbrt(71.0 / 64.0));
+        check_sites(s, frac_coords, species);
+        reader_structure_destroy(s);
+    }
+}
+
+/* VASP 4 takes the species from the comment line, whatever its words are */
+static void check_vasp4(const char* directory) {
+    const double frac_coords[6] = {0.0, 0.0, 0.0, 0.5, 0.5, 0.5};
+    const double fcc[12] = {0.0, 0.0, 0.0, 0.0, 0.5, 0.5, 0.5, 0.0, 0.5, 0.5, 0.5, 0.0};
+    const uint8_t species[2] = {0, 1}, aluminum[4] = {0, 0, 0, 0};
+    reader_structure_t* s = reader_read_poscar(fixture(directory, "POSCAR_vasp4"));
+
+    CHECK(s != NULL);
+    if (s) {
+        CHECK(s->atoms == 2 && s->species == 2);
+        CHECK(strcmp(s->symbols[0], "Ti") == 0 && strcmp(s->symbols[1], "N") == 0);
+        check_diagonal(s, 3.0);
+        check_sites(s, frac_coords, species);
+        reader_structure_destroy(s);
+    }
+    s = reader_read_poscar(fixture(directory, "POSCAR_comment"));
+    CHECK(s != NULL);
+    if (s) {
+        CHECK(s->atoms == 4 && s->species == 1);
+        CHECK(strcmp(s->symbols[0], "fcc") == 0);
+        check_diagonal(s, 3.6);
+        check_sites(s, fcc, aluminum);
+        reader_structure_destroy(s);
+    }
+}
+
+/* The lattice and the species and positions columns of an extended XYZ file, other columns are skipped. The keys of
+ * the comment line are matched regardless of their case, but only as whole keys */
+static void check_xyz(const char* directory) {
+    const double frac_coords[9] = {0.0, 0.0, 0.0, 0.5, 0.5, 0.5, 0.25, 0.0, 0.0};
+    const uint8_t species[3] = {0, 1, 0};
+    const char* names[2] = {"FeNi.xyz", "FeNi_lowercase.xyz"};
+    reader_structure_t* s;
+
+    for (size_t i = 0; i < 2; i++) {
+        s = reader_read_xyz(fixture(directory, names[i]));
+        CHECK(s != NULL);
+        if (s) {
+            CHECK(s->atoms == 3 && s->species == 2);
+            CHECK(strcmp(s->symbols[0], "Fe") == 0 && strcmp(s->symbols[1], "Ni") == 0);
+            check_diagonal(s, 4.0);
+            check_sites(s, frac_coords, species);
+            reader_structure_destroy(s);
+        }
+    }
+    /* A POSCAR is no extended XYZ file and vice versa */
+    CHECK(reader_read_xyz(fixture(directory, "POSCAR_TiN")) == NULL);
+    CHECK(reader_read_poscar(fixture(directory, "FeNi.xyz")) == NULL);
+    CHECK(reader_read_poscar(fixture(directory, "missing")) == NULL);
+}
+
+/* Site s of translation (a, b, c) is s * cells + (a*m1+b)*m2+c */
+static void check_expand(void) {
+    double frac_coords[6] = {0.0, 0.0, 0.0, 0.5, 0.5, 0.5}, result[3 * 2 * 4];
+    size_t multiples[3] = {2, 1, 2};
+
+    reader_expand(frac_coords, 2, multiples, result);
+    CHECK(result[3 * 3] == 0.5 && result[3 * 3 + 1] == 0.0 && result[3 * 3 + 2] == 0.5);
+    CHECK(result[3 * 5] == 0.25 && result[3 * 5 + 1] == 0.5 && result[3 * 5 + 2] == 0.75);
+}
+
+int main(int argc, char** argv) {
+    const char* directory = argc > 1 ? argv[1] : "tests/data";
+    check_poscar(directory);
+    check_vasp4(directory);
+    check_xyz(directory);
+    check_expand();
+    return CHECK_RESULT();
+}
@@ -0,0 +1,48 @@
+import numpy as np
+import pytest
+from sqsgenerator.core.reader import Cell
+from sqsgenerator.core.sqs import SqsIterator, ParallelSqsIterator
+
+# A 2x1x1 supercell of the conventional fcc cell with two species, small enough to enumerate all 70 configurations
+FCC = [[0.0, 0.0, 0.0], [0.0, 0.5, 0.5], [0.5, 0.0, 0.5], [0.5, 0.5, 0.0]]
+MOLE_FRACTIONS = {'Al': 0.5, 'Ni': 0.5}
+WEIGHTS = {1: 1.0, 2: 0.5}
+CONFIGURATIONS = 70
+
+
+def make_cell():
+    unit = Cell(np.eye(3) * 3.6, FCC, [0, 1, 0, 1], ['Al', 'Ni'])
+    return unit.supercell((2, 1, 1))
+
+
+def enumerate_all(cls, low_memory, **kwargs):
+    # Ranking all configurations keeps every one of them, keyed by the configuration
+    iterator = cls(make_cell(), dict(MOLE_FRACTIONS), dict(WEIGHTS), low_memory=low_memory, **kwargs)
+    _, decompositions, _, _ = iterator.iteration(iterations='all', output_structures=CONFIGURATIONS, ranked=True)
+    snapshot = iterator.snapshot()
+    assert len(snapshot) == len(decompositions) == CONFIGURATIONS
+    return {tuple(snapshot.configuration(i)): (snapshot.objective(i), decompositions[i]) for i in range(len(snapshot))}
+
+
+@pytest.mark.parametrize('cls, kwargs', [(SqsIterator, {}), (ParallelSqsIterator, dict(num_threads=2))])
+def test_binary_engine(cls, kwargs):
+    # The bitmask engine is skipped in the low memory mode, there every configuration goes through calculate_parameter
+    engine, generic = enumerate_all(cls, False, **kwargs), enumerate_all(cls, True, **kwargs)
+    assert engine.keys() == generic.keys()
+    for configuration, (objective, decomposition) in engine.items():
+        generic_objective, generic_decomposition = generic[configuration]
+        assert objective == pytest.approx(generic_objective, abs=1e-12)
+        assert decomposition.keys() == generic_decomposition.keys()
+        for key in decomposition:
+            np.testing.assert_allclose(decomposition[key], generic_decomposition[key], rtol=1e-12, atol=1e-12)
+
+
+def test_calculate_alpha():
+    # calculate_alpha evaluates the configuration of the cell with the dense generic kernel
+    iterator = SqsIterator(make_cell(), dict(MOLE_FRACTIONS), dict(WEIGHTS))
+    structures, decompositions, _, _ = iterator.iteration(iterations='all', output_structures=CONFIGURATIONS, ranked=True)
+    for structure, decomposition in zip(structures, decompositions):
+        generic = SqsIterator(structure, dict(MOLE_FRACTIONS), dict(WEIGHTS)).calculate_alpha()
+        assert decomposition.keys() == generic.keys()
+        for key in decomposition:
+            np.testing.assert_allclose(decomposition[key], generic[key], rtol=1e-12, atol=1e-12)
@@ -0,0 +1,53 @@
+import os
+import numpy as np
+import pytest
+from pymatgen import Structure
+from sqsgenerator.core.base import Geometry, make_supercell
+
+FCC = [[0.0, 0.0, 0.0], [0.0, 0.5, 0.5], [0.5, 0.0, 0.5], [0.5, 0.5, 0.0]]
+MULTIPLES = (2, 2, 2)
+SHELLS = 3
+
+
+def make_structure():
+    return make_supercell(Structure(np.eye(3) * 3.6, ['Al', 'Ni', 'Al', 'Ni'], FCC), MULTIPLES)
+
+
+def assert_geometries_equal(built, loaded):
+    assert built.shell_distances == loaded.shell_distances
+    assert built.shell_neighbors == loaded.shell_neighbors
+    np.testing.assert_array_equal(built.shell_numbers, loaded.shell_numbers)
+    np.testing.assert_array_equal(built.site_shell_neighbors, loaded.site_shell_neighbors)
+    np.testing.assert_array_equal(built.site_order, loaded.site_order)
+
+
+@pytest.mark.parametrize('options', [{}, dict(supercell=MULTIPLES), dict(reorder=True), dict(low_memory=True)])
+def test_cache_round_trip(tmp_path, options):
+    structure = make_structure()
+    reference = Geometry(structure, SHELLS, **options)
+    built = Geometry(structure, SHELLS, cache=str(tmp_path), **options)
+    assert built.path is not None and os.path.isfile(built.path)
+    loaded = Geometry(structure, SHELLS, cache=str(tmp_path), **options)
+    assert loaded.path == built.path
+    assert_geometries_equal(reference, built)
+    assert_geometries_equal(reference, loaded)
+    assert loaded.describes(structure, SHELLS)
+
+
+def test_cache_keys(tmp_path):
+    # Another shell count, a supercell mapping or the low memory layout is another file
+    structure = make_structure()
+    paths = {Geometry(structure, shells, cache=str(tmp_path), supercell=supercell, low_memory=low_memory).path
+             for shells in (2, 3) for supercell in (None, MULTIPLES) for low_memory in (False, True)}
+    assert len(paths) == 8
+
+
+def test_cache_invalid(tmp_path):
+    # A truncated file is not used, the geometry is built and stored again
+    structure = make_structure()
+    reference = Geometry(structure, SHELLS, cache=str(tmp_path))
+    with open(reference.path, 'r+b') as stream:
+        stream.truncate(64)
+    rebuilt = Geometry(structure, SHELLS, cache=str(tmp_path))
+    assert_geometries_equal(reference, rebuilt)
+    assert os.path.getsize(rebuilt.path) > 64
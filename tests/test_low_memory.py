@@ -0,0 +1,52 @@
+import numpy as np
+import pytest
+from sqsgenerator.core.reader import Cell
+from sqsgenerator.core.sqs import SqsIterator
+from sqsgenerator.core.dosqs import DosqsIterator
+
+# A 2x2x2 supercell of the conventional fcc cell with three species, so that the binary engine stays off
+FCC = [[0.0, 0.0, 0.0], [0.0, 0.5, 0.5], [0.5, 0.0, 0.5], [0.5, 0.5, 0.0]]
+MOLE_FRACTIONS = {'Al': 0.5, 'Ni': 0.25, 'Cu': 0.25}
+WEIGHTS = {1: 1.0, 2: 0.5, 3: 0.25}
+SEED = 12345
+
+
+def make_cell():
+    unit = Cell(np.eye(3) * 3.6, FCC, [0, 1, 2, 0], ['Al', 'Ni', 'Cu'])
+    return unit.supercell((2, 2, 2))
+
+
+def assert_decompositions_equal(dense, sparse):
+    if isinstance(dense, dict):
+        assert dense.keys() == sparse.keys()
+        for key in dense:
+            assert_decompositions_equal(dense[key], sparse[key])
+    else:
+        np.testing.assert_allclose(np.asarray(dense), np.asarray(sparse), rtol=1e-12, atol=1e-12)
+
+
+def make_iterators(cls):
+    cell = make_cell()
+    return tuple(cls(cell, dict(MOLE_FRACTIONS), dict(WEIGHTS), seed=SEED, low_memory=flag) for flag in (False, True))
+
+
+def test_sqs_calculate_alpha():
+    dense, sparse = make_iterators(SqsIterator)
+    assert not dense.low_memory and sparse.low_memory
+    assert_decompositions_equal(dense.calculate_alpha(), sparse.calculate_alpha())
+
+
+def test_dosqs_calculate_alpha():
+    dense, sparse = make_iterators(DosqsIterator)
+    assert_decompositions_equal(dense.calculate_alpha(1.0, [1.0, 1.0]), sparse.calculate_alpha(1.0, [1.0, 1.0]))
+
+
+@pytest.mark.parametrize('cls, args', [(SqsIterator, ()), (DosqsIterator, (1.0, [1.0, 1.0]))])
+def test_iteration(cls, args):
+    # The same seed draws the same configurations, both kernels have to rank them the same
+    dense, sparse = make_iterators(cls)
+    _, dense_decompositions, _, _ = dense.iteration(*args, iterations=200, output_structures=5)
+    _, sparse_decompositions, _, _ = sparse.iteration(*args, iterations=200, output_structures=5)
+    assert len(dense_decompositions) == len(sparse_decompositions)
+    for d, s in zip(dense_decompositions, sparse_decompositions):
+        assert_decompositions_equal(d, s)
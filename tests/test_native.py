@@ -0,0 +1,41 @@
+import os
+import shlex
+import shutil
+import subprocess
+import sysconfig
+import pytest
+
+# The C modules are tested directly, each test program is built from the sources it needs
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CORE = os.path.join(ROOT, 'sqsgenerator', 'core')
+TESTS = os.path.join(ROOT, 'tests', 'c')
+DATA = os.path.join(ROOT, 'tests', 'data')
+
+PROGRAMS = {
+    'test_rank': ['rank.c', 'rank_context.c', 'utils.c', 'philox.c'],
+    'test_conf_hash': ['conf_hash.c', 'utils.c', 'philox.c'],
+    'test_conf_counter': ['conf_counter.c', 'conf_snapshot.c'],
+    'test_conf_heap': ['conf_heap.c', 'conf_hash.c', 'conf_snapshot.c', 'rank.c', 'utils.c', 'philox.c'],
+    'test_philox': ['philox.c'],
+    'test_neighbors': ['neighbors.c', 'philox.c'],
+    'test_reader': ['reader.c'],
+}
+
+
+def compiler():
+    command = shlex.split(sysconfig.get_config_var('CC') or 'cc')
+    return command if shutil.which(command[0]) else None
+
+
+@pytest.mark.parametrize('name', sorted(PROGRAMS))
+def test_native(name, tmp_path):
+    cc = compiler()
+    if cc is None:
+        pytest.skip('no C compiler')
+    executable = str(tmp_path / name)
+    sources = [os.path.join(TESTS, name + '.c')] + [os.path.join(CORE, 'src', source) for source in PROGRAMS[name]]
+    build = subprocess.run(cc + ['-std=c1x', '-O1', '-I' + os.path.join(CORE, 'include'), '-I' + TESTS, '-o', executable]
+                           + sources + ['-lgmp', '-lm'], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    assert build.returncode == 0, build.stdout.decode()
+    run = subprocess.run([executable, DATA], stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+    assert run.returncode == 0, run.stdout.decode()
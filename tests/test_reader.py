@@ -0,0 +1,52 @@
+import os
+import numpy as np
+import pytest
+from sqsgenerator.core.reader import Cell, read_structure
+
+DATA = os.path.join(os.path.dirname(os.path.abspath(__file__)), 'data')
+
+
+def fixture(name):
+    return os.path.join(DATA, name)
+
+
+def test_poscar():
+    # VASP 5 with potential suffixes, a volume as scale, selective dynamics and Cartesian coordinates
+    cell = read_structure(fixture('POSCAR_TiN'))
+    assert isinstance(cell, Cell)
+    assert cell.symbols == ('Ti', 'N')
+    assert cell.site_symbols == ['Ti', 'Ti', 'N', 'N']
+    np.testing.assert_allclose(cell.lattice, np.eye(3) * 4.0 * np.cbrt(71.0 / 64.0), atol=1e-9)
+    np.testing.assert_allclose(cell.frac_coords, [[0.0, 0.0, 0.0], [0.5, 0.5, 0.0], [0.5, 0.0, 0.0], [0.0, 0.5, 0.0]], atol=1e-9)
+
+
+def test_vasp4():
+    cell = read_structure(fixture('POSCAR_vasp4'))
+    assert cell.symbols == ('Ti', 'N')
+    np.testing.assert_allclose(cell.lattice, np.eye(3) * 3.0, atol=1e-9)
+    np.testing.assert_allclose(cell.frac_coords, [[0.0, 0.0, 0.0], [0.5, 0.5, 0.5]], atol=1e-9)
+
+
+@pytest.mark.parametrize('name', ['FeNi.xyz', 'FeNi_lowercase.xyz'])
+def test_xyz(name):
+    # The keys of the comment line may be written in any case
+    cell = read_structure(fixture(name))
+    assert cell.site_symbols == ['Fe', 'Ni', 'Fe']
+    np.testing.assert_allclose(cell.frac_coords, [[0.0, 0.0, 0.0], [0.5, 0.5, 0.5], [0.25, 0.0, 0.0]], atol=1e-9)
+
+
+@pytest.mark.parametrize('name', ['POSCAR_comment', 'missing', 'structure.cif'])
+def test_not_read(name):
+    # A comment line which lists no elements, a missing file and a format left to pymatgen
+    assert read_structure(fixture(name)) is None
+
+
+def test_supercell_order():
+    # Site s of translation (a, b, c) is s * cells + (a*m1+b)*m2+c
+    unit = read_structure(fixture('POSCAR_vasp4'))
+    cell = unit.supercell((2, 1, 2))
+    assert len(cell) == 8
+    assert cell.site_symbols == ['Ti'] * 4 + ['N'] * 4
+    np.testing.assert_allclose(cell.frac_coords[3], [0.5, 0.0, 0.5])
+    np.testing.assert_allclose(cell.frac_coords[5], [0.25, 0.5, 0.75])
+    np.testing.assert_allclose(cell.lattice, np.diag([6.0, 3.0, 6.0]))
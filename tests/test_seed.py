@@ -0,0 +1,71 @@
+import numpy as np
+import pytest
+from pymatgen import Structure
+from sqsgenerator.core.sqs import SqsIterator, ParallelSqsIterator
+from sqsgenerator.core.dosqs import DosqsIterator, ParallelDosqsIterator
+
+FCC = [[0.0, 0.0, 0.0], [0.0, 0.5, 0.5], [0.5, 0.0, 0.5], [0.5, 0.5, 0.0]]
+MOLE_FRACTIONS = {'Al': 0.5, 'Ni': 0.25, 'Cu': 0.25}
+WEIGHTS = {1: 1.0, 2: 0.5}
+DOSQS_ARGS = (1.0, [1.0, 1.0])
+OUTPUT = 5
+
+
+def make_structure():
+    structure = Structure(np.eye(3) * 3.6, ['Al', 'Ni', 'Cu', 'Al'], FCC)
+    structure.make_supercell([2, 2, 2])
+    return structure
+
+
+def run(cls, args, seed, **kwargs):
+    # A ranked run keeps the OUTPUT best configurations, not only the ties of the best one
+    iterator = cls(make_structure(), dict(MOLE_FRACTIONS), dict(WEIGHTS), seed=seed, **kwargs)
+    structures, decompositions, _, _ = iterator.iteration(*args, iterations=300, output_structures=OUTPUT, ranked=True)
+    assert len(structures) == OUTPUT
+    return iterator, [[site.species_string for site in structure] for structure in structures], decompositions
+
+
+def assert_results_equal(first, second):
+    if isinstance(first, dict):
+        assert first.keys() == second.keys()
+        for key in first:
+            assert_results_equal(first[key], second[key])
+    elif isinstance(first, (list, tuple)):
+        assert len(first) == len(second)
+        for a, b in zip(first, second):
+            assert_results_equal(a, b)
+    else:
+        np.testing.assert_array_equal(np.asarray(first), np.asarray(second))
+
+
+ITERATORS = [(SqsIterator, (), {}), (DosqsIterator, DOSQS_ARGS, {}),
+             (ParallelSqsIterator, (), dict(num_threads=2)), (ParallelDosqsIterator, DOSQS_ARGS, dict(num_threads=2))]
+
+
+@pytest.mark.parametrize('cls, args, kwargs', ITERATORS)
+def test_same_seed(cls, args, kwargs):
+    # Every chunk draws from its own stream of the seed, a run is reproduced
+    first, first_species, first_decompositions = run(cls, args, 12345, **kwargs)
+    second, second_species, second_decompositions = run(cls, args, 12345, **kwargs)
+    assert first.seed == second.seed == 12345
+    assert_results_equal(first_species, second_species)
+    assert_results_equal(first_decompositions, second_decompositions)
+
+
+def test_seed_is_kept():
+    # Without a seed one is drawn, passing it back reproduces the run
+    first, species, decompositions = run(SqsIterator, (), None)
+    _, again_species, again_decompositions = run(SqsIterator, (), first.seed)
+    assert_results_equal(species, again_species)
+    assert_results_equal(decompositions, again_decompositions)
+
+
+@pytest.mark.parametrize('serial, parallel, args', [(SqsIterator, ParallelSqsIterator, ()),
+                                                    (DosqsIterator, ParallelDosqsIterator, DOSQS_ARGS)])
+def test_thread_count(serial, parallel, args):
+    # The random chunks and thus the streams do not depend on the number of threads, all runs draw the same configurations
+    _, species, decompositions = run(serial, args, 12345)
+    for threads in (1, 2, 3):
+        _, parallel_species, parallel_decompositions = run(parallel, args, 12345, num_threads=threads)
+        assert_results_equal(species, parallel_species)
+        assert_results_equal(decompositions, parallel_decompositions)
@@ -0,0 +1,45 @@
+import numpy as np
+import pytest
+from pymatgen import Structure
+from sqsgenerator.core.sqs import SqsIterator, ParallelSqsIterator
+
+FCC = [[0.0, 0.0, 0.0], [0.0, 0.5, 0.5], [0.5, 0.0, 0.5], [0.5, 0.5, 0.0]]
+MOLE_FRACTIONS = {'Al': 0.5, 'Ni': 0.25, 'Cu': 0.25}
+WEIGHTS = {1: 1.0, 2: 0.5}
+OUTPUT = 5
+
+
+def make_iterator(cls, multiples=(2, 2, 2), **kwargs):
+    structure = Structure(np.eye(3) * 3.6, ['Al', 'Ni', 'Cu', 'Al'], FCC)
+    structure.make_supercell(list(multiples))
+    return cls(structure, dict(MOLE_FRACTIONS), dict(WEIGHTS), seed=12345, **kwargs)
+
+
+def read(snapshot):
+    return [(snapshot.objective(i), snapshot.configuration(i)) for i in range(len(snapshot))]
+
+
+@pytest.mark.parametrize('cls, kwargs', [(SqsIterator, {}), (ParallelSqsIterator, dict(num_threads=2))])
+def test_ranked_snapshot(cls, kwargs):
+    # The heaps of a ranked run are combined into a snapshot sorted like the results, it is shared until they change
+    iterator = make_iterator(cls, **kwargs)
+    assert iterator.snapshot() is None
+    iterator.iteration(iterations=300, output_structures=OUTPUT, ranked=True)
+    first, second = iterator.snapshot(), iterator.snapshot()
+    assert len(first) == OUTPUT
+    assert first.version == second.version
+    entries = read(first)
+    assert [objective for objective, _ in entries] == sorted(objective for objective, _ in entries)
+    assert first.best_objective == entries[0][0]
+
+
+@pytest.mark.parametrize('cls, kwargs', [(SqsIterator, {}), (ParallelSqsIterator, dict(num_threads=2))])
+def test_degeneracy_snapshot(cls, kwargs):
+    # The samples of the counters all attain the best objective, the count is not part of the snapshot. The unit cell
+    # keeps the exhaustive enumeration short
+    iterator = make_iterator(cls, multiples=(1, 1, 1), **kwargs)
+    iterator.iteration(iterations='all', output_structures=OUTPUT, degeneracy=True)
+    entries = read(iterator.snapshot())
+    assert 0 < len(entries) <= OUTPUT
+    assert len({objective for objective, _ in entries}) == 1
+    assert [configuration for _, configuration in entries] == sorted(configuration for _, configuration in entries)